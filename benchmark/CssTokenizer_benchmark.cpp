@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <less/css/SourceBuffer.h>
+#include <less/less/LessTokenizer.h>
+
+/**
+ * Measures tokenizer throughput on a large stylesheet. The stylesheet
+ * is read from the file given as the first argument, or generated when
+ * no argument is given.
+ *
+ * Usage: benchlessc [FILE] [ITERATIONS]
+ */
+
+using namespace std;
+
+static const char *generated_file = "benchlessc_input.less";
+
+void generate(const char *filename, size_t size) {
+  ofstream out(filename);
+  size_t written = 0;
+  ostringstream block;
+
+  for (int i = 0; i < 100; i++) {
+    block << "/* Component " << i
+          << " ------------------------------------------------------ */\n"
+          << ".component-" << i << " .header > .title:hover,\n"
+          << ".component-" << i << " .header > .subtitle {\n"
+          << "  font: 12px/1.5 \"Helvetica Neue\", Arial, sans-serif;\n"
+          << "  margin: 0 auto " << i << "px -" << i << ".5em;\n"
+          << "  background: url(\"../img/sprite.png\") no-repeat #f0f0f0;\n"
+          << "  // less comment\n"
+          << "  width: (@grid-width / 12) * " << (i % 12) << ";\n"
+          << "}\n";
+  }
+
+  while (written < size) {
+    out << block.str();
+    written += block.str().size();
+  }
+}
+
+size_t tokenize(CssTokenizer &tokenizer) {
+  size_t n = 0;
+  while (tokenizer.readNextToken() != Token::EOS)
+    n++;
+  return n;
+}
+
+double seconds(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  const char *filename = generated_file;
+  int iterations = 5;
+  size_t bytes, tokens = 0;
+  double t_stream = 0, t_buffer = 0;
+  chrono::steady_clock::time_point start;
+
+  if (argc > 1)
+    filename = argv[1];
+  else
+    generate(filename, 4 * 1024 * 1024);
+  if (argc > 2)
+    iterations = atoi(argv[2]);
+
+  if (!SourceBuffer().open(filename)) {
+    cerr << "Error opening file." << endl;
+    return EXIT_FAILURE;
+  }
+
+  for (int i = 0; i < iterations; i++) {
+    start = chrono::steady_clock::now();
+    ifstream in(filename);
+    LessTokenizer t1(in, filename);
+    tokens = tokenize(t1);
+    t_stream += seconds(start);
+
+    start = chrono::steady_clock::now();
+    SourceBuffer *buffer = new SourceBuffer();
+    buffer->open(filename);
+    bytes = buffer->getSize();
+    LessTokenizer t2(buffer, filename);
+    tokenize(t2);
+    t_buffer += seconds(start);
+  }
+
+  cout << filename << ": " << bytes << " bytes, " << tokens << " tokens"
+       << endl;
+  cout << "istream:      " << (bytes * iterations / t_stream / 1e6) << " MB/s"
+       << endl;
+  cout << "SourceBuffer: " << (bytes * iterations / t_buffer / 1e6) << " MB/s"
+       << endl;
+
+  if (filename == generated_file)
+    remove(generated_file);
+  return EXIT_SUCCESS;
+}
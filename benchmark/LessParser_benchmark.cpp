@@ -0,0 +1,115 @@
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <less/SourceSet.h>
+#include <less/css/SourceBuffer.h>
+#include <less/less/LessParser.h>
+#include <less/less/LessTokenizer.h>
+
+/**
+ * Measures parser throughput and peak memory on a large stylesheet.
+ * The stylesheet is the file given as the first argument repeated
+ * COPIES times, example/less/test.less by default. The copy is written
+ * next to the file, so its imports are found. The time is the processor
+ * time of the fastest iteration, which is the least affected by other
+ * processes.
+ *
+ * Usage: benchlessparser [FILE] [COPIES] [ITERATIONS]
+ */
+
+using namespace std;
+
+bool generate(const char *source, int copies, string &filename) {
+  ifstream in(source);
+  ostringstream content;
+  string path = source;
+  size_t pos = path.find_last_of("/\\");
+
+  if (!in)
+    return false;
+  content << in.rdbuf();
+
+  filename = (pos == string::npos ? "" : path.substr(0, pos + 1)) +
+             "benchlessparser_input.less";
+  ofstream out(filename.c_str());
+  for (int i = 0; i < copies; i++)
+    out << content.str();
+  return true;
+}
+
+double seconds(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+long peakMemory() {
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+int main(int argc, char *argv[]) {
+  const char *source = "example/less/test.less";
+  int copies = 100, iterations = 5;
+  size_t bytes = 0, statements = 0;
+  double t_parse, t_best = 0;
+  long memory;
+  clock_t start;
+  std::list<const char *> includePaths;
+  string filename;
+
+  if (argc > 1)
+    source = argv[1];
+  if (argc > 2)
+    copies = atoi(argv[2]);
+  if (argc > 3)
+    iterations = atoi(argv[3]);
+
+  if (!generate(source, copies, filename)) {
+    cerr << "Error opening file." << endl;
+    return EXIT_FAILURE;
+  }
+  memory = peakMemory();
+
+  // Keep the parser's warnings out of the results.
+  ostringstream warnings;
+  streambuf *err = cerr.rdbuf(warnings.rdbuf());
+
+  for (int i = 0; i < iterations; i++) {
+    SourceBuffer *buffer = new SourceBuffer();
+    SourceSet sources;
+    LessStylesheet stylesheet;
+
+    buffer->open(filename.c_str());
+    bytes = buffer->getSize();
+
+    start = clock();
+    LessTokenizer tokenizer(buffer, filename.c_str());
+    LessParser parser(tokenizer, sources);
+    parser.includePaths = &includePaths;
+    parser.parseStylesheet(stylesheet);
+    t_parse = seconds(start);
+    if (t_best == 0 || t_parse < t_best)
+      t_best = t_parse;
+
+    statements = stylesheet.getStatements().size();
+  }
+  cerr.rdbuf(err);
+
+  cout << source << " x " << copies << ": " << bytes << " bytes, "
+       << statements << " statements" << endl;
+  cout << "parse:  " << (bytes / t_best / 1e6) << " MB/s (best of "
+       << iterations << ")"
+       << endl;
+  cout << "memory: " << (peakMemory() - memory) / 1024 << " MB" << endl;
+
+  remove(filename.c_str());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#ifndef __less_Arena_h__
+#define __less_Arena_h__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Monotonic memory for objects that live until the end of a
+ * compilation.
+ *
+ * Memory is handed out from large blocks by bumping a pointer and is
+ * never returned one object at a time. Objects made with create() are
+ * destroyed, newest first, when the arena is released or destroyed,
+ * together with all blocks.
+ */
+class Arena {
+public:
+  /**
+   * Size of the first block; each following block is twice as large.
+   */
+  static const size_t INITIAL_BLOCK_SIZE = 4096;
+
+  Arena();
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns size bytes aligned to alignment, which has to be a power
+   * of two.
+   */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * Constructs a T in the arena. Its destructor runs when the arena is
+   * released.
+   */
+  template <class T, class... Args>
+  T* create(Args&&... args) {
+    void* memory = allocate(sizeof(T), alignof(T));
+    T* object = new (memory) T(std::forward<Args>(args)...);
+
+    if (!std::is_trivially_destructible<T>::value)
+      addDestructor(&destroy<T>, object);
+    return object;
+  }
+
+  /**
+   * Destroys the objects and frees all memory. The arena can be used
+   * again afterwards.
+   */
+  void release();
+
+  /**
+   * Total size of the blocks that are currently allocated.
+   */
+  size_t getBytesAllocated() const;
+
+private:
+  struct Block {
+    Block* next;
+    size_t size;
+  };
+
+  struct Destructor {
+    void (*destroy)(void*);
+    void* object;
+    Destructor* next;
+  };
+
+  Block* blocks;
+  Destructor* destructors;
+  char* current;
+  char* limit;
+  size_t allocated;
+
+  void addBlock(size_t minimum);
+  void addDestructor(void (*destroy)(void*), void* object);
+
+  template <class T>
+  static void destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+};
+
+#endif  // __less_Arena_h__
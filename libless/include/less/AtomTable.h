@@ -0,0 +1,84 @@
+#ifndef __less_AtomTable_h__
+#define __less_AtomTable_h__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Interns the strings of identifiers, hashes and delimiters.
+ *
+ * Each distinct string gets a small id, its atom, so tokens can be
+ * compared and hashed by id instead of by their characters. Ids are
+ * dense and never reused; 0 means that a token has no atom.
+ *
+ * The table is split in shards by the hash of the string, each with its
+ * own lock, and strings are kept in blocks that are never moved, so
+ * getString() does not lock at all.
+ */
+class AtomTable {
+public:
+  static const unsigned int NONE = 0;
+
+  /**
+   * Number of atoms after which tokens stop adding strings to the
+   * table, see lookup().
+   */
+  static const size_t TOKEN_LIMIT = 1 << 20;
+
+  /**
+   * Returns the atom of str, adding it to the table the first time it
+   * is seen.
+   */
+  static unsigned int intern(const std::string& str);
+
+  /**
+   * Same as intern() until the table holds TOKEN_LIMIT strings. After
+   * that only strings that are already in the table have an atom, so
+   * strings that are generated while stylesheets are compiled can not
+   * grow the table forever; tokens without an atom are compared by
+   * their characters.
+   */
+  static unsigned int lookup(const std::string& str);
+
+  /**
+   * Returns the atom of str, or NONE if it has not been interned. No
+   * variable can have a name that is not in the table.
+   */
+  static unsigned int find(const std::string& str);
+
+  static const std::string& getString(unsigned int atom);
+
+  /**
+   * Number of atoms in the table, including NONE.
+   */
+  static size_t size();
+
+private:
+  static const size_t SHARDS = 16;
+  static const size_t BLOCK_SIZE = 4096;
+  static const size_t MAX_BLOCKS = 16384;
+
+  struct Shard {
+    std::unordered_map<std::string, unsigned int> atoms;
+    std::mutex mutex;
+  };
+
+  Shard shards[SHARDS];
+
+  /**
+   * The string of each atom, by id. Guarded by the mutex when a string
+   * is added.
+   */
+  const std::string** blocks[MAX_BLOCKS];
+  std::atomic<unsigned int> count;
+  std::mutex mutex;
+
+  AtomTable();
+  static AtomTable& getInstance();
+
+  unsigned int add(const std::string& str, bool limited);
+};
+
+#endif  // __less_AtomTable_h__
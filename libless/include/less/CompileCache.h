@@ -0,0 +1,72 @@
+#ifndef __less_CompileCache_h__
+#define __less_CompileCache_h__
+
+#include <ctime>
+#include <string>
+
+#include "less/SourceSet.h"
+#include "less/css/SourceBuffer.h"
+
+/**
+ * Keeps the output of whole compilations in a directory, in the manner
+ * of ccache.
+ *
+ * An entry is named by a hash of a key, which holds everything besides
+ * the content of the files that affects the output (options, working
+ * directory), and of the content of the compiled file. It records the
+ * key and the compiled file, so that an entry whose name collides with
+ * that of another compilation is not used, the CSS, the source map and
+ * the messages that were printed, and every other file the compilation
+ * read, with its size, modification time and a hash of its content.
+ *
+ * Before an entry is used, the recorded files are checked: a file with
+ * the recorded size and modification time is taken to be unchanged,
+ * any other file is read and hashed. Times are only recorded for files
+ * that were last modified before the compilation started. Files that
+ * an import might resolve to now but did not exist when the entry was
+ * stored are not noticed.
+ */
+class CompileCache {
+public:
+  static const unsigned int FORMAT_VERSION = 2;
+
+  /**
+   * The directory is created if it does not exist. content has to
+   * outlive the cache.
+   */
+  CompileCache(const std::string &directory,
+               const std::string &key,
+               const SourceBuffer &content);
+  virtual ~CompileCache();
+
+  /**
+   * Get the output of an earlier compilation.
+   *
+   * @return false if there is no entry, or one of its files has
+   *         changed.
+   */
+  bool load(std::string &css, std::string &sourcemap, std::string &messages);
+
+  /**
+   * Store the output of the compilation. The first file in sources is
+   * the compiled file; the others are recorded so that load() can check
+   * them. Failures to write are ignored.
+   */
+  void store(const SourceSet &sources,
+             const std::string &css,
+             const std::string &sourcemap,
+             const std::string &messages);
+
+  /**
+   * The file the entry is kept in.
+   */
+  const std::string &getEntry() const;
+
+private:
+  std::string entry;
+  std::string key;
+  const SourceBuffer &content;
+  time_t started;
+};
+
+#endif  // __less_CompileCache_h__
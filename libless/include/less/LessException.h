@@ -15,6 +15,12 @@ public:
                 std::string source);
   LessException(const Token& token);
 
+  /**
+   * Location of the character at offset in a source from the
+   * SourceRegistry.
+   */
+  LessException(unsigned int sourceId, unsigned int offset);
+
   ~LessException() throw(){};
 
   void setLocation(unsigned int line, unsigned int column);
@@ -0,0 +1,154 @@
+#ifndef __less_SourceRegistry_h__
+#define __less_SourceRegistry_h__
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "less/css/SourceBuffer.h"
+
+/**
+ * Keeps track of the sources that tokens are read from.
+ *
+ * Each source gets a small id, which tokens store together with the
+ * byte offset of their first character. The line and column of a token
+ * are only computed when they are needed, for an error message or a
+ * source map, by a binary search in an index of line starts. The index
+ * is built the first time a source is queried.
+ *
+ * Only registering a source and building its index take a lock; sources
+ * are never moved once registered and an index is not changed once it
+ * is published, so lookups can run on any thread without one.
+ *
+ * Tokens created by the library itself use the BUILTIN and GENERATED
+ * sources, which have no content.
+ */
+class SourceRegistry {
+public:
+  static const unsigned int BUILTIN = 0;
+  static const unsigned int GENERATED = 1;
+
+  /**
+   * Register a source. The name is not copied and has to outlive the
+   * tokens read from the source. The registry takes ownership of the
+   * content, which is kept until the source is released so that
+   * locations can still be looked up after parsing.
+   *
+   * @return the id of the new source.
+   */
+  static unsigned int add(const char* name, SourceBuffer* content);
+
+  /**
+   * Register a source whose content is not available, such as a file
+   * that was loaded from a snapshot, with the offsets of its line
+   * starts as getLines() returned them. Locations in the source are
+   * computed as if the content was there.
+   */
+  static unsigned int add(const char* name,
+                          const std::string& path,
+                          const std::vector<unsigned int>& lines);
+
+  /**
+   * Returns the id of a source without content, registering it the
+   * first time the name is seen. All tokens in a source without
+   * content are on line 0 and their column is their offset.
+   */
+  static unsigned int getId(const char* name);
+
+  static const char* getName(unsigned int id);
+
+  /**
+   * The canonical path of the source: an absolute path without symbolic
+   * links, '.' or '..' components. For sources that are not files,
+   * such as streams, this is the name.
+   */
+  static const std::string& getPath(unsigned int id);
+
+  /**
+   * Returns false for sources that were registered with getId().
+   */
+  static bool hasContent(unsigned int id);
+
+  /**
+   * The content of the source, or NULL if it has none.
+   */
+  static const SourceBuffer* getContent(unsigned int id);
+
+  /**
+   * Canonical form of a file name, see getPath().
+   */
+  static std::string canonicalPath(const char* filename);
+
+  /**
+   * Compute the zero based line and column of the character at offset.
+   * Only '\n' starts a new line, and a newline character is counted as
+   * part of the line it ends.
+   */
+  static void getLocation(unsigned int id,
+                          unsigned int offset,
+                          unsigned int& line,
+                          unsigned int& column);
+
+  /**
+   * Offset of the first character of every line after the first.
+   */
+  static void getLines(unsigned int id, std::vector<unsigned int>& lines);
+
+  /**
+   * Free the content and line index of a source once nothing is
+   * looked up in it anymore, see SourceSet::release(). The id stays
+   * valid: the source is left without content, so its tokens are
+   * reported on line 0. No other thread may use the source meanwhile.
+   */
+  static void release(unsigned int id);
+
+private:
+  struct Index {
+    /**
+     * Offset of the first character of every line after the first,
+     * for the first 'indexed' bytes of content.
+     */
+    std::vector<unsigned int> lines;
+    size_t indexed;
+  };
+
+  struct Source {
+    const char* name;
+    std::string path;
+    SourceBuffer* content;
+
+    std::atomic<const Index*> index;
+    /**
+     * Indexes of content that has grown since, which a lookup on
+     * another thread may still be reading.
+     */
+    std::vector<const Index*> replaced;
+  };
+
+  /**
+   * Sources are allocated in blocks that are never moved, so a source
+   * can be read while another is added.
+   */
+  static const size_t BLOCK_SIZE = 1024;
+  static const size_t MAX_BLOCKS = 65536;
+
+  Source* blocks[MAX_BLOCKS];
+  std::atomic<unsigned int> count;
+  std::map<std::string, unsigned int> names;
+  std::mutex mutex;
+
+  SourceRegistry();
+  static SourceRegistry& getInstance();
+
+  Source* get(unsigned int id);
+  unsigned int addSource(const char* name,
+                         const std::string& path,
+                         SourceBuffer* content,
+                         const Index* index = NULL);
+  const Index* getIndex(Source& source);
+};
+
+#endif  // __less_SourceRegistry_h__
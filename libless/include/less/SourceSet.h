@@ -0,0 +1,84 @@
+#ifndef __less_SourceSet_h__
+#define __less_SourceSet_h__
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "less/SourceRegistry.h"
+
+/**
+ * The files that make up one compilation, in the order they were
+ * parsed. Each file gets a dense index, which is what source maps refer
+ * to. Files are identified by their canonical path, so a file that is
+ * imported more than once, or through different relative paths, has a
+ * single index.
+ *
+ * Looking up a source id or a path takes constant time.
+ */
+class SourceSet {
+public:
+  SourceSet();
+  virtual ~SourceSet();
+
+  /**
+   * Add the file that a source from the SourceRegistry was read from.
+   *
+   * @return the index of the file.
+   */
+  size_t add(unsigned int sourceId);
+
+  /**
+   * Returns true if the file has been added, under any name that
+   * resolves to the same canonical path.
+   */
+  bool contains(const char* filename) const;
+
+  /**
+   * Same as contains() for a path that is already canonical.
+   */
+  bool containsPath(const std::string& path) const;
+
+  /**
+   * Index of the file that the source was read from, or size() if the
+   * source is not part of this compilation (generated tokens for
+   * example).
+   */
+  size_t indexOf(unsigned int sourceId) const;
+
+  size_t size() const;
+
+  /**
+   * Name of the file at index, as it was given to the tokenizer.
+   */
+  const char* getName(size_t index) const;
+
+  /**
+   * Id of the first source that was read from the file at index.
+   */
+  unsigned int getSourceId(size_t index) const;
+
+  /**
+   * Free the content of every source that was added from the
+   * SourceRegistry, once the compilation is done with them. Locations
+   * in those sources can not be looked up afterwards.
+   */
+  void release();
+
+private:
+  /**
+   * Source id of the first source read from each file.
+   */
+  std::vector<unsigned int> files;
+
+  std::unordered_map<std::string, size_t> paths;
+
+  /**
+   * File index + 1 of each source id, 0 if the source is not part of
+   * this compilation.
+   */
+  std::vector<size_t> indices;
+};
+
+#endif  // __less_SourceSet_h__
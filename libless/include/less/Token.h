@@ -2,12 +2,19 @@
 #define __less_Token_h__
 
 #include <string>
+#include <utility>
+#include "less/AtomTable.h"
+#include "less/SourceRegistry.h"
 
 class Token : public std::string {
 protected:
 public:
-  unsigned int line, column;
-  const char *source;
+  /**
+   * Byte offset of the token in its source, and the id of the source
+   * in the SourceRegistry. Use getLine(), getColumn() and getSource()
+   * to get the location in a readable form.
+   */
+  unsigned int offset, sourceId;
 
   enum Type {
     IDENTIFIER,
@@ -36,14 +43,42 @@ public:
   } type;
   //  std::string str;
 
+private:
+  /**
+   * Atom of the string, looked up the first time the token is compared.
+   * Every function of Token that can change the string resets it, so a
+   * token must not be changed through a std::string reference.
+   */
+  mutable unsigned int atom;
+
+public:
+
   static char BUILTIN_SOURCE[8];
   static const Token BUILTIN_SPACE, BUILTIN_COMMA, BUILTIN_PAREN_OPEN,
     BUILTIN_PAREN_CLOSED, BUILTIN_IMPORTANT;
 
   Token();
 
-  Token(unsigned int line, unsigned int column, const char *source);
+  /**
+   * Identifiers, hashes, at-keywords and delimiters are compared by
+   * atom. Values such as strings and numbers are compared by their
+   * characters.
+   */
+  static inline bool isAtomType(Type t) {
+    return t <= ATKEYWORD || t == HASH || (t >= COLON && t <= BRACE_CLOSED) ||
+           t == OTHER;
+  }
 
+  Token(const std::string &s,
+        Type t,
+        unsigned int sourceId,
+        unsigned int offset);
+
+  /**
+   * Create a token in a source without content, see
+   * SourceRegistry::getId(). Such a source has a single line, so only
+   * the column is kept.
+   */
   Token(const std::string &s,
         Type t,
         unsigned int line,
@@ -51,10 +86,18 @@ public:
         const char *source);
 
   /**
-   * Copy line, column and source from the reference token.
+   * Copy the location from the reference token.
    */
   void setLocation(const Token &ref);
 
+  unsigned int getLine() const;
+  unsigned int getColumn() const;
+
+  /**
+   * Name of the file (or stream) the token was read from.
+   */
+  const char *getSource() const;
+
   /**
    * Clear the characters in the token and set the type to OTHER.
    */
@@ -74,6 +117,8 @@ public:
    * Removes quotes from given parameter str.
    */
   void removeQuotes(std::string &str) const;
+  // A token would keep its atom; use removeQuotes() on the token.
+  void removeQuotes(Token &str) const = delete;
 
   /**
    * Returns the value from URL tokens with quotes removed.
@@ -82,23 +127,159 @@ public:
    */
   std::string getUrlString() const;
 
+  /**
+   * The atom of the string, see AtomTable, or AtomTable::NONE if the
+   * token type is not compared by atom or the table is full.
+   */
+  inline unsigned int getAtom() const {
+    if (atom == AtomTable::NONE && isAtomType(type))
+      atom = AtomTable::lookup(*this);
+    return atom;
+  }
+
+  /**
+   * Hash of the type and string. It does not use the atom: a token may
+   * get an atom only after it was hashed, when the AtomTable is full
+   * and the string is interned later, and equal tokens have to keep
+   * hashing the same.
+   */
+  size_t hash() const;
+
+  // The functions that change the string are wrapped to reset the atom.
   inline std::string &append(char c) {
+    atom = AtomTable::NONE;
     return std::string::append(1, c);
   }
-  inline std::string &append(const std::string &c) {
-    return std::string::append(c);
+  template <typename... Args>
+  inline std::string &append(Args &&... args) {
+    atom = AtomTable::NONE;
+    return std::string::append(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  inline std::string &assign(Args &&... args) {
+    atom = AtomTable::NONE;
+    return std::string::assign(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  inline std::string &insert(Args &&... args) {
+    atom = AtomTable::NONE;
+    return std::string::insert(std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  inline std::string &replace(Args &&... args) {
+    atom = AtomTable::NONE;
+    return std::string::replace(std::forward<Args>(args)...);
+  }
+  inline std::string &erase(size_t pos = 0, size_t n = npos) {
+    atom = AtomTable::NONE;
+    return std::string::erase(pos, n);
+  }
+  inline void push_back(char c) {
+    atom = AtomTable::NONE;
+    std::string::push_back(c);
+  }
+  inline std::string &operator+=(const std::string &str) {
+    return append(str);
+  }
+  inline std::string &operator+=(char c) {
+    return append(c);
+  }
+  inline char &operator[](size_t pos) {
+    atom = AtomTable::NONE;
+    return std::string::operator[](pos);
+  }
+  inline const char &operator[](size_t pos) const {
+    return std::string::operator[](pos);
+  }
+  inline char &at(size_t pos) {
+    atom = AtomTable::NONE;
+    return std::string::at(pos);
+  }
+  inline const char &at(size_t pos) const {
+    return std::string::at(pos);
+  }
+  inline char &front() {
+    atom = AtomTable::NONE;
+    return std::string::front();
+  }
+  inline const char &front() const {
+    return std::string::front();
+  }
+  inline char &back() {
+    atom = AtomTable::NONE;
+    return std::string::back();
+  }
+  inline const char &back() const {
+    return std::string::back();
+  }
+  inline iterator begin() {
+    atom = AtomTable::NONE;
+    return std::string::begin();
+  }
+  inline const_iterator begin() const {
+    return std::string::begin();
+  }
+  inline iterator end() {
+    atom = AtomTable::NONE;
+    return std::string::end();
+  }
+  inline const_iterator end() const {
+    return std::string::end();
+  }
+  inline reverse_iterator rbegin() {
+    atom = AtomTable::NONE;
+    return std::string::rbegin();
+  }
+  inline const_reverse_iterator rbegin() const {
+    return std::string::rbegin();
+  }
+  inline reverse_iterator rend() {
+    atom = AtomTable::NONE;
+    return std::string::rend();
+  }
+  inline const_reverse_iterator rend() const {
+    return std::string::rend();
+  }
+  inline void resize(size_t n, char c = '\0') {
+    atom = AtomTable::NONE;
+    std::string::resize(n, c);
+  }
+  inline void pop_back() {
+    atom = AtomTable::NONE;
+    std::string::pop_back();
+  }
+  inline void swap(Token &t) {
+    std::string::swap(t);
+    std::swap(offset, t.offset);
+    std::swap(sourceId, t.sourceId);
+    std::swap(type, t.type);
+    std::swap(atom, t.atom);
   }
 
+  /**
+   * Tokens without an atom, because the AtomTable is full, are
+   * compared by their characters.
+   */
   inline bool operator==(const Token &t) const {
-    return (type == t.type && (std::string) * this == (std::string)t);
+    if (type != t.type)
+      return false;
+    if (isAtomType(type) && getAtom() != AtomTable::NONE &&
+        t.getAtom() != AtomTable::NONE) {
+      return atom == t.atom;
+    }
+    return compare(t) == 0;
   }
   inline bool operator!=(const Token &t) const {
     return !(*this == t);
   }
 
+  /**
+   * Tokens are ordered by type, then by string.
+   */
   inline bool operator<(const Token &t) const {
-    return (type == t.type) ? (std::string) * this < (std::string)t
-                            : (type < t.type);
+    if (type != t.type)
+      return type < t.type;
+    return compare(t) < 0;
   }
 
   inline bool operator>(const Token &t) const {
@@ -112,6 +293,7 @@ public:
   }
 
   inline Token &operator=(const std::string &str) {
+    atom = AtomTable::NONE;
     std::string::assign(str);
     return *this;
   }
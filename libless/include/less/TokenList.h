@@ -1,12 +1,140 @@
 #ifndef __less_TokenList_h__
 #define __less_TokenList_h__
 
-#include <list>
+#include <cstddef>
+#include <functional>
 #include "less/Token.h"
 
-class TokenList : public std::list<Token> {
+/**
+ * A sequence of tokens, stored contiguously.
+ *
+ * Many lists hold a single token, such as a value or a mixin argument.
+ * Those are kept inside the object itself, and only longer lists are
+ * moved to the heap.
+ *
+ * Iterators are plain pointers, so a pair of iterators is a cheap view
+ * of part of a list. Unlike with std::list, inserting tokens
+ * invalidates all iterators if the list has to grow, and erasing tokens
+ * invalidates the iterators after the first erased token; use the
+ * iterators returned by insert() and erase().
+ */
+class TokenList {
 public:
-  virtual ~TokenList();
+  typedef Token value_type;
+  typedef Token& reference;
+  typedef const Token& const_reference;
+  typedef Token* iterator;
+  typedef const Token* const_iterator;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  /**
+   * Number of tokens that fit in the object itself.
+   */
+  static const size_t INLINE_CAPACITY = 1;
+
+  TokenList();
+  TokenList(const TokenList& tokens);
+  TokenList(TokenList&& tokens) noexcept;
+  TokenList(const_iterator first, const_iterator last);
+  ~TokenList();
+
+  TokenList& operator=(const TokenList& tokens);
+  TokenList& operator=(TokenList&& tokens) noexcept;
+
+  inline iterator begin() {
+    return tokensBegin;
+  }
+  inline iterator end() {
+    return tokensEnd;
+  }
+  inline const_iterator begin() const {
+    return tokensBegin;
+  }
+  inline const_iterator end() const {
+    return tokensEnd;
+  }
+
+  inline size_t size() const {
+    return tokensEnd - tokensBegin;
+  }
+  inline bool empty() const {
+    return tokensEnd == tokensBegin;
+  }
+  inline size_t capacity() const {
+    return capacityEnd - tokensBegin;
+  }
+
+  inline Token& front() {
+    return *tokensBegin;
+  }
+  inline const Token& front() const {
+    return *tokensBegin;
+  }
+  inline Token& back() {
+    return *(tokensEnd - 1);
+  }
+  inline const Token& back() const {
+    return *(tokensEnd - 1);
+  }
+  inline Token& operator[](size_t i) {
+    return tokensBegin[i];
+  }
+  inline const Token& operator[](size_t i) const {
+    return tokensBegin[i];
+  }
+
+  void push_back(const Token& token);
+  void push_back(Token&& token);
+  void pop_back();
+
+  /**
+   * Insert a token at the front. This moves all tokens in the list.
+   */
+  void push_front(const Token& token);
+
+  /**
+   * Remove the first token. This moves all tokens in the list, use
+   * erase() to remove more than one.
+   */
+  void pop_front();
+
+  /**
+   * @return an iterator pointing to the inserted token.
+   */
+  iterator insert(const_iterator position, const Token& token);
+
+  /**
+   * Insert a copy of the tokens in [first, last). The range can be
+   * part of this list.
+   *
+   * @return an iterator pointing to the first inserted token.
+   */
+  iterator insert(const_iterator position,
+                  const_iterator first,
+                  const_iterator last);
+
+  /**
+   * @return an iterator pointing to the token that followed the erased
+   *         token.
+   */
+  iterator erase(const_iterator position);
+  iterator erase(const_iterator first, const_iterator last);
+
+  void clear();
+  void reserve(size_t n);
+  void swap(TokenList& tokens);
+
+  bool operator==(const TokenList& tokens) const;
+  inline bool operator!=(const TokenList& tokens) const {
+    return !(*this == tokens);
+  }
+  bool operator<(const TokenList& tokens) const;
+
+  /**
+   * Combined hash of the tokens, see Token::hash().
+   */
+  size_t hash() const;
 
   /**
    * Trim whitespace tokens from the front of the selector.
@@ -25,14 +153,52 @@ public:
 
   std::string toString() const;
 
-  bool contains(const Token &t) const;
-  bool contains(Token::Type t, const std::string &str) const;
+  bool contains(const Token& t) const;
+  bool contains(Token::Type t, const std::string& str) const;
   bool containsType(Token::Type t) const;
 
-  const_iterator find(const Token &find,
-                      const_iterator offset) const;
-  const_iterator find(const TokenList &find,
-                      const_iterator &offset) const;
+  const_iterator find(const Token& find, const_iterator offset) const;
+  const_iterator find(const TokenList& find, const_iterator& offset) const;
+
+private:
+  Token* tokensBegin;
+  Token* tokensEnd;
+  Token* capacityEnd;
+
+  alignas(Token) char buffer[INLINE_CAPACITY * sizeof(Token)];
+
+  inline Token* getBuffer() {
+    return reinterpret_cast<Token*>(buffer);
+  }
+  inline bool isInline() const {
+    return tokensBegin == reinterpret_cast<const Token*>(buffer);
+  }
+
+  /**
+   * Make room for at least n tokens, growing the storage geometrically.
+   */
+  void grow(size_t n);
+
+  /**
+   * Move the tokens to storage that holds at least n tokens.
+   */
+  void reallocate(size_t n);
+
+  /**
+   * Take over the heap storage of tokens, or move its inline tokens.
+   * The list must be empty and have inline storage.
+   */
+  void moveFrom(TokenList& tokens) noexcept;
+  void release() noexcept;
+};
+
+namespace std {
+template <>
+struct hash<TokenList> {
+  size_t operator()(const TokenList& tokens) const {
+    return tokens.hash();
+  }
 };
+}  // namespace std
 
 #endif  // __less_TokenList_h__
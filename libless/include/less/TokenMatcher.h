@@ -0,0 +1,40 @@
+#ifndef __less_TokenMatcher_h__
+#define __less_TokenMatcher_h__
+
+#include <vector>
+#include "less/TokenList.h"
+
+/**
+ * Searches token lists for one fixed sequence of tokens.
+ *
+ * The pattern is preprocessed into a Knuth-Morris-Pratt failure table,
+ * so a search reads each token of the list at most twice, no matter
+ * how often a prefix of the pattern repeats. Build the matcher once and
+ * reuse it for every list that is searched for the same pattern.
+ */
+class TokenMatcher {
+private:
+  TokenList pattern;
+
+  /**
+   * failure[i] is the length of the longest proper prefix of the
+   * first i + 1 pattern tokens that is also a suffix of them.
+   */
+  std::vector<size_t> failure;
+
+public:
+  explicit TokenMatcher(const TokenList& pattern);
+
+  const TokenList& getPattern() const;
+
+  /**
+   * Same contract as TokenList::find(const TokenList&, const_iterator&):
+   * returns the end of the first match at or after offset and moves
+   * offset to its start, or returns tokens.begin() if there is no
+   * match. An empty pattern never matches.
+   */
+  TokenList::const_iterator find(const TokenList& tokens,
+                                 TokenList::const_iterator& offset) const;
+};
+
+#endif  // __less_TokenMatcher_h__
@@ -1,15 +1,71 @@
 #ifndef __less_VariableMap_h__
 #define __less_VariableMap_h__
 
-#include <map>
+#include <string>
+#include <unordered_map>
 #include "less/TokenList.h"
 
-class VariableMap : public std::map<std::string, TokenList> {
+/**
+ * Variables by the atom of their name, see AtomTable. Variable names
+ * are at-keywords, so a reference to a variable is looked up with the
+ * atom its token already has, without comparing strings.
+ */
+class VariableMap {
+private:
+  std::unordered_map<unsigned int, TokenList> variables;
+
 public:
+  typedef std::unordered_map<unsigned int, TokenList>::iterator iterator;
+  typedef std::unordered_map<unsigned int, TokenList>::const_iterator
+      const_iterator;
+
+  const TokenList *getVariable(unsigned int atom) const;
   const TokenList *getVariable(const std::string &key) const;
+
+  /**
+   * The value of the variable, which is added if it does not exist.
+   */
+  TokenList &operator[](const std::string &key);
+
+  /**
+   * Adds the variable unless it already exists.
+   */
+  void insert(const std::string &key, const TokenList &value);
+
   void merge(const VariableMap &map);
+  /**
+   * Copy all variables from map, replacing existing ones.
+   *
+   * @return true if a variable was replaced.
+   */
+  bool overwrite(const VariableMap &map);
+
+  inline iterator begin() {
+    return variables.begin();
+  }
+  inline iterator end() {
+    return variables.end();
+  }
+  inline const_iterator begin() const {
+    return variables.begin();
+  }
+  inline const_iterator end() const {
+    return variables.end();
+  }
+  inline size_t size() const {
+    return variables.size();
+  }
+  inline bool empty() const {
+    return variables.empty();
+  }
+  inline void clear() {
+    variables.clear();
+  }
 
-  void overwrite(const VariableMap &map);
+  /**
+   * The name of the variable at it.
+   */
+  static const std::string &getName(const const_iterator &it);
 
   std::string toString() const;
 };
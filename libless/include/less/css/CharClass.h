@@ -0,0 +1,76 @@
+#ifndef __less_css_CharClass_h__
+#define __less_css_CharClass_h__
+
+/**
+ * Character classes used by the tokenizers. Each tokenizer keeps a
+ * 256-entry table of class bits, built at compile time with
+ * LESS_CHARCLASS_TABLE(), so testing a character is a single lookup
+ * instead of a chain of range comparisons.
+ *
+ * A subclass can extend the CSS classes by building its own table from
+ * a function or macro that adds bits to CharClass::css().
+ */
+class CharClass {
+public:
+  enum {
+    /** [_a-zA-Z] and non-ascii characters. Escapes are not included. */
+    NAME_START = 0x01,
+    /** [_a-zA-Z0-9-] and non-ascii characters. */
+    NAME = 0x02,
+    DIGIT = 0x04,
+    HEX = 0x08,
+    /** [ \t\r\n\f] */
+    WHITESPACE = 0x10,
+    /** Single character tokens: ; : { } ( ) [ ] */
+    DELIMITER = 0x20,
+    /** Characters allowed in an unquoted url(). */
+    URL = 0x40,
+    /** Characters that start a comment when they follow a '/'. */
+    COMMENT = 0x80
+  };
+
+  static constexpr bool isAlpha(unsigned int c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+  static constexpr bool isDigit(unsigned int c) {
+    return c >= '0' && c <= '9';
+  }
+  static constexpr bool isWhitespace(unsigned int c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+  }
+  static constexpr bool isDelimiter(unsigned int c) {
+    return c == ';' || c == ':' || c == '{' || c == '}' || c == '(' ||
+           c == ')' || c == '[' || c == ']';
+  }
+
+  /**
+   * The classes of a character in CSS.
+   */
+  static constexpr unsigned char css(unsigned int c) {
+    return (unsigned char)(
+        (isAlpha(c) || c == '_' || c >= 128 ? NAME_START | NAME : 0) |
+        (isDigit(c) ? NAME | DIGIT | HEX : 0) | (c == '-' ? NAME : 0) |
+        ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') ? HEX : 0) |
+        (isWhitespace(c) ? WHITESPACE : 0) |
+        (isDelimiter(c) ? DELIMITER : 0) |
+        (!isWhitespace(c) && c != ')' ? URL : 0) |
+        (c == '*' ? COMMENT : 0));
+  }
+};
+
+#define LESS_CHARCLASS_ROW4(f, n) f((n)), f((n) + 1), f((n) + 2), f((n) + 3)
+#define LESS_CHARCLASS_ROW16(f, n)                             \
+  LESS_CHARCLASS_ROW4(f, (n)), LESS_CHARCLASS_ROW4(f, (n) + 4), \
+      LESS_CHARCLASS_ROW4(f, (n) + 8), LESS_CHARCLASS_ROW4(f, (n) + 12)
+#define LESS_CHARCLASS_ROW64(f, n)                                \
+  LESS_CHARCLASS_ROW16(f, (n)), LESS_CHARCLASS_ROW16(f, (n) + 16), \
+      LESS_CHARCLASS_ROW16(f, (n) + 32), LESS_CHARCLASS_ROW16(f, (n) + 48)
+
+/**
+ * Initializer for a 256-entry class table: f(0), f(1), ..., f(255).
+ */
+#define LESS_CHARCLASS_TABLE(f)                               \
+  LESS_CHARCLASS_ROW64(f, 0), LESS_CHARCLASS_ROW64(f, 64),     \
+      LESS_CHARCLASS_ROW64(f, 128), LESS_CHARCLASS_ROW64(f, 192)
+
+#endif  // __less_css_CharClass_h__
@@ -0,0 +1,56 @@
+#ifndef __less_css_CharScanner_h__
+#define __less_css_CharScanner_h__
+
+#include <cstddef>
+
+/**
+ * Finds the end of runs of characters in a buffer 16 or 32 bytes at a
+ * time. The SSE2 or AVX2 implementation is picked when the library is
+ * loaded, depending on what the cpu supports. Other architectures use
+ * the scalar versions.
+ *
+ * Each function returns a pointer to the first character in [p, end)
+ * that stops the run, or end if there is none.
+ */
+class CharScanner {
+public:
+  /**
+   * Skip name characters: [_a-zA-Z0-9-] and non-ascii characters.
+   * Escapes ('\') stop the run.
+   */
+  static const char *skipName(const char *p, const char *end);
+
+  /**
+   * Skip whitespace: [ \t\r\n\f].
+   */
+  static const char *skipWhitespace(const char *p, const char *end);
+
+  /**
+   * Find the closing quote of a string, or a character that needs to be
+   * handled by the tokenizer: '\', '\n', '\r' or '\f'.
+   */
+  static const char *findStringEnd(const char *p,
+                                   const char *end,
+                                   char quote);
+
+  /**
+   * Find the character c.
+   */
+  static const char *find(const char *p, const char *end, char c);
+
+  /**
+   * Name of the implementation in use: "avx2", "sse2" or "scalar".
+   */
+  static const char *getImplementation();
+
+  /**
+   * Use the implementation with the given name instead, so the tests can
+   * compare each one with the scalar version. Not thread safe.
+   *
+   * @return false if the implementation is not compiled in or the cpu
+   *         does not support it.
+   */
+  static bool setImplementation(const char *name);
+};
+
+#endif  // __less_css_CharScanner_h__
@@ -64,6 +64,11 @@ protected:
    */
   bool parseEmptyStatement();
 
+  /**
+   * Print the warning for the empty statement at t.
+   */
+  static void warnEmptyStatement(const Token &t);
+
   /**
    * Parse a media query, starting with the @media keyword.
    *
@@ -175,6 +180,16 @@ public:
    *   the input, such as unterminated strings or parentheses.
    */
   virtual void parseStylesheet(Stylesheet &stylesheet);
+
+  /**
+   * Parses a stylesheet from the tokenizer and writes each statement
+   * to the writer as soon as it is parsed, so only one statement is
+   * kept in memory at a time.
+   *
+   * @throws ParseException if the parser comes across a mistake in
+   *   the input. The statements before it have been written.
+   */
+  void streamStylesheet(CssWriter &writer);
 };
 
 #endif  // __less_css_CssParser_h__
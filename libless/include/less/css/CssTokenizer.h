@@ -4,8 +4,10 @@
 #include <iostream>
 #include <string>
 #include "less/Token.h"
+#include "less/css/CharClass.h"
 #include "less/css/IOException.h"
 #include "less/css/ParseException.h"
+#include "less/css/SourceBuffer.h"
 
 using namespace std;
 
@@ -84,8 +86,27 @@ using namespace std;
  */
 class CssTokenizer {
 public:
+  /**
+   * Tokenize a stream. The stream is read in blocks as tokens are
+   * requested.
+   */
   CssTokenizer(istream& in, const char* source);
 
+  /**
+   * Tokenize a buffer that was loaded by the caller, for example a
+   * memory-mapped file. The buffer is handed to the SourceRegistry,
+   * which deletes it.
+   */
+  CssTokenizer(SourceBuffer* buffer, const char* source);
+
+  /**
+   * Tokenize the bytes from offset begin up to end of a source that is
+   * in the SourceRegistry with its content, such as a block that was
+   * skipped earlier. The tokens have the same locations as when the
+   * whole source is read.
+   */
+  CssTokenizer(unsigned int sourceId, size_t begin, size_t end);
+
   virtual ~CssTokenizer();
 
   Token::Type readNextToken();
@@ -95,24 +116,106 @@ public:
 
   const char* getSource();
 
+  /**
+   * Id of the source in the SourceRegistry.
+   */
+  unsigned int getSourceId();
+
+  /**
+   * CharClass bits of each character in CSS.
+   */
+  static constexpr unsigned char charClasses[256] = {
+      LESS_CHARCLASS_TABLE(CharClass::css)};
+
 protected:
-  istream* in;
+  SourceBuffer* buffer;
+
+  /**
+   * Next unread character and end of the data that is currently in
+   * the buffer.
+   */
+  const char* pos;
+  const char* end;
+
+  /**
+   * Set when the first character has been read, and when the end of
+   * the input has been reached.
+   */
+  bool started, eof;
 
   Token currentToken;
   char lastRead;
 
-  unsigned int line, column;
+  /**
+   * Offset of the first character of the current token. Instead of
+   * appending characters to the token one by one, the token is
+   * assigned the whole span of the buffer when it ends.
+   */
+  size_t tokenStart;
+
   const char* source;
+  unsigned int sourceId;
+
+  /**
+   * The class table in use. Subclasses can point this at a table
+   * that extends charClasses.
+   */
+  const unsigned char* classes;
 
-  void readChar();
+  /**
+   * Advance to the next character in the buffer. Only calls
+   * fillBuffer() when the buffered input runs out.
+   */
+  inline void readChar() {
+    if (eof)
+      return;
+
+    if (pos == end && !fillBuffer()) {
+      eof = true;
+      return;
+    }
+    lastRead = *pos++;
+  }
+  bool fillBuffer();
+
+  /**
+   * Move ahead to the character at p, which has to be in (pos - 1,
+   * end]. The characters that are passed become part of the current
+   * token.
+   */
+  inline void skipTo(const char* p) {
+    pos = p;
+    readChar();
+  }
+
+  /**
+   * Read a run of characters with one of the CharScanner functions.
+   */
+  void readRun(const char* (*scan)(const char*, const char*));
+
+  /**
+   * Read a run of characters that have one of the given CharClass bits.
+   */
+  void readClass(unsigned char cls);
+
+  /**
+   * Offset of lastRead in the buffer, or the size of the buffer once
+   * the end of the input is reached.
+   */
+  size_t readOffset() const;
+
+  /**
+   * Compare the characters read so far for the current token.
+   */
+  bool tokenEquals(const char* str, size_t len) const;
 
   bool readIdent();
   bool readName();
   bool readNMStart();
-  bool readNonAscii();
   bool readEscape();
   bool readUnicode();
   bool readNMChar();
+  void readNMChars();
   bool readNum(bool readDecimals);
   bool readNumSuffix();
   bool readString();
@@ -123,9 +226,16 @@ protected:
   bool readUnicodeRange();
 
   bool lastReadEq(char c);
-  bool lastReadInRange(char c1, char c2);
-  bool lastReadIsDigit();
-  bool lastReadIsHex();
+
+  /**
+   * Returns true if lastRead has one of the given CharClass bits.
+   */
+  inline bool lastReadIs(unsigned char cls) const {
+    return !eof && (classes[(unsigned char)lastRead] & cls) != 0;
+  }
+
+private:
+  void readDelimiter();
 };
 
 #endif  // __less_css_CssTokenizer_h__
@@ -28,6 +28,14 @@ public:
                  unsigned int column,
                  const std::string source);
 
+  /**
+   * Report found at offset in a source from the SourceRegistry.
+   */
+  ParseException(const char* found,
+                 const char* expected,
+                 unsigned int sourceId,
+                 unsigned int offset);
+
   ParseException(const Token& found, const char* expected);
   ParseException(const TokenList& found, const char* expected);
 
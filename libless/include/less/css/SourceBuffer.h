@@ -0,0 +1,69 @@
+#ifndef __less_css_SourceBuffer_h__
+#define __less_css_SourceBuffer_h__
+
+#include <cstddef>
+#include <iostream>
+
+#include "less/css/IOException.h"
+
+/**
+ * Contiguous in-memory copy of a tokenizer's input.
+ *
+ * Files opened with open() are memory-mapped. Other streams (stdin,
+ * pipes, string streams) are read in blocks of BLOCK_SIZE bytes when
+ * the tokenizer runs out of input, so the stream is not touched before
+ * the first token is requested.
+ *
+ * As with the original istream based tokenizer, an escape character
+ * (27) marks the end of the input.
+ */
+class SourceBuffer {
+public:
+  static const size_t BLOCK_SIZE = 65536;
+
+  SourceBuffer();
+  SourceBuffer(std::istream &in);
+  virtual ~SourceBuffer();
+
+  /**
+   * Map the file into memory. Files that can't be mapped (empty files,
+   * devices, fifos) are read into memory instead.
+   *
+   * @return false if the file could not be opened.
+   */
+  bool open(const char *filename);
+
+  /**
+   * Append the next block of the input stream to the buffer.
+   *
+   * @return false if no data was added because the end of the input
+   *         was reached.
+   * @throws IOException if the stream reports an error.
+   */
+  bool fill();
+
+  /**
+   * Returns true if all of the input is in the buffer.
+   */
+  bool isComplete() const;
+
+  const char *getData() const;
+  size_t getSize() const;
+
+private:
+  std::istream *in;
+  char *data;
+  size_t size, capacity;
+  bool mapped;
+  bool complete;
+
+  void release();
+  void reserve(size_t n);
+  bool readFile(int fd);
+  void truncateAtEscape(size_t offset);
+
+  SourceBuffer(const SourceBuffer &);
+  SourceBuffer &operator=(const SourceBuffer &);
+};
+
+#endif  // __less_css_SourceBuffer_h__
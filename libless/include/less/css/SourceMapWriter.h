@@ -6,18 +6,18 @@
 #include <iostream>
 #include <list>
 
+#include "less/SourceSet.h"
 #include "less/Token.h"
 
 class SourceMapWriter {
 private:
   std::ostream& sourcemap_h;
-  std::list<const char*>& sources;
+  const SourceSet& sources;
 
   unsigned int lastDstColumn;
   unsigned int lastSrcFile, lastSrcLine, lastSrcColumn;
   bool firstSegment;
   
-  size_t sourceFileIndex(const char* file);
   size_t encodeMapping(unsigned int column, const Token& source, char* buffer);
   size_t encodeField(int field, char* buffer);
 
@@ -28,8 +28,13 @@ private:
 public:
   static const char* base64;
 
+  /**
+   * @param sources          the files of the compilation.
+   * @param relative_sources the names to write in the source map for
+   *                         each file in sources.
+   */
   SourceMapWriter(std::ostream& sourcemap,
-                  std::list<const char*>& sources,
+                  const SourceSet& sources,
                   std::list<const char*>& relative_sources,
                   const char* out_filename,
                   const char* rootpath = NULL);
@@ -0,0 +1,61 @@
+#ifndef __less_less_ConstantFolder_h__
+#define __less_less_ConstantFolder_h__
+
+#include "less/TokenList.h"
+#include "less/lessstylesheet/LessDeclaration.h"
+#include "less/lessstylesheet/LessRuleset.h"
+#include "less/lessstylesheet/LessStylesheet.h"
+#include "less/value/ValueProcessor.h"
+#include "less/value/ValueScope.h"
+
+/**
+ * Evaluates the declaration values of a parsed stylesheet that do not
+ * refer to variables, so that `width: (960px / 12) * 3` is computed
+ * once instead of each time its ruleset or mixin is processed.
+ *
+ * A value is left alone if it contains a variable, a string with
+ * interpolation, a url, a function that reads files such as
+ * data-uri() and image-width(), or default(), whose result depends on
+ * the mixin guard it is evaluated in. A value that fails to evaluate
+ * is also left alone, so the error is reported when, and only if, its
+ * ruleset is processed. Reference blocks that have not been parsed yet
+ * are skipped.
+ */
+class ConstantFolder : public ValueScope {
+public:
+  ConstantFolder();
+  virtual ~ConstantFolder();
+
+  void fold(LessStylesheet &stylesheet);
+  void fold(LessRuleset &ruleset);
+
+  /**
+   * Evaluate the value of the declaration if it is constant.
+   *
+   * @return true if the value was folded.
+   */
+  bool fold(LessDeclaration &declaration);
+
+  /**
+   * Returns true if the value can be evaluated without a scope.
+   */
+  static bool isConstant(const TokenList &value);
+
+  /**
+   * Returns false for the functions that read files or depend on where
+   * they are evaluated, whose calls are never evaluated ahead. The
+   * ValueProcessor uses the same list when it parses values.
+   */
+  static bool isFoldable(const Token &function);
+
+  /**
+   * There are no variables outside of a stylesheet.
+   */
+  virtual const TokenList *getVariable(unsigned int atom) const;
+  using ValueScope::getVariable;
+
+private:
+  ValueProcessor processor;
+};
+
+#endif  // __less_less_ConstantFolder_h__
@@ -0,0 +1,53 @@
+#ifndef __less_less_DependencyScanner_h__
+#define __less_less_DependencyScanner_h__
+
+#include <vector>
+
+#include "less/SourceSet.h"
+#include "less/less/ImportResolver.h"
+#include "less/less/LessTokenizer.h"
+
+/**
+ * Finds the files a stylesheet imports, directly or through other
+ * files, without parsing it.
+ *
+ * The scanner only reads tokens and keeps track of where statements
+ * start and which blocks hold statements, so that it recognizes the
+ * same @import statements as LessParser: those at the top level and in
+ * rulesets, mixins and @media blocks, but not those in the blocks of
+ * other at-rules or in mixin arguments. The imports are resolved and
+ * skipped by the same rules as the parser's, and the files are added to
+ * sources in the order the parser would add them.
+ *
+ * Syntax errors other than those in @import statements are not
+ * noticed.
+ */
+class DependencyScanner {
+public:
+  DependencyScanner(ImportResolver &resolver, SourceSet &sources);
+  virtual ~DependencyScanner();
+
+  /**
+   * Scan the file that tokenizer reads, and every file it imports. The
+   * file itself is expected to be in sources already.
+   *
+   * @throws ParseException if an @import is malformed or refers to a
+   *         file that doesn't exist.
+   */
+  void scan(LessTokenizer &tokenizer);
+
+private:
+  ImportResolver &resolver;
+  SourceSet &sources;
+
+  /**
+   * Read the rest of an @import statement and follow it, leaving the
+   * token that ends it (';', '{', '}' or the end of input) as the
+   * current token.
+   */
+  void scanImport(LessTokenizer &tokenizer);
+
+  void importFile(Token &uri, unsigned int directive);
+};
+
+#endif  // __less_less_DependencyScanner_h__
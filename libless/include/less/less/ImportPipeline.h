@@ -0,0 +1,120 @@
+#ifndef __less_less_ImportPipeline_h__
+#define __less_less_ImportPipeline_h__
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "less/less/ImportResolver.h"
+#include "less/less/ImportedFile.h"
+#include "less/less/StylesheetCache.h"
+
+/**
+ * Parses imported files on worker threads while the importing files
+ * are still being parsed.
+ *
+ * A LessParser with a pipeline prefetches every @import it finds at the
+ * top level of a file and records it in an ImportedFile. Workers parse
+ * the prefetched files the same way, so the imports of imports are
+ * found early too. Following the imports, deciding which files are
+ * included and splicing the statements together still happens on the
+ * main thread, in source order; see LessParser::importFile().
+ *
+ * A file is parsed ahead of time at most once for each value of the
+ * reference directive. Files that are needed again, with the
+ * <code>multiple</code> directive for example, are parsed when they are
+ * taken.
+ *
+ * With a StylesheetCache, files are loaded from the cache when it has
+ * them, and stored in it after they are parsed. A pipeline without
+ * threads parses every file when it is taken, which is still useful for
+ * the cache.
+ */
+class ImportPipeline {
+private:
+  struct Job {
+    std::string filename;
+    bool reference;
+    bool started, done;
+    ImportedFile* file;
+
+    /**
+     * For a chunk of a source, the source and the range; filename is
+     * empty.
+     */
+    unsigned int sourceId;
+    size_t begin, end;
+  };
+  typedef std::pair<std::string, bool> Key;
+
+  ImportResolver* resolver;
+  StylesheetCache* cache;
+
+  /**
+   * Jobs by file; the job is reset once it has been taken.
+   */
+  std::map<Key, std::shared_ptr<Job> > jobs;
+  std::deque<std::shared_ptr<Job> > queue;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wakeup, finished;
+  bool stopping;
+
+  void work();
+  ImportedFile* parse(const Job& job);
+  ImportedFile* parse(const std::string& filename, bool reference);
+  ImportedFile* parse(unsigned int sourceId,
+                      size_t begin,
+                      size_t end,
+                      bool reference);
+
+public:
+  /**
+   * The resolver and the cache, which may be NULL, are shared by the
+   * parsers on all threads and have to outlive the pipeline.
+   */
+  ImportPipeline(ImportResolver& resolver,
+                 unsigned int threads,
+                 StylesheetCache* cache = NULL);
+
+  /**
+   * Waits for the running jobs and discards the files that were never
+   * taken.
+   */
+  virtual ~ImportPipeline();
+
+  /**
+   * Queues the file to be parsed by a worker, unless it has been
+   * queued before or there are no workers.
+   */
+  void prefetch(const std::string& filename, bool reference);
+
+  /**
+   * Returns the parsed file, waiting for its worker if it is being
+   * parsed. A file that has not been started yet is parsed on the
+   * calling thread. The caller owns the result.
+   */
+  ImportedFile* take(const std::string& filename, bool reference);
+
+  /**
+   * Parses the chunks [offsets[i], offsets[i + 1]) of a source on the
+   * workers and the calling thread, and returns them in order. Each
+   * chunk has to start and end between top-level statements, see
+   * StatementSplitter. The caller owns the results.
+   */
+  std::vector<ImportedFile*> parseChunks(unsigned int sourceId,
+                                         const std::vector<size_t>& offsets,
+                                         bool reference);
+
+  unsigned int getThreads() const;
+};
+
+#endif  // __less_less_ImportPipeline_h__
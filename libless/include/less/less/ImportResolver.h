@@ -0,0 +1,71 @@
+#ifndef __less_less_ImportResolver_h__
+#define __less_less_ImportResolver_h__
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Finds the files that @import statements refer to.
+ *
+ * A uri is looked up relative to the directory of the importing file
+ * first and then in each include path. Every probe is a stat() call,
+ * and both the probes and the outcome of each lookup are cached for the
+ * rest of the compilation, including lookups that found nothing. A
+ * partial that is imported from many files therefore costs one lookup
+ * per directory it is imported from.
+ *
+ * One resolver can be shared by the parsers of all files of a
+ * compilation, on any thread.
+ */
+class ImportResolver {
+public:
+  /**
+   * The list is not copied and has to outlive the resolver. It may be
+   * NULL.
+   */
+  explicit ImportResolver(std::list<const char *> *includePaths);
+  virtual ~ImportResolver();
+
+  std::list<const char *> *getIncludePaths() const;
+
+  /**
+   * Resolve uri as imported from a file in directory, which is empty or
+   * ends with a path separator.
+   *
+   * @param filename  set to the name to open the file with.
+   * @param path      set to the canonical path of the file, see
+   *                  SourceRegistry::canonicalPath().
+   * @return false if no candidate exists.
+   */
+  bool resolve(const std::string &directory,
+               const std::string &uri,
+               std::string &filename,
+               std::string &path);
+
+private:
+  struct Resolution {
+    bool found;
+    std::string filename;
+    std::string path;
+  };
+
+  std::list<const char *> *includePaths;
+
+  /**
+   * directory + '\0' + uri -> outcome of the lookup.
+   */
+  std::unordered_map<std::string, Resolution> resolutions;
+
+  /**
+   * Candidate file name -> whether it is a regular file.
+   */
+  std::unordered_map<std::string, bool> files;
+
+  std::mutex mutex;
+
+  bool exists(const std::string &filename);
+};
+
+#endif  // __less_less_ImportResolver_h__
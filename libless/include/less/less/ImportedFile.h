@@ -0,0 +1,79 @@
+#ifndef __less_less_ImportedFile_h__
+#define __less_less_ImportedFile_h__
+
+#include <exception>
+#include <vector>
+
+#include "less/Token.h"
+#include "less/lessstylesheet/LessStylesheet.h"
+
+/**
+ * A file that is parsed before it is known where, or whether, it is
+ * imported.
+ *
+ * Whether an @import is followed depends on the files imported before
+ * it, so the parser records the imports at the top level of the file
+ * instead of following them. The statements around them go into
+ * separate segments, one more than there are imports. Splicing segment
+ * 0, import 0, segment 1 and so on into the importing stylesheet gives
+ * the same stylesheet as parsing the file in place.
+ */
+class ImportedFile {
+public:
+  struct Import {
+    /**
+     * The uri as it was written, with the source of the importing
+     * file.
+     */
+    Token uri;
+    unsigned int directive;
+  };
+
+  /**
+   * The stylesheet that is being parsed on the main thread, or NULL if
+   * the file is parsed ahead of time by a worker.
+   */
+  LessStylesheet* target;
+
+  /**
+   * An empty statement, which is reported when the segment it is in is
+   * spliced.
+   */
+  struct Warning {
+    size_t segment;
+    Token token;
+  };
+
+  std::vector<LessStylesheet*> segments;
+  std::vector<Import> imports;
+  std::vector<Warning> warnings;
+
+  unsigned int sourceId;
+  bool readable;
+
+  /**
+   * Set when a worker finds an @import inside a ruleset or media
+   * query. Those can only be followed in place, so the file has to be
+   * parsed again when it is imported.
+   */
+  bool serial;
+
+  /**
+   * The exception that stopped the parser. It is thrown again after
+   * the statements before it have been spliced.
+   */
+  std::exception_ptr error;
+
+  explicit ImportedFile(LessStylesheet* target);
+  ~ImportedFile();
+
+  /**
+   * The stylesheet that statements are parsed into: the last segment,
+   * or the target once the segments have been spliced.
+   */
+  LessStylesheet& current();
+
+  bool isDeferring() const;
+};
+
+#endif  // __less_less_ImportedFile_h__
@@ -15,11 +15,16 @@
 #include "less/lessstylesheet/MediaQueryRuleset.h"
 #include "less/stylesheet/Stylesheet.h"
 
+#include "less/SourceSet.h"
 #include "less/Token.h"
 #include "less/TokenList.h"
 
+#include "less/less/ImportResolver.h"
+#include "less/less/ImportedFile.h"
 #include "less/less/LessTokenizer.h"
 
+class ImportPipeline;
+
 /**
  * Extends the css spec with these parts:
  * * Variables
@@ -52,13 +57,47 @@ public:
 
   std::list<const char *> *includePaths;
 
-  LessParser(CssTokenizer &tokenizer, std::list<const char *> &source_files)
-      : CssParser(tokenizer), sources(source_files), reference(false) {
+  /**
+   * If set, imported files are parsed ahead of time on the pipeline's
+   * threads.
+   */
+  ImportPipeline *pipeline;
+
+  /**
+   * Finds imported files. If not set, imports are looked up in
+   * includePaths without caching.
+   */
+  ImportResolver *resolver;
+
+  /**
+   * With a pipeline that has threads, a source of at least twice this
+   * many bytes is split into chunks of whole statements, which are
+   * parsed on the threads and spliced in order; see
+   * StatementSplitter. 0 turns splitting off.
+   */
+  size_t splitSize;
+
+  LessParser(CssTokenizer &tokenizer, SourceSet &source_files)
+      : CssParser(tokenizer),
+        includePaths(NULL),
+        pipeline(NULL),
+        resolver(NULL),
+        splitSize(0),
+        sources(source_files),
+        reference(false),
+        deferred(NULL) {
   }
   LessParser(CssTokenizer &tokenizer,
-             std::list<const char *> &source_files,
+             SourceSet &source_files,
              bool isreference)
-      : CssParser(tokenizer), sources(source_files), reference(isreference) {
+      : CssParser(tokenizer),
+        includePaths(NULL),
+        pipeline(NULL),
+        resolver(NULL),
+        splitSize(0),
+        sources(source_files),
+        reference(isreference),
+        deferred(NULL) {
   }
   virtual ~LessParser() {
   }
@@ -70,10 +109,59 @@ public:
    */
   void parseStylesheet(LessRuleset &ruleset);
 
+  /**
+   * Parse into the segments of file, recording the imports at the top
+   * level instead of following them. Errors are stored in the file.
+   * With a pipeline, the imported files are prefetched.
+   */
+  void parseStylesheet(ImportedFile &file);
+
+  /**
+   * Parse the statements of a ruleset's block, without the braces, up
+   * to the end of the input. This is how a ReferenceRuleset parses the
+   * block it skipped.
+   */
+  void parseRulesetBlock(LessRuleset &ruleset);
+
+  /**
+   * Strip the directives, such as (reference), from the rule of an
+   * @import and add them to directive.
+   *
+   * @return the uri of the import, the first token left in statement.
+   * @throws ParseException if a directive is not known or there is no
+   *         uri.
+   */
+  static Token &parseImportRule(TokenList &statement, unsigned int &directive);
+
+  static unsigned int parseImportDirective(Token &t);
+
+  /**
+   * Turn the uri of an @import into the name of the file to look up:
+   * quotes and url() are removed and .less is added if there is no
+   * extension.
+   *
+   * @return false if the import is left in the output instead: remote
+   *         files, css files and imports with the css directive.
+   */
+  static bool getImportFilename(Token &uri, unsigned int directive);
+
 protected:
-  std::list<const char *> &sources;
+  SourceSet &sources;
   bool reference;
   LessSelectorParser lessSelectorParser;
+
+  /**
+   * The file that imports are deferred in, NULL if they are followed
+   * in place.
+   */
+  ImportedFile *deferred;
+
+  /**
+   * Storage for the tokens of a statement, kept between statements so
+   * the list does not grow again for each one. A nested statement
+   * finds it empty and uses its own.
+   */
+  TokenList statementBuffer;
   
   /**
    * Skip comments only if they are LESS comments, not CSS comments.
@@ -108,11 +196,28 @@ protected:
                               LessRuleset &parent);
 
   bool parsePropertyVariable(TokenList &selector);
+
+  /**
+   * Read a statement up to its end and decide what it is from there:
+   * a nested ruleset if a block follows, otherwise an extension, a
+   * declaration or a mixin call.
+   */
   bool parseRulesetStatement(LessRuleset &parent);
+  bool parseRulesetStatement(LessRuleset &parent, TokenList &tokens);
 
   bool parseComment(LessRuleset& ruleset);
-  bool parseExtension(TokenList &statement, LessRuleset &ruleset);
-  bool parseDeclaration(TokenList &tokens,
+
+  /**
+   * Whether the statement starts with <code>&:extend(</code>.
+   */
+  bool isExtension(const TokenList &statement) const;
+
+  /**
+   * The target of the extension is made out of the tokens of the
+   * statement, so they are unspecified afterwards.
+   */
+  void parseExtension(TokenList &statement, LessRuleset &ruleset);
+  void parseDeclaration(TokenList &tokens,
                         size_t property_i,
                         LessRuleset &ruleset);
 
@@ -130,8 +235,7 @@ protected:
                             LessStylesheet &stylesheet);
   bool parseImportStatement(TokenList &statement,
                             LessRuleset &ruleset);
-  
-  unsigned int parseImportDirective(Token &t);
+
 
   bool importFile(Token uri,
                   LessStylesheet &stylesheet,
@@ -147,11 +251,53 @@ private:
 
   std::list<TokenList *> *processArguments(TokenList *arguments);
 
-  bool findFile(Token &uri, std::string &filename);
+  /**
+   * Find the file that uri refers to.
+   *
+   * @param path  set to the canonical path of the file.
+   */
+  bool findFile(Token &uri, std::string &filename, std::string &path);
+
+  /**
+   * Record an import in the deferred file and start a new segment.
+   */
+  bool deferImport(const Token &import, Token &uri, unsigned int directive);
+
+  /**
+   * Like CssParser::parseEmptyStatement(), but the warning is recorded
+   * in file while it is deferring.
+   */
+  bool parseEmptyStatement(ImportedFile &file);
+
+  /**
+   * Moves the segments of file into stylesheet, following the recorded
+   * imports between them, then throws the error of the file if it has
+   * one.
+   */
+  void splice(ImportedFile &file, LessStylesheet &stylesheet);
 
   bool parseRuleset(TokenList &selector,
                     LessStylesheet *stylesheet,
                     LessRuleset *parentRuleset);
+
+  /**
+   * Skip the block of a ruleset in a file imported with (reference)
+   * and add a ReferenceRuleset for it, which parses the block when it
+   * is needed. A block that holds an @import is parsed right away, so
+   * the import is followed in order.
+   */
+  void parseReferenceRuleset(TokenList &selector, LessStylesheet &stylesheet);
+
+  /**
+   * Split the source into chunks, parse them on the pipeline's threads
+   * and splice them into stylesheet.
+   *
+   * @return false if nothing was parsed: the source was too small or
+   *         could not be split, or a chunk has to be parsed in place
+   *         or failed, which may be because it was split in the wrong
+   *         place. The source is then parsed in one piece.
+   */
+  bool parseChunks(LessStylesheet &stylesheet);
   bool parseMixin(TokenList &tokens,
                   LessRuleset *parent_r,
                   LessStylesheet *parent_s);
@@ -4,6 +4,12 @@
 #include <iostream>
 #include "less/css/CssTokenizer.h"
 
+/**
+ * CSS classes, with '/' added to the characters that start a comment.
+ */
+#define LESS_LESSTOKENIZER_CLASS(c) \
+  (unsigned char)(CharClass::css(c) | ((c) == '/' ? CharClass::COMMENT : 0))
+
 /**
  * Extends CssTokenizer:
  *  - Add support for c++ style comments
@@ -11,9 +17,22 @@
  */
 class LessTokenizer : public CssTokenizer {
 public:
-  LessTokenizer(istream& in, const char* source) : CssTokenizer(in, source){};
+  LessTokenizer(istream& in, const char* source) : CssTokenizer(in, source) {
+    classes = charClasses;
+  };
+  LessTokenizer(SourceBuffer* buffer, const char* source)
+      : CssTokenizer(buffer, source) {
+    classes = charClasses;
+  };
+  LessTokenizer(unsigned int sourceId, size_t begin, size_t end)
+      : CssTokenizer(sourceId, begin, end) {
+    classes = charClasses;
+  };
   virtual ~LessTokenizer();
 
+  static constexpr unsigned char charClasses[256] = {
+      LESS_CHARCLASS_TABLE(LESS_LESSTOKENIZER_CLASS)};
+
 protected:
   bool readComment();
 };
@@ -0,0 +1,57 @@
+#ifndef __less_less_ReferenceRuleset_h__
+#define __less_less_ReferenceRuleset_h__
+
+#include <cstddef>
+#include <list>
+
+#include "less/lessstylesheet/LessRuleset.h"
+#include "less/lessstylesheet/LessStylesheet.h"
+
+/**
+ * A ruleset at the top level of a file imported with (reference),
+ * whose block has not been parsed.
+ *
+ * Reference rulesets are never written out; they are only used through
+ * mixin calls that find them by their selector. So the parser only
+ * parses the selector, skips the block and records where it is in the
+ * source. The block is parsed the first time a mixin call looks into
+ * the ruleset. Until then, syntax errors in the block are not noticed.
+ */
+class ReferenceRuleset : public LessRuleset {
+public:
+  /**
+   * The block is the content of the source from offset begin up to the
+   * closing '}' at offset end.
+   */
+  ReferenceRuleset(LessSelector &selector,
+                   const LessStylesheet &parent,
+                   unsigned int sourceId,
+                   size_t begin,
+                   size_t end);
+  virtual ~ReferenceRuleset();
+
+  unsigned int getSourceId() const;
+  size_t getBegin() const;
+  size_t getEnd() const;
+
+  bool isLoaded() const;
+
+  /**
+   * Parse the block if it has not been parsed yet.
+   *
+   * @throws ParseException if the block is malformed.
+   */
+  void load() const;
+
+  virtual void getFunctions(std::list<const Function *> &functionList,
+                            const Mixin &mixin,
+                            TokenList::const_iterator selector_offset,
+                            const ProcessingContext &context) const;
+
+private:
+  unsigned int sourceId;
+  size_t begin, end;
+  mutable bool loaded;
+};
+
+#endif  // __less_less_ReferenceRuleset_h__
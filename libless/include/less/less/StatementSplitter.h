@@ -0,0 +1,76 @@
+#ifndef __less_less_StatementSplitter_h__
+#define __less_less_StatementSplitter_h__
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Splits the source of a stylesheet into chunks of whole top-level
+ * statements, so the chunks can be parsed on separate threads and put
+ * together in order.
+ *
+ * The splitter reads characters instead of tokens, which is a lot
+ * faster than parsing them. It only keeps track of what can hide the
+ * end of a statement from it: strings, comments, url()s, escapes,
+ * parentheses, square brackets and blocks. A '{' right after '@' starts
+ * a variable in a selector or property, not a block. A statement ends
+ * with a ';' or with the '}' of its block, unless a ';' follows the
+ * block, as it does after a detached ruleset.
+ *
+ * Where the splitter can not be sure how the tokenizer reads the
+ * source, such as a string that runs to the end of the line or a
+ * '}' that closes nothing, it gives up and the source is parsed in one
+ * piece.
+ */
+class StatementSplitter {
+public:
+  /**
+   * Split data into at most chunks chunks of at least minSize bytes,
+   * as far as the statements allow.
+   *
+   * @param offsets receives the offset of each chunk followed by the
+   *                size of the data, so chunk i is
+   *                [offsets[i], offsets[i + 1]).
+   * @return false if the data is too small to split or could not be
+   *         split reliably.
+   */
+  static bool split(const char *data,
+                    size_t size,
+                    unsigned int chunks,
+                    size_t minSize,
+                    std::vector<size_t> &offsets);
+
+private:
+  /**
+   * @return the character after the string that starts at p, or NULL
+   *         if the string does not end on the same line.
+   */
+  static const char *skipString(const char *p, const char *end);
+
+  /**
+   * @return the character after the comment that starts at p, or NULL
+   *         if it is not closed.
+   */
+  static const char *skipComment(const char *p, const char *end);
+
+  /**
+   * Whether the '(' at p follows the identifier <code>url</code>, so
+   * the tokenizer reads it as a url token.
+   */
+  static bool isUrl(const char *data, const char *p);
+
+  /**
+   * @return the character after the unquoted url that follows the '('
+   *         at p, p itself if the url is quoted, or NULL if the url
+   *         holds characters that the splitter does not expect.
+   */
+  static const char *skipUrl(const char *p, const char *end);
+
+  /**
+   * @return the character after the variable that follows the '{' at
+   *         p, or NULL if it is not a name followed by '}'.
+   */
+  static const char *skipInterpolation(const char *p, const char *end);
+};
+
+#endif  // __less_less_StatementSplitter_h__
@@ -0,0 +1,102 @@
+#ifndef __less_less_StylesheetCache_h__
+#define __less_less_StylesheetCache_h__
+
+#include <string>
+
+#include "less/SourceSet.h"
+#include "less/css/SourceBuffer.h"
+#include "less/less/ImportedFile.h"
+#include "less/lessstylesheet/LessStylesheet.h"
+
+/**
+ * Keeps parsed imported files in a directory, so that later
+ * compilations can load them instead of tokenizing and parsing them
+ * again.
+ *
+ * Each entry holds the segments and imports of an ImportedFile in a
+ * compact binary form: a table of the distinct strings followed by the
+ * statements, with every token stored as its type, string index and
+ * offset. Entries are named by a hash of the content of the file and
+ * the reference directive, and they record the size of the content and
+ * FORMAT_VERSION, so a file that changed, or a cache written by another
+ * version of the parser, is never used. Entries are memory-mapped when
+ * they are loaded.
+ *
+ * The blocks of rulesets in files imported with (reference) that have
+ * not been parsed yet are stored as their location in the file, to be
+ * parsed from the file when they are needed; see ReferenceRuleset.
+ *
+ * Files with a parse error, or with an @import that has to be followed
+ * in place (see ImportedFile::serial), are not cached.
+ *
+ * The same encoding is used for snapshots: a whole parsed stylesheet,
+ * typically a library of mixins and variables, written to a file of
+ * its own so that compilations that build on it can load it instead of
+ * parsing it.
+ */
+class StylesheetCache {
+public:
+  /**
+   * Has to change whenever the parser or the format changes what is
+   * stored.
+   */
+  static const unsigned int FORMAT_VERSION = 2;
+
+  /**
+   * The directory is created if it does not exist.
+   */
+  explicit StylesheetCache(const std::string &directory);
+  virtual ~StylesheetCache();
+
+  /**
+   * Fill file with the cached statements of the file with the given
+   * content. The tokens are assigned to file.sourceId, which has to be
+   * the source that content is registered as.
+   *
+   * @return false if there is no usable entry; file is left empty.
+   */
+  bool load(const SourceBuffer &content, bool reference, ImportedFile &file);
+
+  /**
+   * Store file, the result of parsing content. Failures to write are
+   * ignored.
+   */
+  void store(const SourceBuffer &content,
+             bool reference,
+             const ImportedFile &file);
+
+  /**
+   * Write the statements and top-level variables of stylesheet to a
+   * snapshot. The snapshot also records the files in sources, which
+   * are the files the statements were parsed from, with their size,
+   * modification time and line starts. Reference rulesets that have not
+   * been parsed yet are parsed first.
+   *
+   * @return false if the snapshot could not be written.
+   * @throws ParseException if a reference ruleset is malformed.
+   */
+  static bool writeSnapshot(const std::string &filename,
+                            const LessStylesheet &stylesheet,
+                            const SourceSet &sources);
+
+  /**
+   * Append the statements and variables in a snapshot to stylesheet,
+   * as if the files it was made from were imported, and add those
+   * files to sources. Tokens keep their locations, so error messages
+   * and source maps refer to the original files.
+   *
+   * @throws IOException if the snapshot can not be read, was made by
+   *         another version, or one of its files has changed since.
+   */
+  static void readSnapshot(const std::string &filename,
+                           LessStylesheet &stylesheet,
+                           SourceSet &sources);
+
+private:
+  std::string directory;
+
+  std::string getEntry(unsigned long long hash, bool reference) const;
+  static unsigned long long hash(const SourceBuffer &content);
+};
+
+#endif  // __less_less_StylesheetCache_h__
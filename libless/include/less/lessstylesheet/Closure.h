@@ -35,7 +35,7 @@ public:
 
   virtual const LessSelector &getLessSelector() const;
 
-  virtual const TokenList *getVariable(const std::string &key,
+  virtual const TokenList *getVariable(unsigned int atom,
                                        const ProcessingContext &context) const;
 
   bool isInStack(const LessRuleset &ruleset);
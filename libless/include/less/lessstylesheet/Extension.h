@@ -29,6 +29,12 @@ public:
 
   void updateSelector(Selector& s) const;
   void replaceInSelector(Selector& s) const;
+
+  /**
+   * Replaces one of the targets, compiled into a matcher, with each of
+   * the extension selectors.
+   */
+  void replaceInSelector(Selector& s, const TokenMatcher& target) const;
 };
 
 #endif  // __less_lessstylesheet_Extension_h__
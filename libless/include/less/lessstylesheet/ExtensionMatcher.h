@@ -0,0 +1,83 @@
+#ifndef __less_lessstylesheet_ExtensionMatcher_h__
+#define __less_lessstylesheet_ExtensionMatcher_h__
+
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "less/TokenMatcher.h"
+#include "less/lessstylesheet/Extension.h"
+#include "less/stylesheet/Selector.h"
+
+/**
+ * Applies a list of extensions to selectors.
+ *
+ * Calling Extension::updateSelector() for every extension and every
+ * ruleset compares each target with each selector. The matcher instead
+ * indexes the targets once: an <code>all</code> extension by one token
+ * that any match has to contain, other extensions by a hash of the
+ * whole target. A single pass over the tokens of a selector then finds
+ * the few extensions that can apply to it. Those are applied in the
+ * order of the list, with the targets already compiled into
+ * TokenMatchers, which gives the same result as applying every
+ * extension in turn.
+ */
+class ExtensionMatcher {
+private:
+  struct Entry {
+    const Extension* extension;
+    std::vector<TokenMatcher> targets;
+  };
+
+  std::vector<Entry> entries;
+
+  /**
+   * Key token of each target of an all extension -> entries.
+   */
+  std::unordered_map<size_t, std::vector<size_t> > tokenIndex;
+
+  /**
+   * Hash of each target of another extension -> entries.
+   */
+  std::unordered_map<size_t, std::vector<size_t> > selectorIndex;
+
+  /**
+   * Entries with a target that cannot be indexed; they are tried on
+   * every selector.
+   */
+  std::vector<size_t> unindexed;
+
+  /**
+   * The token of target that is most likely to be rare, or NULL if the
+   * target only holds whitespace.
+   */
+  static const Token* keyToken(const TokenList& target);
+
+  /**
+   * Hashes selector, ignoring whitespace and the child combinator ">"
+   * like Selector::match() does. Returns false if nothing is left to
+   * hash.
+   */
+  static bool matchHash(const TokenList& selector, size_t& hash);
+
+  /**
+   * Adds the entries from index <code>from</code> on that may apply to
+   * the selectors of s from index <code>first</code> on.
+   */
+  void findCandidates(const Selector& s,
+                      size_t first,
+                      size_t from,
+                      std::set<size_t>& candidates) const;
+  void apply(const Entry& entry, Selector& s) const;
+
+public:
+  explicit ExtensionMatcher(const std::list<Extension>& extensions);
+
+  /**
+   * Applies all extensions to s, in order.
+   */
+  void updateSelector(Selector& s) const;
+};
+
+#endif  // __less_lessstylesheet_ExtensionMatcher_h__
@@ -34,7 +34,7 @@ public:
                                  const Mixin &mixin,
                                  const ProcessingContext &context) const = 0;
 
-  virtual const TokenList *getVariable(const std::string &key,
+  virtual const TokenList *getVariable(unsigned int atom,
                                        const ProcessingContext &context) const = 0;
 
   virtual const LessSelector& getLessSelector() const = 0;
@@ -8,11 +8,21 @@ class LessRuleset;
 
 class LessDeclaration : public Declaration {
   LessRuleset *lessRuleset;
+  bool folded;
 
 public:
+  LessDeclaration();
+
   void setLessRuleset(LessRuleset &r);
   LessRuleset *getLessRuleset();
 
+  /**
+   * Replace the value with the result of evaluating it ahead of time,
+   * which process() then uses as it is; see ConstantFolder.
+   */
+  void setFolded(const TokenList &value);
+  bool isFolded() const;
+
   virtual void process(Ruleset &r, void* context) const;
 
 };
@@ -23,6 +23,8 @@ public:
   LessMediaQuery(const TokenList &selector, const LessStylesheet &parent);
   virtual ~LessMediaQuery();
 
+  virtual void setStylesheet(Stylesheet *s);
+
   TokenList &getSelector();
   const TokenList &getSelector() const;
   void setSelector(const TokenList &s);
@@ -32,7 +34,7 @@ public:
   virtual void getFunctions(std::list<const Function *> &functionList,
                             const Mixin &mixin,
                             const ProcessingContext &context) const;
-  virtual const TokenList *getVariable(const std::string &key,
+  virtual const TokenList *getVariable(unsigned int atom,
                                        const ProcessingContext &context) const;
 
   virtual void process(Stylesheet &s, void* context) const;
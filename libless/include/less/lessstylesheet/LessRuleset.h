@@ -23,6 +23,7 @@
 #include "less/lessstylesheet/ProcessingContext.h"
 #include "less/lessstylesheet/LessDeclaration.h"
 #include "less/lessstylesheet/LessAtRule.h"
+#include "less/lessstylesheet/RulesetIndex.h"
 
 class LessStylesheet;
 class MediaQueryRuleset;
@@ -32,6 +33,14 @@ class LessRuleset : public Ruleset, public Function {
 protected:
   VariableMap variables;
   std::list<LessRuleset *> nestedRules;
+
+  /**
+   * nestedRules by the first atom of their selectors. It is built by
+   * the first mixin lookup after the nested rules change.
+   */
+  mutable RulesetIndex nestedIndex;
+  mutable bool nestedIndexed;
+
   std::list<Closure *> closures;
   std::list<Extension> extensions;
 
@@ -69,9 +78,12 @@ public:
   
   virtual ~LessRuleset();
 
+  virtual void setStylesheet(Stylesheet *s);
+
   virtual const LessSelector& getLessSelector() const;
 
   void addExtension(Extension &extension);
+  const std::list<Extension> &getExtensions() const;
     
   LessDeclaration *createLessDeclaration();
   Mixin *createMixin(const TokenList &selector);
@@ -89,6 +101,14 @@ public:
 
   const list<LessRuleset *> &getNestedRules() const;
 
+  /**
+   * Adds the nested rules with a selector that can match the mixin
+   * name from offset to end to rules, in the order they were created.
+   */
+  void findNestedRules(TokenList::const_iterator offset,
+                       const TokenList::const_iterator &end,
+                       std::vector<LessRuleset *> &rules) const;
+
   void putVariable(const std::string &key, const TokenList &value);
   VariableMap &getVariables();
 
@@ -126,7 +146,7 @@ public:
                        const Selector *prefix,
                        ProcessingContext &context) const;
 
-  const TokenList* getVariable(const std::string& key,
+  const TokenList* getVariable(unsigned int atom,
                                const ProcessingContext &context) const ;
 
   virtual void getFunctions(list<const Function *> &functionList,
@@ -36,6 +36,7 @@ public:
   const std::list<Extension> &getExtensions() const;
   const std::list<std::string> &getParameters() const;
   const TokenList *getDefault(const std::string &parameter) const;
+  const std::list<TokenList> &getDefaults() const;
 
   const std::list<TokenList> &getConditions() const;
   bool matchArguments(const MixinArguments &arguments) const;
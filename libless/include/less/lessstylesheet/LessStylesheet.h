@@ -2,7 +2,6 @@
 #define __less_lessstylesheet_LessStylesheet_h__
 
 #include <list>
-#include <map>
 #include <string>
 
 #include "less/stylesheet/Stylesheet.h"
@@ -14,12 +13,17 @@
 #include "less/lessstylesheet/LessRuleset.h"
 #include "less/lessstylesheet/Mixin.h"
 #include "less/lessstylesheet/ProcessingContext.h"
+#include "less/lessstylesheet/RulesetIndex.h"
 
 class LessMediaQuery;
 
 class LessStylesheet : public Stylesheet {
 private:
-  std::multimap<TokenList, LessRuleset *> lessrulesets;
+  /**
+   * Rulesets by the first atom of their selectors, in the order they
+   * were created.
+   */
+  RulesetIndex lessrulesets;
 
   VariableMap variables;
 
@@ -28,6 +32,12 @@ public:
   virtual ~LessStylesheet();
 
   LessRuleset *createLessRuleset(LessSelector &selector);
+
+  /**
+   * Add a ruleset that was created elsewhere, such as a subclass of
+   * LessRuleset, as createLessRuleset() adds its rulesets.
+   */
+  void addLessRuleset(LessRuleset &ruleset);
   
   Mixin *createMixin(const TokenList &selector);
   LessAtRule *createLessAtRule(const Token &keyword);
@@ -37,6 +47,12 @@ public:
   void deleteLessRuleset(LessRuleset &ruleset);
   void deleteMixin(Mixin &mixin);
 
+  /**
+   * Moves the statements and variables of source to the end of this
+   * stylesheet, as if they had been parsed into it.
+   */
+  void merge(LessStylesheet &source);
+
   void putVariable(const std::string &key, const TokenList &value);
 
   virtual void getFunctions(std::list<const Function *> &functionList,
@@ -44,7 +60,8 @@ public:
                             const ProcessingContext &context) const;
 
   const TokenList *getVariable(const std::string &key) const;
-  virtual const TokenList *getVariable(const std::string &key,
+  const VariableMap &getVariables() const;
+  virtual const TokenList *getVariable(unsigned int atom,
                                        const ProcessingContext &context) const;
 
   virtual void process(Stylesheet &s, void *context) const;
@@ -20,6 +20,8 @@ public:
                     const LessRuleset& parent);
   virtual ~MediaQueryRuleset();
 
+  const TokenList &getMediaSelector() const;
+
   virtual void process(Stylesheet &s,
                        const Selector *prefix,
                        ProcessingContext &context) const;
@@ -29,6 +29,8 @@ public:
   Mixin(const TokenList &name, const LessRuleset &parent);
   virtual ~Mixin();
 
+  virtual void setStylesheet(Stylesheet *s);
+
   bool call(ProcessingContext &context,
             Ruleset *ruleset,
             Stylesheet *stylesheet) const;
@@ -18,6 +18,7 @@ public:
   
   const TokenList *get(const size_t i) const;
   const TokenList *get(const std::string &name) const;
+  const std::map<std::string, TokenList> &getNamedArguments() const;
 
   void add(TokenList &argument);
   void add(std::string name, TokenList &argument);
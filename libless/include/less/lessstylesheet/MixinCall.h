@@ -1,6 +1,7 @@
 #ifndef __less_lessstylesheet_MixinCall_h__
 #define __less_lessstylesheet_MixinCall_h__
 
+#include <list>
 #include "less/TokenList.h"
 #include "less/VariableMap.h"
 
@@ -20,7 +21,7 @@ public:
             bool savepoint = false,
             bool important = false);
 
-  const TokenList* getVariable(const std::string& key,
+  const TokenList* getVariable(unsigned int atom,
                                const ProcessingContext &context) const;
   void getFunctions(std::list<const Function*>& functionList,
                     const Mixin& mixin,
@@ -4,7 +4,11 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "less/Arena.h"
 #include "less/TokenList.h"
 #include "less/VariableMap.h"
 #include "less/lessstylesheet/Closure.h"
@@ -22,6 +26,13 @@ class LessStylesheet;
 
 class ProcessingContext : public ValueScope {
 private:
+  /**
+   * Owns the mixin call frames and closures. Closures keep a pointer
+   * to the frame they were created in, so neither can be freed before
+   * the compilation is done.
+   */
+  Arena arena;
+
   MixinCall *stack;
 
   ValueProcessor processor;
@@ -34,19 +45,90 @@ private:
   std::map<const Function*, VariableMap> variables;
   std::list<Closure *> base_closures;
   VariableMap base_variables;
+
+  /**
+   * Results of getVariable() by call frame and variable. A frame is
+   * never freed, and its own arguments are set before any variable is
+   * looked up in it, so a lookup in the same frame gives the same
+   * result until variables are returned from a mixin call or the
+   * stylesheet changes. Then the cache is cleared.
+   */
+  struct VariableCacheKey {
+    const MixinCall *frame;
+    unsigned int atom;
+
+    bool operator==(const VariableCacheKey &key) const {
+      return frame == key.frame && atom == key.atom;
+    }
+  };
+  struct VariableCacheHash {
+    size_t operator()(const VariableCacheKey &key) const {
+      return std::hash<const void *>()(key.frame) * 31 + key.atom;
+    }
+  };
+  mutable std::unordered_map<VariableCacheKey, const TokenList *,
+                             VariableCacheHash> variableCache;
+
+  /**
+   * Variable lookups, by the atom of the name and the definition the
+   * name resolved to.
+   */
+  typedef std::vector<std::pair<unsigned int, const TokenList *> >
+    Dependencies;
+
+  /**
+   * The last result of evaluating a variable definition. Variables are
+   * evaluated where they are used, so the result can be reused
+   * wherever the variables it looked up resolve to the same
+   * definitions, which also covers a later definition of one of them
+   * winning over an earlier one.
+   */
+  struct Evaluation {
+    Dependencies dependencies;
+    Value *value;
+    TokenList tokens;
+  };
+  mutable std::unordered_map<const TokenList *, Evaluation> evaluated;
+  mutable std::unordered_map<const TokenList *, Evaluation> processed;
+
+  /**
+   * The lookups of each evaluation in progress, innermost last.
+   */
+  mutable std::vector<Dependencies> recording;
+
+  bool isCurrent(const Evaluation &evaluation) const;
+  void endEvaluation(Evaluation &evaluation) const;
+  void clearCaches();
+
 public:
   ProcessingContext();
   virtual ~ProcessingContext();
 
+  /**
+   * Memory for objects that are needed until the end of the
+   * compilation.
+   */
+  Arena &getArena();
+
   void setLessStylesheet(const LessStylesheet &stylesheet);
   const LessStylesheet *getLessStylesheet() const;
 
-  virtual const TokenList *getVariable(const std::string &key) const;
+  using ValueScope::getVariable;
+  virtual const TokenList *getVariable(unsigned int atom) const;
+
+  virtual bool getEvaluated(const TokenList *variable,
+                            const Value *&value) const;
+  virtual const TokenList *getProcessed(const TokenList *variable) const;
+  virtual void beginEvaluation() const;
+  virtual void putEvaluated(const TokenList *variable, Value *value) const;
+  virtual void putProcessed(const TokenList *variable,
+                            const TokenList &value) const;
+  virtual void cancelEvaluation() const;
 
-  const TokenList *getFunctionVariable(const std::string &key,
+  const TokenList *getFunctionVariable(unsigned int atom,
                                        const Function* function) const;
 
-  const TokenList *getBaseVariable (const std::string &key) const;
+  const TokenList *getBaseVariable (unsigned int atom) const;
   
   
   void pushMixinCall(const Function &function,
@@ -81,6 +163,7 @@ public:
   void interpolate(Selector &selector) const;
   void interpolate(TokenList &tokens) const;
   void interpolate(std::string &str) const;
+  void interpolate(Token &token) const;
   void processValue(TokenList &value) const;
   bool validateCondition(const TokenList &value,
                          bool defaultVal = false) const;
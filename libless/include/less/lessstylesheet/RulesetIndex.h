@@ -0,0 +1,68 @@
+#ifndef __less_lessstylesheet_RulesetIndex_h__
+#define __less_lessstylesheet_RulesetIndex_h__
+
+#include <unordered_map>
+#include <vector>
+
+#include "less/TokenList.h"
+#include "less/stylesheet/Selector.h"
+
+class LessRuleset;
+
+/**
+ * Finds the rulesets of a scope that a mixin call can match.
+ *
+ * Walking the selector of every ruleset in a scope makes each mixin
+ * call cost as much as the scope is large. The index instead keys each
+ * ruleset by the first atom of each of its selectors, such as
+ * <code>.button</code> or <code>#ns</code>. A ruleset can only match a
+ * mixin name that starts with one of those atoms, so a lookup returns a
+ * few candidates that are then matched with Selector::walk(). As every
+ * LessRuleset indexes its nested rules, a namespaced name like
+ * <code>#ns > .mixin</code> is resolved one atom per level.
+ */
+class RulesetIndex {
+private:
+  /**
+   * The rulesets in the order they were added. Removed rulesets are
+   * set to NULL so the positions stay valid.
+   */
+  std::vector<LessRuleset *> rulesets;
+
+  /**
+   * First atom of each selector -> positions in rulesets, in
+   * ascending order.
+   */
+  std::unordered_map<TokenList, std::vector<size_t> > atoms;
+
+  /**
+   * Puts the first atom of the tokens from it on in key: a single
+   * token, or a '.' and the identifier after it. A leading child
+   * combinator is skipped like Selector::walk() skips it.
+   *
+   * @return true if key holds two tokens.
+   */
+  static bool firstAtom(TokenList::const_iterator it,
+                        const TokenList::const_iterator &end,
+                        TokenList &key);
+
+public:
+  void add(LessRuleset &ruleset);
+  void remove(const LessRuleset &ruleset);
+  void clear();
+
+  /**
+   * The rulesets that were added, in order.
+   */
+  void getRulesets(std::vector<LessRuleset *> &rulesets) const;
+
+  /**
+   * Adds the rulesets with a selector that can match the mixin name
+   * from offset to end to result, in the order they were added.
+   */
+  void find(TokenList::const_iterator offset,
+            const TokenList::const_iterator &end,
+            std::vector<LessRuleset *> &result) const;
+};
+
+#endif  // __less_lessstylesheet_RulesetIndex_h__
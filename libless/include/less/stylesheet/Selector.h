@@ -1,8 +1,9 @@
 #ifndef __less_stylesheet_Selector_h__
 #define __less_stylesheet_Selector_h__
 
-#include <list>
+#include <vector>
 #include "less/TokenList.h"
+#include "less/TokenMatcher.h"
 
 /**
  * If the selector contains commas then it is split up into multiple
@@ -10,8 +11,11 @@
  *
  * For example <code>p .class, a:hover</code> is split up into
  * <code>p .class</code> and <code>a:hover</code>.
+ *
+ * The selectors are stored contiguously; adding one invalidates
+ * iterators and references to the others.
  */
-class Selector: public std::list<TokenList> {
+class Selector: public std::vector<TokenList> {
 protected:
   
 public:
@@ -20,8 +24,8 @@ public:
 
   void appendSelector(const Selector &selector);
   
-  const TokenList::const_iterator walk(const TokenList::const_iterator &t_begin,
-                                       const TokenList::const_iterator &t_end) const;
+  TokenList::const_iterator walk(const TokenList::const_iterator &t_begin,
+                                 const TokenList::const_iterator &t_end) const;
 
   void walk(TokenList::const_iterator &it1,
             const TokenList::const_iterator &it1_end,
@@ -35,6 +39,13 @@ public:
               const TokenList::const_iterator end) const;
   bool replace(const TokenList &search,
                const TokenList &replace);
+  /**
+   * Adds a copy of each selector with every match of search replaced,
+   * including the selectors that were added; returns false if nothing
+   * matched.
+   */
+  bool replace(const TokenMatcher &search,
+               const TokenList &replace);
 
   void addPrefix(const Selector &prefix);
 
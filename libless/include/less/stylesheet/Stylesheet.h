@@ -29,6 +29,11 @@ protected:
   virtual void addAtRule(AtRule &rule);
   void deleteStatement(StylesheetStatement &statement);
 
+  /**
+   * Moves all statements of source to the end of this stylesheet.
+   */
+  void takeStatements(Stylesheet &source);
+
 public:
   Stylesheet() {
   }
@@ -46,6 +51,11 @@ public:
   void deleteAtRule(AtRule &atrule);
   void deleteMediaQuery(MediaQuery &query);
 
+  /**
+   * Delete all statements.
+   */
+  void clear();
+
   const std::list<AtRule *> &getAtRules() const;
   const std::list<Ruleset *> &getRulesets() const;
   const std::list<StylesheetStatement *> &getStatements() const;
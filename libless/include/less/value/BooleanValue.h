@@ -17,6 +17,8 @@ public:
   BooleanValue(const Token &t, bool value);
   virtual ~BooleanValue();
 
+  virtual Value *clone() const;
+
   bool getValue() const;
   void setValue(bool value);
 
@@ -92,6 +92,12 @@ private:
   float hsv[3];
   float alpha;
 
+  /**
+   * The tokens returned by getTokens() for colors that were computed
+   * instead of parsed; rebuilt on every call.
+   */
+  mutable TokenList generated;
+
   float maxArray(float* array, const size_t len) const;
   float minArray(float* array, const size_t len) const;
 
@@ -135,6 +141,8 @@ public:
   
   virtual ~Color();
 
+  virtual Value* clone() const;
+
   virtual Value* operator+(const Value& v) const;
   virtual Value* operator-(const Value& v) const;
   virtual Value* operator*(const Value& v) const;
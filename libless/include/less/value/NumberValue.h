@@ -19,6 +19,8 @@ public:
   NumberValue(const NumberValue &n);
   virtual ~NumberValue();
 
+  virtual Value *clone() const;
+
   static bool isNumber(const Value &val);
   double convert(const std::string &unit) const;
   
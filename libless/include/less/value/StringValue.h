@@ -24,6 +24,8 @@ public:
 
   virtual ~StringValue();
 
+  virtual Value *clone() const;
+
   std::string getString() const;
   void setString(const std::string &stringValue);
 
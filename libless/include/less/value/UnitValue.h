@@ -15,6 +15,8 @@ public:
   UnitValue(Token &token);
   virtual ~UnitValue();
 
+  virtual Value *clone() const;
+
   const char *getUnit() const;
 
   virtual Value *operator+(const Value &v) const;
@@ -31,6 +31,11 @@ public:
 
   void setLocation(const Token& ref);
 
+  /**
+   * Create a copy of the value that the caller owns.
+   */
+  virtual Value* clone() const = 0;
+
   virtual const TokenList* getTokens() const;
 
   virtual Value* operator+(const Value& v) const = 0;
@@ -0,0 +1,127 @@
+#ifndef __less_value_ValueExpression_h__
+#define __less_value_ValueExpression_h__
+
+#include <cstddef>
+#include <vector>
+#include "less/value/FunctionLibrary.h"
+#include "less/value/Value.h"
+
+/**
+ * A value parsed once by the ValueProcessor into a tree of constants,
+ * variables, functions and operations.
+ *
+ * Nodes refer to tokens by their position in the value, so the tree
+ * can be evaluated for any value with the same tokens and the results
+ * keep the source locations of that value. Functions are looked up in
+ * the FunctionLibrary when the value is parsed, and operations and
+ * functions on constants are evaluated then, except for the functions
+ * that ConstantFolder::isFoldable() excludes.
+ *
+ * A value holds up to three trees: one for processing it as a
+ * declaration value, one for evaluating it as a single statement, such
+ * as a variable, and one for evaluating it as a mixin guard. Each is
+ * parsed the first time it is needed. A value that can not be parsed
+ * ahead, for example because it contains a variable variable or a
+ * syntax error, is marked as such and left to the ValueProcessor.
+ */
+class ValueExpression {
+public:
+  static const size_t NONE = (size_t)-1;
+  static const size_t INVALID = (size_t)-2;
+
+  enum NodeType {
+    COLOR,
+    NUMBER,
+    VARIABLE,
+    STRING,
+    URL,
+    DEFAULT,
+    BOOLEAN,
+    UNIT,
+    COLOR_NAME,
+    // an identifier or a function argument that is not a value
+    LITERAL,
+    FUNCTION,
+    ESCAPE,
+    NEGATIVE,
+    SUBSTATEMENT,
+    OPERATION,
+    // an operation or function that was evaluated when it was parsed
+    CONSTANT
+  };
+
+  struct Node {
+    NodeType type;
+    /** The position of the token the node was parsed from. */
+    size_t token;
+    /**
+     * The operands of an operation, the operand of a negative or
+     * substatement, the position of the arguments of a function in the
+     * argument list and their number, or the position of a constant.
+     */
+    size_t first, second;
+    /** The operator of an operation, see ValueProcessor::Operator. */
+    int op;
+    /** The function of a function call. */
+    const FuncInfo *function;
+    /** default() takes the value passed to the guard. */
+    bool defaultVal;
+    /** The node does not depend on the scope. */
+    bool constant;
+  };
+
+  enum SegmentType {
+    // a statement
+    STATEMENT,
+    // a variable on its own, which may hold a list of values
+    VARIABLE_STATEMENT,
+    // tokens that are copied to the result
+    TOKENS
+  };
+
+  struct Segment {
+    SegmentType type;
+    /** The root of the statement. */
+    size_t node;
+    /** The tokens copied to the result. */
+    size_t begin, end;
+  };
+
+  enum State {
+    UNPARSED,
+    PARSED,
+    UNPARSABLE
+  };
+
+  std::vector<Node> nodes;
+  std::vector<size_t> arguments;
+  std::vector<Value *> constants;
+
+  State valueState;
+  std::vector<Segment> segments;
+
+  State statementState;
+  size_t statement;
+
+  State conditionState;
+  bool negate;
+  /**
+   * The statements joined by `and`. NONE stands for a missing
+   * statement, which is false.
+   */
+  std::vector<size_t> conditions;
+
+  ValueExpression();
+  virtual ~ValueExpression();
+
+  size_t addNode(NodeType type,
+                 size_t token,
+                 size_t first = NONE,
+                 size_t second = NONE);
+
+private:
+  ValueExpression(const ValueExpression &);
+  ValueExpression &operator=(const ValueExpression &);
+};
+
+#endif  // __less_value_ValueExpression_h__
@@ -3,6 +3,7 @@
 
 #include <cstring>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include "less/Token.h"
 #include "less/TokenList.h"
@@ -17,8 +18,15 @@
 #include "less/value/ValueException.h"
 #include "less/value/ValueScope.h"
 
+class ValueExpression;
+
 /**
+ * Evaluates values, variables and guards.
  *
+ * A value is parsed into a ValueExpression the first time it is
+ * processed, which is evaluated when the same tokens are processed
+ * again. Values that can not be parsed ahead, or that fail to evaluate
+ * that way, are interpreted token by token.
  */
 class ValueProcessor {
 public:
@@ -38,6 +46,95 @@ public:
 private:
   FunctionLibrary functionLibrary;
 
+  /**
+   * Number of parsed values that are kept, which bounds the memory a
+   * processor holds however many values it sees. Values that are seen
+   * after that are interpreted each time.
+   */
+  static const size_t MAX_EXPRESSIONS = 16384;
+
+  /**
+   * The parsed values, by their tokens.
+   */
+  mutable std::unordered_map<TokenList, ValueExpression *> expressions;
+
+  ValueProcessor(const ValueProcessor &);
+  ValueProcessor &operator=(const ValueProcessor &);
+
+  /**
+   * The parsed forms of the value, or NULL if there is no room for
+   * another one.
+   */
+  ValueExpression *getExpression(const TokenList &value) const;
+
+  void parseValue(const TokenList &value, ValueExpression &expression) const;
+  void parseSingleStatement(const TokenList &value,
+                            ValueExpression &expression) const;
+  void parseCondition(const TokenList &value,
+                      ValueExpression &expression) const;
+
+  /**
+   * The parse functions mirror the process functions below. They return
+   * the new node, ValueExpression::NONE if the process function would
+   * return NULL, or ValueExpression::INVALID if the value has to be
+   * interpreted.
+   */
+  size_t parseStatement(const TokenList &value,
+                        TokenList::const_iterator &i,
+                        ValueExpression &expression,
+                        bool defaultVal) const;
+  size_t parseOperation(const TokenList &value,
+                        TokenList::const_iterator &i,
+                        size_t operand1,
+                        ValueExpression &expression,
+                        Operator lastop,
+                        bool defaultVal) const;
+  size_t parseConstant(const TokenList &value,
+                       TokenList::const_iterator &i,
+                       ValueExpression &expression,
+                       bool defaultVal) const;
+  size_t parseSubstatement(const TokenList &value,
+                           TokenList::const_iterator &i,
+                           ValueExpression &expression,
+                           bool defaultVal) const;
+  size_t parseFunction(const TokenList &value,
+                       TokenList::const_iterator &i,
+                       ValueExpression &expression) const;
+
+  /**
+   * Evaluate the node now if it does not depend on the scope.
+   */
+  size_t foldNode(const TokenList &value,
+                  ValueExpression &expression,
+                  size_t node) const;
+
+  /**
+   * Evaluate a node of a parsed value.
+   *
+   * @return the value or NULL if the value has to be interpreted.
+   */
+  Value *evaluate(const ValueExpression &expression,
+                  size_t node,
+                  const TokenList &value,
+                  const ValueScope &scope,
+                  bool defaultVal) const;
+  bool evaluateValue(const ValueExpression &expression,
+                     const TokenList &value,
+                     TokenList &result,
+                     const ValueScope &scope) const;
+  bool evaluateCondition(const ValueExpression &expression,
+                         const TokenList &value,
+                         const ValueScope &scope,
+                         bool defaultVal,
+                         bool &result) const;
+
+  void interpretValue(TokenList &value, const ValueScope &scope) const;
+  Value *interpretStatement(const TokenList &tokens,
+                            const ValueScope &scope) const;
+  bool interpretCondition(const TokenList &value,
+                          const ValueScope &scope,
+                          bool defaultVal) const;
+
   Value *processStatement(const TokenList &tokens,
                           const ValueScope &scope) const;
 
@@ -66,6 +163,20 @@ private:
                              const ValueScope &scope,
                              bool defaultVal = false) const;
 
+  /**
+   * Evaluate a variable definition, reusing the value from the last
+   * time if the scope remembers it.
+   */
+  Value *processVariable(const TokenList &variable,
+                         const ValueScope &scope) const;
+  /**
+   * Process a variable that is not a single value and append it to
+   * value.
+   */
+  void appendVariable(const TokenList &variable,
+                      TokenList &value,
+                      const ValueScope &scope) const;
+
   const TokenList *processDeepVariable(TokenList::const_iterator &it,
                                        TokenList::const_iterator &end,
                                        const ValueScope &scope) const;
@@ -121,6 +232,7 @@ public:
   bool functionExists(const char *function) const;
 
   void interpolate(string &str, const ValueScope &scope) const;
+  void interpolate(Token &token, const ValueScope &scope) const;
   void interpolate(TokenList &tokens, const ValueScope &scope) const;
 };
 
@@ -4,11 +4,83 @@
 #include <list>
 #include <map>
 #include <string>
+#include "less/AtomTable.h"
 #include "less/TokenList.h"
+#include "less/value/Value.h"
 
 class ValueScope {
 public:
-  virtual const TokenList* getVariable(const std::string& key) const = 0;
+  /**
+   * Look up a variable by the atom of its name, see AtomTable.
+   */
+  virtual const TokenList* getVariable(unsigned int atom) const = 0;
+
+  inline const TokenList* getVariable(const Token& key) const {
+    unsigned int atom = key.getAtom();
+    
+    if (atom == AtomTable::NONE)
+      return getVariable((const std::string&)key);
+    return getVariable(atom);
+  }
+  inline const TokenList* getVariable(const std::string& key) const {
+    unsigned int atom = AtomTable::find(key);
+
+    if (atom == AtomTable::NONE)
+      return NULL;
+    return getVariable(atom);
+  }
+
+  /**
+   * Look up what a variable evaluated to the last time, if the
+   * variables it refers to still resolve to the same definitions in
+   * this scope. The default scope remembers nothing.
+   *
+   * @param variable  the variable as returned by getVariable().
+   * @param value     set to the remembered value, which is NULL if
+   *                  the variable is not a single value.
+   * @return true if a value was remembered.
+   */
+  virtual bool getEvaluated(const TokenList* variable,
+                            const Value*& value) const {
+    (void)variable;
+    (void)value;
+    return false;
+  }
+  /**
+   * Same as getEvaluated() for a variable that was processed with
+   * ValueProcessor::processValue() because it is not a single value.
+   */
+  virtual const TokenList* getProcessed(const TokenList* variable) const {
+    (void)variable;
+    return NULL;
+  }
+
+  /**
+   * Start recording the variables that are looked up while a variable
+   * is evaluated. Must be followed by putEvaluated(), putProcessed()
+   * or cancelEvaluation().
+   */
+  virtual void beginEvaluation() const {
+  }
+  /**
+   * Remember what a variable evaluated to. The scope takes ownership
+   * of the value.
+   */
+  virtual void putEvaluated(const TokenList* variable, Value* value) const {
+    (void)variable;
+    delete value;
+  }
+  virtual void putProcessed(const TokenList* variable,
+                            const TokenList& value) const {
+    (void)variable;
+    (void)value;
+  }
+  /**
+   * Stop recording without remembering anything, when the evaluation
+   * threw an exception.
+   */
+  virtual void cancelEvaluation() const {
+  }
 };
 
 #endif  // __tree_ValueScope_h__
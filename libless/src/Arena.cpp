@@ -0,0 +1,79 @@
+#include "less/Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+const size_t Arena::INITIAL_BLOCK_SIZE;
+
+Arena::Arena()
+    : blocks(NULL), destructors(NULL), current(NULL), limit(NULL),
+      allocated(0) {
+}
+
+Arena::~Arena() {
+  release();
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(current);
+  size_t padding = (alignment - address % alignment) % alignment;
+
+  if (current == NULL || padding + size > size_t(limit - current)) {
+    addBlock(size + alignment);
+    address = reinterpret_cast<uintptr_t>(current);
+    padding = (alignment - address % alignment) % alignment;
+  }
+
+  current += padding;
+  void* memory = current;
+  current += size;
+  return memory;
+}
+
+void Arena::release() {
+  Block* next;
+
+  // Objects may refer to objects made before them, so destroy the
+  // newest first.
+  while (destructors != NULL) {
+    destructors->destroy(destructors->object);
+    destructors = destructors->next;
+  }
+
+  while (blocks != NULL) {
+    next = blocks->next;
+    ::operator delete(blocks);
+    blocks = next;
+  }
+  current = limit = NULL;
+  allocated = 0;
+}
+
+size_t Arena::getBytesAllocated() const {
+  return allocated;
+}
+
+void Arena::addBlock(size_t minimum) {
+  size_t size = (blocks == NULL) ? INITIAL_BLOCK_SIZE : blocks->size * 2;
+  Block* block;
+
+  size = std::max(size, minimum + sizeof(Block));
+  block = static_cast<Block*>(::operator new(size));
+  block->next = blocks;
+  block->size = size;
+  blocks = block;
+  allocated += size;
+
+  current = reinterpret_cast<char*>(block) + sizeof(Block);
+  limit = reinterpret_cast<char*>(block) + size;
+}
+
+void Arena::addDestructor(void (*destroy)(void*), void* object) {
+  Destructor* d = static_cast<Destructor*>(
+      allocate(sizeof(Destructor), alignof(Destructor)));
+
+  d->destroy = destroy;
+  d->object = object;
+  d->next = destructors;
+  destructors = d;
+}
@@ -0,0 +1,84 @@
+#include "less/AtomTable.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+const unsigned int AtomTable::NONE;
+const size_t AtomTable::TOKEN_LIMIT;
+
+AtomTable::AtomTable() : count(0) {
+  static const std::string empty;
+
+  std::fill(blocks, blocks + MAX_BLOCKS, (const std::string**)NULL);
+  blocks[0] = new const std::string*[BLOCK_SIZE];
+  blocks[0][NONE] = &empty;
+  count.store(NONE + 1);
+}
+
+AtomTable& AtomTable::getInstance() {
+  // Constructed on first use; tokens can be compared during static
+  // initialization.
+  static AtomTable table;
+  return table;
+}
+
+unsigned int AtomTable::add(const std::string& str, bool limited) {
+  if (str.empty())
+    return NONE;
+
+  Shard& shard = shards[std::hash<std::string>()(str) % SHARDS];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  std::unordered_map<std::string, unsigned int>::iterator it =
+      shard.atoms.find(str);
+  unsigned int atom;
+
+  if (it != shard.atoms.end())
+    return it->second;
+  if (limited && count.load(std::memory_order_relaxed) >= TOKEN_LIMIT)
+    return NONE;
+
+  std::lock_guard<std::mutex> ids(mutex);
+
+  atom = count.load(std::memory_order_relaxed);
+  if (atom / BLOCK_SIZE >= MAX_BLOCKS)
+    throw std::length_error("too many atoms");
+  if (blocks[atom / BLOCK_SIZE] == NULL)
+    blocks[atom / BLOCK_SIZE] = new const std::string*[BLOCK_SIZE];
+
+  // Keys of an unordered_map stay in place when it rehashes.
+  it = shard.atoms.insert(std::make_pair(str, atom)).first;
+  blocks[atom / BLOCK_SIZE][atom % BLOCK_SIZE] = &it->first;
+  count.store(atom + 1, std::memory_order_release);
+  return atom;
+}
+
+unsigned int AtomTable::intern(const std::string& str) {
+  return getInstance().add(str, false);
+}
+
+unsigned int AtomTable::lookup(const std::string& str) {
+  return getInstance().add(str, true);
+}
+
+unsigned int AtomTable::find(const std::string& str) {
+  AtomTable& t = getInstance();
+  Shard& shard = t.shards[std::hash<std::string>()(str) % SHARDS];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  std::unordered_map<std::string, unsigned int>::const_iterator it =
+      shard.atoms.find(str);
+
+  return it != shard.atoms.end() ? it->second : NONE;
+}
+
+const std::string& AtomTable::getString(unsigned int atom) {
+  AtomTable& t = getInstance();
+
+  if (atom >= t.count.load(std::memory_order_acquire))
+    atom = NONE;
+  return *t.blocks[atom / BLOCK_SIZE][atom % BLOCK_SIZE];
+}
+
+size_t AtomTable::size() {
+  return getInstance().count.load(std::memory_order_acquire);
+}
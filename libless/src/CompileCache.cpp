@@ -0,0 +1,183 @@
+#include "less/CompileCache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "less/SourceRegistry.h"
+
+namespace {
+
+const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+
+/**
+ * 64-bit FNV-1a, continued from h.
+ */
+unsigned long long fnv1a(const char *data,
+                        size_t size,
+                        unsigned long long h = FNV_OFFSET) {
+  const unsigned char *p = (const unsigned char *)data;
+  const unsigned char *end = p + size;
+
+  for (; p != end; p++) {
+    h ^= *p;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+bool hashFile(const std::string &path, unsigned long long &h) {
+  SourceBuffer content;
+
+  if (!content.open(path.c_str()))
+    return false;
+  h = fnv1a(content.getData(), content.getSize());
+  return true;
+}
+
+/**
+ * A file is unchanged if it has the recorded size and either the
+ * recorded modification time or the recorded hash. A time of 0 is
+ * never taken as a match.
+ */
+bool isUnchanged(const std::string &path,
+                 unsigned long long size,
+                 unsigned long long mtime,
+                 unsigned long long h) {
+  struct stat st;
+  unsigned long long current;
+
+  if (stat(path.c_str(), &st) != 0 || (unsigned long long)st.st_size != size)
+    return false;
+  if (mtime != 0 && (unsigned long long)st.st_mtime == mtime)
+    return true;
+  return hashFile(path, current) && current == h;
+}
+
+void writeBlock(std::ostream &out, const std::string &s) {
+  out << s.size() << '\n';
+  out.write(s.data(), s.size());
+}
+
+bool readBlock(std::istream &in, std::string &s) {
+  size_t length;
+
+  if (!(in >> length) || in.get() != '\n')
+    return false;
+  s.resize(length);
+  return length == 0 || in.read(&s[0], length);
+}
+
+}  // namespace
+
+CompileCache::CompileCache(const std::string &directory,
+                           const std::string &key,
+                           const SourceBuffer &content)
+    : key(key), content(content) {
+  unsigned long long h = fnv1a(key.data(), key.size());
+  char name[32];
+
+  h = fnv1a(content.getData(), content.getSize(), h);
+  std::snprintf(name, sizeof(name), "/%016llx.out", h);
+
+  mkdir(directory.c_str(), 0777);
+  entry = directory + name;
+  started = std::time(NULL);
+}
+
+CompileCache::~CompileCache() {
+}
+
+const std::string &CompileCache::getEntry() const {
+  return entry;
+}
+
+bool CompileCache::load(std::string &css,
+                        std::string &sourcemap,
+                        std::string &messages) {
+  std::ifstream in(entry.c_str(), std::ios::binary);
+  std::string magic, path, stored;
+  unsigned int version;
+  size_t n;
+  unsigned long long size, mtime, h;
+
+  if (!(in >> magic >> version) || magic != "LCC" ||
+      version != FORMAT_VERSION || in.get() != '\n') {
+    return false;
+  }
+
+  // The name is only a hash; the entry has to be for this compilation.
+  if (!readBlock(in, stored) || stored != key || !readBlock(in, stored) ||
+      stored.size() != content.getSize() ||
+      stored.compare(0, stored.size(), content.getData(),
+                     content.getSize()) != 0 ||
+      !(in >> n)) {
+    return false;
+  }
+
+  while (n-- > 0) {
+    if (!(in >> size >> mtime >> h) || in.get() != ' ' ||
+        !std::getline(in, path) || !isUnchanged(path, size, mtime, h)) {
+      return false;
+    }
+  }
+  return readBlock(in, css) && readBlock(in, sourcemap) &&
+         readBlock(in, messages);
+}
+
+void CompileCache::store(const SourceSet &sources,
+                         const std::string &css,
+                         const std::string &sourcemap,
+                         const std::string &messages) {
+  std::ostringstream tmp;
+  std::string path;
+  const SourceBuffer *read;
+  struct stat st;
+  unsigned long long h, mtime;
+  size_t i;
+
+  if (sources.size() == 0)
+    return;
+
+  tmp << entry << ".tmp" << getpid();
+  std::ofstream out(tmp.str().c_str(), std::ios::binary);
+
+  out << "LCC " << FORMAT_VERSION << '\n';
+  writeBlock(out, key);
+  writeBlock(out, std::string(content.getData(), content.getSize()));
+  out << sources.size() - 1 << '\n';
+  for (i = 1; i < sources.size(); i++) {
+    path = SourceRegistry::getPath(sources.getSourceId(i));
+    read = SourceRegistry::getContent(sources.getSourceId(i));
+
+    if (path.find('\n') != std::string::npos ||
+        stat(path.c_str(), &st) != 0 ||
+        (read == NULL && !hashFile(path, h))) {
+      out.close();
+      std::remove(tmp.str().c_str());
+      return;
+    }
+    // Hash what was compiled rather than what is on disk now.
+    if (read != NULL)
+      h = fnv1a(read->getData(), read->getSize());
+
+    // A file modified after the compilation started may have changed
+    // after it was read without its time changing, so load() has to
+    // hash it.
+    mtime = st.st_mtime < started ? st.st_mtime : 0;
+
+    out << (unsigned long long)st.st_size << ' ' << mtime << ' ' << h << ' '
+        << path << '\n';
+  }
+  writeBlock(out, css);
+  writeBlock(out, sourcemap);
+  writeBlock(out, messages);
+  out.close();
+
+  if (!out.good() || std::rename(tmp.str().c_str(), entry.c_str()) != 0)
+    std::remove(tmp.str().c_str());
+}
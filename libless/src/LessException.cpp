@@ -6,7 +6,12 @@ LessException::LessException(unsigned int line,
   source(source), line(line), column(column) {
 }
 LessException::LessException(const Token& token) :
-  source(token.source), line(token.line), column(token.column) {
+  source(token.getSource()) {
+  SourceRegistry::getLocation(token.sourceId, token.offset, line, column);
+}
+LessException::LessException(unsigned int sourceId, unsigned int offset) :
+  source(SourceRegistry::getName(sourceId)) {
+  SourceRegistry::getLocation(sourceId, offset, line, column);
 }
 
 
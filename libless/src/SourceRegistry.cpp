@@ -0,0 +1,223 @@
+#include "less/SourceRegistry.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "less/Token.h"
+
+SourceRegistry::SourceRegistry() : count(0) {
+  std::fill(blocks, blocks + MAX_BLOCKS, (Source*)NULL);
+  addSource(Token::BUILTIN_SOURCE, Token::BUILTIN_SOURCE, NULL);
+  addSource("generated", "generated", NULL);
+  names[Token::BUILTIN_SOURCE] = BUILTIN;
+  names["generated"] = GENERATED;
+}
+
+SourceRegistry& SourceRegistry::getInstance() {
+  // Constructed on first use; tokens can be created during static
+  // initialization.
+  static SourceRegistry registry;
+  return registry;
+}
+
+SourceRegistry::Source* SourceRegistry::get(unsigned int id) {
+  if (id >= count.load(std::memory_order_acquire))
+    return NULL;
+  return &blocks[id / BLOCK_SIZE][id % BLOCK_SIZE];
+}
+
+unsigned int SourceRegistry::addSource(const char* name,
+                                       const std::string& path,
+                                       SourceBuffer* content,
+                                       const Index* index) {
+  unsigned int id = count.load(std::memory_order_relaxed);
+  Source* source;
+
+  if (id / BLOCK_SIZE >= MAX_BLOCKS)
+    throw std::length_error("too many sources");
+  if (blocks[id / BLOCK_SIZE] == NULL)
+    blocks[id / BLOCK_SIZE] = new Source[BLOCK_SIZE];
+
+  source = &blocks[id / BLOCK_SIZE][id % BLOCK_SIZE];
+  source->name = name;
+  source->path = path;
+  source->content = content;
+  source->index.store(index, std::memory_order_relaxed);
+
+  // Publish the source to lookups.
+  count.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+unsigned int SourceRegistry::add(const char* name, SourceBuffer* content) {
+  SourceRegistry& r = getInstance();
+  std::string path = canonicalPath(name);
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  return r.addSource(name, path, content);
+}
+
+unsigned int SourceRegistry::add(const char* name,
+                                 const std::string& path,
+                                 const std::vector<unsigned int>& lines) {
+  SourceRegistry& r = getInstance();
+  Index* index = new Index();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  index->lines = lines;
+  index->indexed = 0;
+  return r.addSource(name, path, NULL, index);
+}
+
+unsigned int SourceRegistry::getId(const char* name) {
+  SourceRegistry& r = getInstance();
+  std::map<std::string, unsigned int>::iterator i;
+
+  if (name == NULL)
+    return GENERATED;
+
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  i = r.names.find(name);
+  if (i != r.names.end())
+    return i->second;
+
+  return r.names[name] = r.addSource(name, name, NULL);
+}
+
+const char* SourceRegistry::getName(unsigned int id) {
+  Source* source = getInstance().get(id);
+
+  if (source == NULL)
+    return Token::BUILTIN_SOURCE;
+  return source->name;
+}
+
+const std::string& SourceRegistry::getPath(unsigned int id) {
+  SourceRegistry& r = getInstance();
+  Source* source = r.get(id);
+
+  if (source == NULL)
+    source = r.get(BUILTIN);
+  return source->path;
+}
+
+bool SourceRegistry::hasContent(unsigned int id) {
+  Source* source = getInstance().get(id);
+
+  return source != NULL && source->content != NULL;
+}
+
+const SourceBuffer* SourceRegistry::getContent(unsigned int id) {
+  Source* source = getInstance().get(id);
+
+  if (source == NULL)
+    return NULL;
+  return source->content;
+}
+
+std::string SourceRegistry::canonicalPath(const char* filename) {
+  char resolved[PATH_MAX];
+
+  if (realpath(filename, resolved) == NULL)
+    return filename;
+  return resolved;
+}
+
+const SourceRegistry::Index* SourceRegistry::getIndex(Source& source) {
+  const Index* index = source.index.load(std::memory_order_acquire);
+  Index* updated;
+  const char *data, *p, *end;
+  size_t size;
+
+  if (source.content == NULL ||
+      (index != NULL && index->indexed >= source.content->getSize())) {
+    return index;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Another thread may have built the index meanwhile.
+  index = source.index.load(std::memory_order_relaxed);
+  data = source.content->getData();
+  size = source.content->getSize();
+  if (index != NULL && index->indexed >= size)
+    return index;
+
+  // Streams are read in blocks, so more content may have arrived since
+  // the last lookup. The old index is kept, it may still be in use.
+  updated = new Index();
+  if (index != NULL) {
+    updated->lines = index->lines;
+    source.replaced.push_back(index);
+  }
+  p = data + (index != NULL ? index->indexed : 0);
+  end = data + size;
+
+  while (p != end &&
+         (p = (const char*)std::memchr(p, '\n', end - p)) != NULL) {
+    p++;
+    updated->lines.push_back(p - data);
+  }
+  updated->indexed = size;
+
+  source.index.store(updated, std::memory_order_release);
+  return updated;
+}
+
+void SourceRegistry::getLocation(unsigned int id,
+                                 unsigned int offset,
+                                 unsigned int& line,
+                                 unsigned int& column) {
+  SourceRegistry& r = getInstance();
+  Source* source = r.get(id);
+  const Index* index;
+  std::vector<unsigned int>::const_iterator i;
+
+  line = 0;
+  column = offset;
+
+  if (source == NULL || (index = r.getIndex(*source)) == NULL)
+    return;
+
+  i = std::upper_bound(index->lines.begin(), index->lines.end(), offset);
+  line = i - index->lines.begin();
+  if (line > 0)
+    column = offset - index->lines[line - 1];
+
+  // The character at offset is a newline if the next line starts
+  // right after it.
+  if (i != index->lines.end() && *i == offset + 1 && column > 0)
+    column--;
+}
+
+void SourceRegistry::getLines(unsigned int id,
+                              std::vector<unsigned int>& lines) {
+  SourceRegistry& r = getInstance();
+  Source* source = r.get(id);
+  const Index* index;
+
+  lines.clear();
+  if (source != NULL && (index = r.getIndex(*source)) != NULL)
+    lines = index->lines;
+}
+
+void SourceRegistry::release(unsigned int id) {
+  SourceRegistry& r = getInstance();
+  Source* source = r.get(id);
+  std::vector<const Index*>::iterator it;
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  if (source == NULL || id == BUILTIN || id == GENERATED)
+    return;
+
+  delete source->content;
+  source->content = NULL;
+  delete source->index.exchange(NULL);
+  for (it = source->replaced.begin(); it != source->replaced.end(); it++)
+    delete *it;
+  source->replaced.clear();
+}
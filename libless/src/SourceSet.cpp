@@ -0,0 +1,57 @@
+#include "less/SourceSet.h"
+
+SourceSet::SourceSet() {
+}
+
+SourceSet::~SourceSet() {
+}
+
+size_t SourceSet::add(unsigned int sourceId) {
+  std::pair<std::unordered_map<std::string, size_t>::iterator, bool> ret;
+
+  ret = paths.insert(
+      std::make_pair(SourceRegistry::getPath(sourceId), files.size()));
+  if (ret.second)
+    files.push_back(sourceId);
+
+  if (sourceId >= indices.size())
+    indices.resize(sourceId + 1, 0);
+  indices[sourceId] = ret.first->second + 1;
+
+  return ret.first->second;
+}
+
+bool SourceSet::contains(const char* filename) const {
+  return paths.find(SourceRegistry::canonicalPath(filename)) != paths.end();
+}
+
+bool SourceSet::containsPath(const std::string& path) const {
+  return paths.find(path) != paths.end();
+}
+
+size_t SourceSet::indexOf(unsigned int sourceId) const {
+  if (sourceId >= indices.size() || indices[sourceId] == 0)
+    return files.size();
+  return indices[sourceId] - 1;
+}
+
+size_t SourceSet::size() const {
+  return files.size();
+}
+
+const char* SourceSet::getName(size_t index) const {
+  return SourceRegistry::getName(files[index]);
+}
+
+unsigned int SourceSet::getSourceId(size_t index) const {
+  return files[index];
+}
+
+void SourceSet::release() {
+  unsigned int id;
+
+  for (id = 0; id < indices.size(); id++) {
+    if (indices[id] != 0)
+      SourceRegistry::release(id);
+  }
+}
@@ -2,41 +2,79 @@
 
 char Token::BUILTIN_SOURCE[8] = "builtin";
 
-const Token Token::BUILTIN_SPACE(" ", Token::WHITESPACE, 0, 0, BUILTIN_SOURCE);
-const Token Token::BUILTIN_COMMA(",", Token::OTHER, 0, 0, BUILTIN_SOURCE);
+const Token Token::BUILTIN_SPACE(" ",
+                                 Token::WHITESPACE,
+                                 SourceRegistry::BUILTIN,
+                                 0);
+const Token Token::BUILTIN_COMMA(",", Token::OTHER, SourceRegistry::BUILTIN, 0);
 const Token Token::BUILTIN_PAREN_OPEN(
-    "(", Token::PAREN_OPEN, 0, 0, BUILTIN_SOURCE);
+    "(", Token::PAREN_OPEN, SourceRegistry::BUILTIN, 0);
 const Token Token::BUILTIN_PAREN_CLOSED(
-    ")", Token::PAREN_CLOSED, 0, 0, BUILTIN_SOURCE);
+    ")", Token::PAREN_CLOSED, SourceRegistry::BUILTIN, 0);
 
-const Token Token::BUILTIN_IMPORTANT("!important", Token::IDENTIFIER, 0,0, BUILTIN_SOURCE);
+const Token Token::BUILTIN_IMPORTANT("!important",
+                                     Token::IDENTIFIER,
+                                     SourceRegistry::BUILTIN,
+                                     0);
 
-Token::Token() : line(0), column(0), source(BUILTIN_SOURCE), type(OTHER) {
+Token::Token()
+    : offset(0),
+      sourceId(SourceRegistry::BUILTIN),
+      type(OTHER),
+      atom(AtomTable::NONE) {
 }
 
-Token::Token(unsigned int line, unsigned int column, const char *source)
-    : line(line), column(column), source(source), type(OTHER) {
+Token::Token(const std::string &s,
+             Type t,
+             unsigned int sourceId,
+             unsigned int offset)
+    : std::string(s),
+      offset(offset),
+      sourceId(sourceId),
+      type(t),
+      atom(AtomTable::NONE) {
 }
 
 Token::Token(const std::string &s,
              Type t,
-             unsigned int line,
+             unsigned int /* line */,
              unsigned int column,
              const char *source)
-    : line(line), column(column), source(source) {
-  type = t;
-  append(s);
+    : std::string(s), offset(column), type(t), atom(AtomTable::NONE) {
+  sourceId = SourceRegistry::getId(source);
 }
 
 void Token::setLocation(const Token &ref) {
-  line = ref.line;
-  column = ref.column;
-  source = ref.source;
+  offset = ref.offset;
+  sourceId = ref.sourceId;
+}
+
+unsigned int Token::getLine() const {
+  unsigned int line, column;
+
+  SourceRegistry::getLocation(sourceId, offset, line, column);
+  return line;
+}
+
+unsigned int Token::getColumn() const {
+  unsigned int line, column;
+
+  SourceRegistry::getLocation(sourceId, offset, line, column);
+  return column;
+}
+
+const char *Token::getSource() const {
+  return SourceRegistry::getName(sourceId);
+}
+
+size_t Token::hash() const {
+  return std::hash<std::string>()(*this) * 31 + type;
 }
 
 void Token::clear() {
   std::string::clear();
   type = OTHER;
+  atom = AtomTable::NONE;
 }
 
 bool Token::stringHasQuotes() const {
@@ -44,7 +82,8 @@ bool Token::stringHasQuotes() const {
 }
 
 void Token::removeQuotes() {
-  removeQuotes(*this);
+  atom = AtomTable::NONE;
+  removeQuotes(static_cast<std::string &>(*this));
 }
 
 void Token::removeQuotes(std::string &str) const {
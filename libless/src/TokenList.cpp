@@ -1,26 +1,208 @@
 #include "less/TokenList.h"
 
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// std::vector moves its lists when it grows only if they can not throw,
+// otherwise it copies every token. Selector is a vector of TokenLists.
+static_assert(std::is_nothrow_move_constructible<TokenList>::value,
+              "TokenList has to be nothrow move constructible");
+static_assert(std::is_nothrow_move_assignable<TokenList>::value,
+              "TokenList has to be nothrow move assignable");
+
+TokenList::TokenList()
+    : tokensBegin(getBuffer()),
+      tokensEnd(getBuffer()),
+      capacityEnd(getBuffer() + INLINE_CAPACITY) {
+}
+
+TokenList::TokenList(const TokenList& tokens) : TokenList() {
+  insert(end(), tokens.begin(), tokens.end());
+}
+
+TokenList::TokenList(TokenList&& tokens) noexcept : TokenList() {
+  moveFrom(tokens);
+}
+
+TokenList::TokenList(const_iterator first, const_iterator last)
+    : TokenList() {
+  insert(end(), first, last);
+}
+
 TokenList::~TokenList() {
+  clear();
+  release();
 }
 
-void TokenList::ltrim() {
-  while (!empty() && front().type == Token::WHITESPACE) {
-    pop_front();
+TokenList& TokenList::operator=(const TokenList& tokens) {
+  if (this != &tokens) {
+    clear();
+    insert(end(), tokens.begin(), tokens.end());
+  }
+  return *this;
+}
+
+TokenList& TokenList::operator=(TokenList&& tokens) noexcept {
+  if (this != &tokens) {
+    clear();
+    release();
+    moveFrom(tokens);
+  }
+  return *this;
+}
+
+void TokenList::push_back(const Token& token) {
+  if (tokensEnd == capacityEnd) {
+    // token may be part of this list.
+    Token copy(token);
+    grow(size() + 1);
+    new (tokensEnd) Token(std::move(copy));
+  } else
+    new (tokensEnd) Token(token);
+  tokensEnd++;
+}
+
+void TokenList::push_back(Token&& token) {
+  if (tokensEnd == capacityEnd) {
+    Token copy(std::move(token));
+    grow(size() + 1);
+    new (tokensEnd) Token(std::move(copy));
+  } else
+    new (tokensEnd) Token(std::move(token));
+  tokensEnd++;
+}
+
+void TokenList::pop_back() {
+  tokensEnd--;
+  tokensEnd->~Token();
+}
+
+void TokenList::push_front(const Token& token) {
+  insert(begin(), token);
+}
+
+void TokenList::pop_front() {
+  erase(begin());
+}
+
+TokenList::iterator TokenList::insert(const_iterator position,
+                                      const Token& token) {
+  size_t index = position - tokensBegin;
+
+  push_back(token);
+  std::rotate(tokensBegin + index, tokensEnd - 1, tokensEnd);
+  return tokensBegin + index;
+}
+
+TokenList::iterator TokenList::insert(const_iterator position,
+                                      const_iterator first,
+                                      const_iterator last) {
+  size_t index = position - tokensBegin;
+  size_t n = last - first;
+  Token* oldEnd;
+
+  if (first >= tokensBegin && first < tokensEnd) {
+    TokenList copy(first, last);
+    return insert(position, copy.begin(), copy.end());
   }
+
+  if (size() + n > capacity())
+    grow(size() + n);
+
+  oldEnd = tokensEnd;
+  for (; first != last; first++, tokensEnd++)
+    new (tokensEnd) Token(*first);
+
+  // Tokens are strings, so rotating swaps pointers instead of copying
+  // characters.
+  std::rotate(tokensBegin + index, oldEnd, tokensEnd);
+  return tokensBegin + index;
+}
+
+TokenList::iterator TokenList::erase(const_iterator position) {
+  return erase(position, position + 1);
+}
+
+TokenList::iterator TokenList::erase(const_iterator first,
+                                     const_iterator last) {
+  Token* start = tokensBegin + (first - tokensBegin);
+  Token* newEnd;
+
+  if (first == last)
+    return start;
+
+  newEnd = std::move(start + (last - first), tokensEnd, start);
+  while (tokensEnd != newEnd)
+    pop_back();
+  return start;
+}
+
+void TokenList::clear() {
+  while (tokensEnd != tokensBegin)
+    pop_back();
+}
+
+void TokenList::reserve(size_t n) {
+  if (n > capacity())
+    reallocate(n);
+}
+
+void TokenList::swap(TokenList& tokens) {
+  TokenList tmp(std::move(tokens));
+
+  tokens = std::move(*this);
+  *this = std::move(tmp);
+}
+
+bool TokenList::operator==(const TokenList& tokens) const {
+  return size() == tokens.size() &&
+         std::equal(begin(), end(), tokens.begin());
+}
+
+bool TokenList::operator<(const TokenList& tokens) const {
+  return std::lexicographical_compare(
+      begin(), end(), tokens.begin(), tokens.end());
+}
+
+size_t TokenList::hash() const {
+  size_t h = size();
+  const_iterator it;
+
+  for (it = begin(); it != end(); it++)
+    h = h * 1000003 ^ (*it).hash();
+  return h;
+}
+
+void TokenList::ltrim() {
+  iterator it = begin();
+
+  while (it != end() && (*it).type == Token::WHITESPACE)
+    it++;
+  erase(begin(), it);
 }
+
 void TokenList::rtrim() {
   while (!empty() && back().type == Token::WHITESPACE) {
     pop_back();
   }
 }
+
 void TokenList::trim() {
-  ltrim();
   rtrim();
+  ltrim();
 }
 
 std::string TokenList::toString() const {
   std::string str;
-  std::list<Token>::const_iterator it;
+  const_iterator it;
+  size_t length = 0;
+
+  for (it = begin(); it != end(); it++) {
+    length += (*it).size();
+  }
+  str.reserve(length);
 
   for (it = begin(); it != end(); it++) {
     str.append(*it);
@@ -28,12 +210,12 @@ std::string TokenList::toString() const {
   return str;
 }
 
-bool TokenList::contains(const Token &t) const {
+bool TokenList::contains(const Token& t) const {
   return (find(t, begin()) != end());
 }
 
-bool TokenList::contains(Token::Type type, const std::string &str) const {
-  std::list<Token>::const_iterator it;
+bool TokenList::contains(Token::Type type, const std::string& str) const {
+  const_iterator it;
 
   for (it = begin(); it != end(); it++) {
     if ((*it).type == type && *it == str)
@@ -43,7 +225,7 @@ bool TokenList::contains(Token::Type type, const std::string &str) const {
 }
 
 bool TokenList::containsType(Token::Type type) const {
-  std::list<Token>::const_iterator it;
+  const_iterator it;
 
   for (it = begin(); it != end(); it++) {
     if ((*it).type == type)
@@ -52,8 +234,8 @@ bool TokenList::containsType(Token::Type type) const {
   return false;
 }
 
-TokenList::const_iterator TokenList::find(const Token &search,
-                                    TokenList::const_iterator offset) const {
+TokenList::const_iterator TokenList::find(const Token& search,
+                                          const_iterator offset) const {
   for (; offset != end(); offset++) {
     if (*offset == search)
       return offset;
@@ -61,10 +243,10 @@ TokenList::const_iterator TokenList::find(const Token &search,
   return end();
 }
 
-TokenList::const_iterator TokenList::find(const TokenList &search,
-                                          TokenList::const_iterator &offset) const {
-  TokenList::const_iterator it, it2;
-  
+TokenList::const_iterator TokenList::find(const TokenList& search,
+                                          const_iterator& offset) const {
+  const_iterator it, it2;
+
   while ((it = find(search.front(), offset)) != end()) {
     offset = it;
     for (it2 = search.begin();
@@ -78,3 +260,44 @@ TokenList::const_iterator TokenList::find(const TokenList &search,
   }
   return begin();
 }
+
+void TokenList::grow(size_t n) {
+  reallocate(std::max(n, capacity() * 2));
+}
+
+void TokenList::reallocate(size_t n) {
+  Token* storage = static_cast<Token*>(::operator new(n * sizeof(Token)));
+  Token* it = storage;
+  size_t count = size();
+
+  for (Token* t = tokensBegin; t != tokensEnd; t++, it++) {
+    new (it) Token(std::move(*t));
+    t->~Token();
+  }
+  release();
+
+  tokensBegin = storage;
+  tokensEnd = storage + count;
+  capacityEnd = storage + n;
+}
+
+void TokenList::moveFrom(TokenList& tokens) noexcept {
+  if (tokens.isInline()) {
+    for (iterator it = tokens.begin(); it != tokens.end(); it++, tokensEnd++)
+      new (tokensEnd) Token(std::move(*it));
+    tokens.clear();
+  } else {
+    tokensBegin = tokens.tokensBegin;
+    tokensEnd = tokens.tokensEnd;
+    capacityEnd = tokens.capacityEnd;
+    tokens.tokensBegin = tokens.tokensEnd = tokens.getBuffer();
+    tokens.capacityEnd = tokens.getBuffer() + INLINE_CAPACITY;
+  }
+}
+
+void TokenList::release() noexcept {
+  if (!isInline())
+    ::operator delete(tokensBegin);
+  tokensBegin = tokensEnd = getBuffer();
+  capacityEnd = getBuffer() + INLINE_CAPACITY;
+}
@@ -0,0 +1,40 @@
+#include "less/TokenMatcher.h"
+
+TokenMatcher::TokenMatcher(const TokenList& pattern)
+    : pattern(pattern), failure(pattern.size(), 0) {
+  size_t i, k = 0;
+
+  for (i = 1; i < pattern.size(); i++) {
+    while (k > 0 && pattern[i] != pattern[k])
+      k = failure[k - 1];
+    if (pattern[i] == pattern[k])
+      k++;
+    failure[i] = k;
+  }
+}
+
+const TokenList& TokenMatcher::getPattern() const {
+  return pattern;
+}
+
+TokenList::const_iterator TokenMatcher::find(
+    const TokenList& tokens, TokenList::const_iterator& offset) const {
+  TokenList::const_iterator it;
+  size_t k = 0;
+
+  if (pattern.empty())
+    return tokens.begin();
+
+  for (it = offset; it != tokens.end(); it++) {
+    while (k > 0 && *it != pattern[k])
+      k = failure[k - 1];
+    if (*it == pattern[k])
+      k++;
+
+    if (k == pattern.size()) {
+      offset = it + 1 - k;
+      return it + 1;
+    }
+  }
+  return tokens.begin();
+}
@@ -1,32 +1,60 @@
 #include "less/VariableMap.h"
+#include "less/AtomTable.h"
 
-const TokenList *VariableMap::getVariable(const std::string &key) const {
+const TokenList *VariableMap::getVariable(unsigned int atom) const {
   VariableMap::const_iterator mit;
 
-  if ((mit = this->find(key)) != this->end()) {
+  if ((mit = variables.find(atom)) != variables.end()) {
     return &mit->second;
   } else
     return NULL;
 }
 
+const TokenList *VariableMap::getVariable(const std::string &key) const {
+  unsigned int atom = AtomTable::find(key);
+
+  if (atom == AtomTable::NONE)
+    return NULL;
+  return getVariable(atom);
+}
+
+TokenList &VariableMap::operator[](const std::string &key) {
+  return variables[AtomTable::intern(key)];
+}
+
+void VariableMap::insert(const std::string &key, const TokenList &value) {
+  variables.insert(std::make_pair(AtomTable::intern(key), value));
+}
+
 void VariableMap::merge(const VariableMap &map) {
-  this->insert(map.begin(), map.end());
+  variables.insert(map.begin(), map.end());
 }
 
-void VariableMap::overwrite(const VariableMap &map) {
+bool VariableMap::overwrite(const VariableMap &map) {
   VariableMap::const_iterator it;
+  std::pair<iterator, bool> ret;
+  bool replaced = false;
 
   for (it = map.begin(); it != map.end(); ++it) {
-    (*this)[it->first] = it->second;
+    ret = variables.insert(*it);
+    if (!ret.second) {
+      ret.first->second = it->second;
+      replaced = true;
+    }
   }
+  return replaced;
+}
+
+const std::string &VariableMap::getName(const const_iterator &it) {
+  return AtomTable::getString(it->first);
 }
 
 std::string VariableMap::toString() const {
   std::string str;
   VariableMap::const_iterator it;
 
-  for (it = this->begin(); it != this->end(); ++it) {
-    str.append(it->first);
+  for (it = begin(); it != end(); ++it) {
+    str.append(getName(it));
     str.append(": ");
     str.append(it->second.toString());
     str.append("\n");
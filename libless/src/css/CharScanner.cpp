@@ -0,0 +1,272 @@
+#include "less/css/CharScanner.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define LESS_SCANNER_SSE2
+#endif
+
+#if defined(LESS_SCANNER_SSE2) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LESS_SCANNER_AVX2
+#endif
+
+namespace {
+
+inline bool isNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '-' || c < 0;
+}
+
+inline bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+}
+
+inline bool isStringEnd(char c, char quote) {
+  return c == quote || c == '\\' || c == '\n' || c == '\r' || c == '\f';
+}
+
+const char *skipNameScalar(const char *p, const char *end) {
+  while (p != end && isNameChar(*p))
+    p++;
+  return p;
+}
+
+const char *skipWhitespaceScalar(const char *p, const char *end) {
+  while (p != end && isWhitespace(*p))
+    p++;
+  return p;
+}
+
+const char *findStringEndScalar(const char *p, const char *end, char quote) {
+  while (p != end && !isStringEnd(*p, quote))
+    p++;
+  return p;
+}
+
+#ifdef LESS_SCANNER_SSE2
+
+// unsigned (c - low) < n, using the signed compare sse2 offers.
+inline __m128i inRange128(__m128i c, char low, char n) {
+  __m128i t = _mm_sub_epi8(c, _mm_set1_epi8(low));
+  return _mm_cmplt_epi8(_mm_add_epi8(t, _mm_set1_epi8(-128)),
+                        _mm_set1_epi8(-128 + n));
+}
+
+const char *skipNameSSE2(const char *p, const char *end) {
+  __m128i c, name;
+  unsigned int mask;
+
+  for (; end - p >= 16; p += 16) {
+    c = _mm_loadu_si128((const __m128i *)p);
+    name = _mm_or_si128(
+        inRange128(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 26),
+        inRange128(c, '0', 10));
+    name = _mm_or_si128(name, _mm_cmpeq_epi8(c, _mm_set1_epi8('_')));
+    name = _mm_or_si128(name, _mm_cmpeq_epi8(c, _mm_set1_epi8('-')));
+    name = _mm_or_si128(name, _mm_cmplt_epi8(c, _mm_setzero_si128()));
+
+    mask = ~_mm_movemask_epi8(name) & 0xFFFF;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return skipNameScalar(p, end);
+}
+
+const char *skipWhitespaceSSE2(const char *p, const char *end) {
+  __m128i c, ws;
+  unsigned int mask;
+
+  for (; end - p >= 16; p += 16) {
+    c = _mm_loadu_si128((const __m128i *)p);
+    ws = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+                      _mm_cmpeq_epi8(c, _mm_set1_epi8('\t')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(c, _mm_set1_epi8('\f')));
+
+    mask = ~_mm_movemask_epi8(ws) & 0xFFFF;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return skipWhitespaceScalar(p, end);
+}
+
+const char *findStringEndSSE2(const char *p, const char *end, char quote) {
+  __m128i c, stop;
+  unsigned int mask;
+
+  for (; end - p >= 16; p += 16) {
+    c = _mm_loadu_si128((const __m128i *)p);
+    stop = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(quote)),
+                        _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+    stop = _mm_or_si128(stop, _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')));
+    stop = _mm_or_si128(stop, _mm_cmpeq_epi8(c, _mm_set1_epi8('\r')));
+    stop = _mm_or_si128(stop, _mm_cmpeq_epi8(c, _mm_set1_epi8('\f')));
+
+    mask = _mm_movemask_epi8(stop);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return findStringEndScalar(p, end, quote);
+}
+
+#endif  // LESS_SCANNER_SSE2
+
+#ifdef LESS_SCANNER_AVX2
+
+__attribute__((target("avx2"))) inline __m256i inRange256(__m256i c,
+                                                          char low,
+                                                          char n) {
+  __m256i t = _mm256_sub_epi8(c, _mm256_set1_epi8(low));
+  return _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + n),
+                           _mm256_add_epi8(t, _mm256_set1_epi8(-128)));
+}
+
+__attribute__((target("avx2"))) const char *skipNameAVX2(const char *p,
+                                                         const char *end) {
+  __m256i c, name;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    c = _mm256_loadu_si256((const __m256i *)p);
+    name = _mm256_or_si256(
+        inRange256(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 26),
+        inRange256(c, '0', 10));
+    name = _mm256_or_si256(name, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')));
+    name = _mm256_or_si256(name, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-')));
+    name = _mm256_or_si256(name,
+                           _mm256_cmpgt_epi8(_mm256_setzero_si256(), c));
+
+    mask = ~(unsigned int)_mm256_movemask_epi8(name);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return skipNameSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *skipWhitespaceAVX2(
+    const char *p, const char *end) {
+  __m256i c, ws;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    c = _mm256_loadu_si256((const __m256i *)p);
+    ws = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+                         _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\t')));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')));
+    ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\f')));
+
+    mask = ~(unsigned int)_mm256_movemask_epi8(ws);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return skipWhitespaceSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char *findStringEndAVX2(
+    const char *p, const char *end, char quote) {
+  __m256i c, stop;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    c = _mm256_loadu_si256((const __m256i *)p);
+    stop = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(quote)),
+                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+    stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')));
+    stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\r')));
+    stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\f')));
+
+    mask = (unsigned int)_mm256_movemask_epi8(stop);
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return findStringEndSSE2(p, end, quote);
+}
+
+#endif  // LESS_SCANNER_AVX2
+
+struct ScannerImpl {
+  const char *name;
+  const char *(*skipName)(const char *, const char *);
+  const char *(*skipWhitespace)(const char *, const char *);
+  const char *(*findStringEnd)(const char *, const char *, char);
+};
+
+/**
+ * The implementations the cpu supports, fastest first.
+ */
+const ScannerImpl *getImpls() {
+  static const ScannerImpl impls[] = {
+#ifdef LESS_SCANNER_AVX2
+      {"avx2", skipNameAVX2, skipWhitespaceAVX2, findStringEndAVX2},
+#endif
+#ifdef LESS_SCANNER_SSE2
+      {"sse2", skipNameSSE2, skipWhitespaceSSE2, findStringEndSSE2},
+#endif
+      {"scalar", skipNameScalar, skipWhitespaceScalar, findStringEndScalar},
+      {NULL, NULL, NULL, NULL}};
+  const ScannerImpl *i = impls;
+
+#ifdef LESS_SCANNER_AVX2
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("avx2"))
+    i++;
+#endif
+  return i;
+}
+
+ScannerImpl impl = *getImpls();
+
+}  // namespace
+
+const char *CharScanner::skipName(const char *p, const char *end) {
+  // Most names are short; don't pay for the vector setup when the
+  // run ends within the first few characters.
+  if (end - p >= 4 && !(isNameChar(p[0]) && isNameChar(p[1]) &&
+                        isNameChar(p[2]) && isNameChar(p[3])))
+    return skipNameScalar(p, p + 4);
+  return impl.skipName(p, end);
+}
+
+const char *CharScanner::skipWhitespace(const char *p, const char *end) {
+  if (end - p >= 2 && !(isWhitespace(p[0]) && isWhitespace(p[1])))
+    return skipWhitespaceScalar(p, p + 2);
+  return impl.skipWhitespace(p, end);
+}
+
+const char *CharScanner::findStringEnd(const char *p,
+                                       const char *end,
+                                       char quote) {
+  return impl.findStringEnd(p, end, quote);
+}
+
+const char *CharScanner::find(const char *p, const char *end, char c) {
+  const char *ret;
+
+  if (p == end)
+    return end;
+
+  // The C library's memchr is already vectorized.
+  ret = (const char *)std::memchr(p, c, end - p);
+  return (ret != NULL) ? ret : end;
+}
+
+const char *CharScanner::getImplementation() {
+  return impl.name;
+}
+
+bool CharScanner::setImplementation(const char *name) {
+  const ScannerImpl *i;
+
+  for (i = getImpls(); i->name != NULL; i++) {
+    if (std::strcmp(i->name, name) == 0) {
+      impl = *i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -22,6 +22,23 @@ void CssParser::parseStylesheet(Stylesheet& stylesheet) {
   }
 }
 
+void CssParser::streamStylesheet(CssWriter& writer) {
+  Stylesheet statement;
+
+  tokenizer->readNextToken();
+
+  skipWhitespace();
+  while (parseStatement(statement) || parseEmptyStatement()) {
+    statement.write(writer);
+    statement.clear();
+    skipWhitespace();
+  }
+
+  if (tokenizer->getTokenType() != Token::EOS) {
+    throw new ParseException(tokenizer->getToken(), "end of input");
+  }
+}
+
 void CssParser::skipWhitespace() {
   while (tokenizer->getTokenType() == Token::WHITESPACE ||
          tokenizer->getTokenType() == Token::COMMENT) {
@@ -47,9 +64,7 @@ bool CssParser::parseEmptyStatement() {
   if (tokenizer->getTokenType() == Token::DELIMITER) {
     t = &tokenizer->getToken();
 
-    cerr << t->source << ": Line " << t->line << ", Column"
-         << t->column
-         << " Warning: Semicolon without statement." << endl;
+    warnEmptyStatement(*t);
 
     tokenizer->readNextToken();
 
@@ -58,6 +73,12 @@ bool CssParser::parseEmptyStatement() {
     return false;
 }
 
+void CssParser::warnEmptyStatement(const Token &t) {
+  cerr << t.getSource() << ": Line " << t.getLine() << ", Column"
+       << t.getColumn()
+       << " Warning: Semicolon without statement." << endl;
+}
+
 bool CssParser::parseStatement(Stylesheet& stylesheet) {
   Ruleset* ruleset = parseRuleset(stylesheet);
   if (ruleset != NULL)
@@ -83,6 +104,7 @@ MediaQuery* CssParser::parseMediaQuery(Stylesheet& stylesheet) {
     return NULL;
 
   selector.push_back(tokenizer->getToken());
+  selector.push_back(Token::BUILTIN_SPACE);
 
   tokenizer->readNextToken();
   skipWhitespace();
@@ -244,6 +266,7 @@ Declaration* CssParser::parseDeclaration(Ruleset& ruleset) {
   if (!parseValue(declaration->getValue())) {
     throw new ParseException(tokenizer->getToken(), "value for property");
   }
+  declaration->getValue().rtrim();
   return declaration;
 }
 
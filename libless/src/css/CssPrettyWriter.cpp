@@ -10,7 +10,7 @@ void CssPrettyWriter::indent() {
 
 
 void CssPrettyWriter::writeSelector(const Selector &selector) {
-  std::list<TokenList>::const_iterator s_it;
+  Selector::const_iterator s_it;
   TokenList::const_iterator token;
 
   for(s_it = selector.begin();
@@ -3,18 +3,14 @@
 bool CssSelectorParser::parse(TokenList& tokens,
                               Selector& selector) {
   TokenList::const_iterator begin, end;
-  TokenList tmp;
-  TokenList *newSelector;
 
   begin = tokens.begin();
   
   while (begin != tokens.end()) {
     end = findComma(tokens, begin);
 
-    selector.push_back(tmp);
-    newSelector = &selector.back();
-    newSelector->assign(begin, end);
-    newSelector->trim();
+    selector.push_back(TokenList(begin, end));
+    selector.back().trim();
     
     begin = end;
     if (begin != tokens.end())
@@ -1,11 +1,40 @@
 #include "less/css/CssTokenizer.h"
 
+#include <cstring>
+
+#include "less/css/CharScanner.h"
+
+constexpr unsigned char CssTokenizer::charClasses[256];
+
 CssTokenizer::CssTokenizer(istream& in, const char* source)
-    : in(&in), line(0), source(source) {
-  currentToken.source = source;
+    : buffer(new SourceBuffer(in)), source(source), classes(charClasses) {
+  sourceId = SourceRegistry::add(source, buffer);
+  currentToken.sourceId = sourceId;
   lastRead = 0;
-  readChar();
-  column = 0;
+  pos = end = buffer->getData();
+  started = eof = false;
+}
+
+CssTokenizer::CssTokenizer(SourceBuffer* buffer, const char* source)
+    : buffer(buffer), source(source), classes(charClasses) {
+  sourceId = SourceRegistry::add(source, buffer);
+  currentToken.sourceId = sourceId;
+  lastRead = 0;
+  pos = buffer->getData();
+  end = pos + buffer->getSize();
+  started = eof = false;
+}
+
+CssTokenizer::CssTokenizer(unsigned int sourceId, size_t begin, size_t end)
+    : buffer(const_cast<SourceBuffer*>(SourceRegistry::getContent(sourceId))),
+      source(SourceRegistry::getName(sourceId)),
+      sourceId(sourceId),
+      classes(charClasses) {
+  currentToken.sourceId = sourceId;
+  lastRead = 0;
+  pos = buffer->getData() + begin;
+  this->end = buffer->getData() + end;
+  started = eof = false;
 }
 
 CssTokenizer::~CssTokenizer() {
@@ -15,236 +44,261 @@ const char* CssTokenizer::getSource() {
   return source;
 }
 
-void CssTokenizer::readChar() {
-  if (in == NULL)
-    return;
+unsigned int CssTokenizer::getSourceId() {
+  return sourceId;
+}
 
-  // Last char was a newline. Increment the line counter.
-  if (lastReadEq('\n')) {
-    line++;
-    column = 0;
-  } else
-    column++;
+bool CssTokenizer::fillBuffer() {
+  size_t offset = pos - buffer->getData();
 
-  in->get(lastRead);
+  // Reading a part of the source.
+  if (end != buffer->getData() + buffer->getSize())
+    return false;
 
-  // check for end of file or escape key
-  if (in->eof() || lastRead == 27)
-    in = NULL;
-  else if (in->fail() || in->bad())
-    throw new IOException("Error reading input");
+  if (!buffer->fill())
+    return false;
 
-  if (lastReadEq('\n') && column > 0)  // don't count newlines as chars
-    column--;
+  pos = buffer->getData() + offset;
+  end = buffer->getData() + buffer->getSize();
+  return pos != end;
 }
 
 Token::Type CssTokenizer::readNextToken() {
-  if (in == NULL) {
+  unsigned char cls;
+
+  if (!started) {
+    started = true;
+    readChar();
+  }
+
+  if (eof) {
     currentToken.type = Token::EOS;
     return Token::EOS;
   }
 
   currentToken.clear();
-  currentToken.line = line;
-  currentToken.column = column;
+  tokenStart = readOffset();
+  currentToken.offset = tokenStart;
 
-  switch (lastRead) {
-    case '@':
-      currentToken.type = Token::ATKEYWORD;
-      currentToken.append(lastRead);
-      readChar();
-      if (!readIdent()) {
-        currentToken.type = Token::OTHER;
-      }
-      break;
+  cls = classes[(unsigned char)lastRead];
 
-    case '#':
-      currentToken.type = Token::HASH;
-      currentToken.append(lastRead);
-      readChar();
-      if (!readName()) {
-        throw new ParseException(
-            &lastRead, "name following '#'", line, column, source);
-      }
-      break;
+  // The most common tokens are dispatched on the class of their first
+  // character, the rest on the character itself.
+  if (cls & CharClass::NAME_START) {
+    readIdent();
+    currentToken.type = Token::IDENTIFIER;
 
-    case '-':
-      currentToken.append(lastRead);
+    if (tokenEquals("url", 3) && readUrl())
+      currentToken.type = Token::URL;
+    else if (tokenEquals("u", 1) && lastReadEq('+')) {
       readChar();
-      if (readNum(true)) {
-        currentToken.type = Token::NUMBER;
-        readNumSuffix();
-      } else if (readIdent()) {
-        currentToken.type = Token::IDENTIFIER;
-      } else
-        currentToken.type = Token::OTHER;
-      break;
+      currentToken.type = Token::UNICODE_RANGE;
+      readUnicodeRange();
+    }
 
-    case '~':
-      currentToken.append(lastRead);
-      readChar();
-      if (lastRead == '=') {
-        currentToken.append(lastRead);
+  } else if (cls & CharClass::WHITESPACE) {
+    currentToken.type = Token::WHITESPACE;
+    readRun(CharScanner::skipWhitespace);
+
+  } else if (cls & CharClass::DELIMITER) {
+    readDelimiter();
+
+  } else if (cls & CharClass::DIGIT) {
+    readNum(true);
+    currentToken.type = Token::NUMBER;
+    readNumSuffix();
+
+  } else {
+    switch (lastRead) {
+      case '@':
+        currentToken.type = Token::ATKEYWORD;
         readChar();
-        currentToken.type = Token::INCLUDES;
-      } else
-        currentToken.type = Token::OTHER;
-      break;
+        if (!readIdent()) {
+          currentToken.type = Token::OTHER;
+        }
+        break;
 
-    case '|':
-      currentToken.append(lastRead);
-      readChar();
-      if (lastRead == '=') {
-        currentToken.append(lastRead);
+      case '#':
+        currentToken.type = Token::HASH;
         readChar();
-        currentToken.type = Token::DASHMATCH;
-      } else
-        currentToken.type = Token::OTHER;
-      break;
+        if (!readName()) {
+          throw new ParseException(
+              &lastRead, "name following '#'", sourceId, readOffset());
+        }
+        break;
 
-    case '/':
-      currentToken.append(lastRead);
-      readChar();
-      if (readComment())
-        currentToken.type = Token::COMMENT;
-      else
-        currentToken.type = Token::OTHER;
-      break;
+      case '-':
+        readChar();
+        if (readNum(true)) {
+          currentToken.type = Token::NUMBER;
+          readNumSuffix();
+        } else if (readIdent()) {
+          currentToken.type = Token::IDENTIFIER;
+        } else
+          currentToken.type = Token::OTHER;
+        break;
+
+      case '~':
+        readChar();
+        if (lastRead == '=') {
+          readChar();
+          currentToken.type = Token::INCLUDES;
+        } else
+          currentToken.type = Token::OTHER;
+        break;
+
+      case '|':
+        readChar();
+        if (lastRead == '=') {
+          readChar();
+          currentToken.type = Token::DASHMATCH;
+        } else
+          currentToken.type = Token::OTHER;
+        break;
+
+      case '/':
+        readChar();
+        if (lastReadIs(CharClass::COMMENT) && readComment())
+          currentToken.type = Token::COMMENT;
+        else
+          currentToken.type = Token::OTHER;
+        break;
+
+      case '.':
+        readChar();
+        if (readNum(false)) {
+          currentToken.type = Token::NUMBER;
+          readNumSuffix();
+        }
+        break;
+
+      case '"':
+      case '\'':
+        readString();
+        currentToken.type = Token::STRING;
+        break;
+
+      case '\\':
+        // readEscape() eats the '\' even if it fails on a newline, which
+        // then starts a whitespace token.
+        if (readIdent())
+          currentToken.type = Token::IDENTIFIER;
+        else if (readWhitespace()) {
+          currentToken.type = Token::WHITESPACE;
+          readRun(CharScanner::skipWhitespace);
+        }
+        break;
+
+      default:
+        readChar();
+        break;
+    }
+  }
+
+  currentToken.assign(buffer->getData() + tokenStart,
+                      readOffset() - tokenStart);
+
+  // Variables are looked up by atom, mostly through copies of the
+  // token. Interning the name here gives every copy the atom.
+  if (currentToken.type == Token::ATKEYWORD)
+    currentToken.getAtom();
+  return currentToken.type;
+}
+
+void CssTokenizer::readRun(const char* (*scan)(const char*, const char*)) {
+  const char* p;
+
+  while (!eof && (p = scan(pos - 1, end)) != pos - 1)
+    skipTo(p);
+}
 
+void CssTokenizer::readClass(unsigned char cls) {
+  const char* p;
+
+  while (!eof) {
+    p = pos - 1;
+    while (p != end && (classes[(unsigned char)*p] & cls) != 0)
+      p++;
+
+    if (p == pos - 1)
+      return;
+    skipTo(p);
+  }
+}
+
+void CssTokenizer::readDelimiter() {
+  switch (lastRead) {
     case ';':
       currentToken.type = Token::DELIMITER;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case ':':
       currentToken.type = Token::COLON;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case '{':
       currentToken.type = Token::BRACKET_OPEN;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case '}':
       currentToken.type = Token::BRACKET_CLOSED;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case '(':
       currentToken.type = Token::PAREN_OPEN;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case ')':
       currentToken.type = Token::PAREN_CLOSED;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case '[':
       currentToken.type = Token::BRACE_OPEN;
-      currentToken.append(lastRead);
-      readChar();
       break;
     case ']':
       currentToken.type = Token::BRACE_CLOSED;
-      currentToken.append(lastRead);
-      readChar();
-      break;
-
-    case '.':
-      currentToken.append(lastRead);
-      readChar();
-      if (readNum(false)) {
-        currentToken.type = Token::NUMBER;
-        readNumSuffix();
-      }
-      break;
-
-    default:
-      if (readString())
-        currentToken.type = Token::STRING;
-      else if (readNum(true)) {
-        currentToken.type = Token::NUMBER;
-        readNumSuffix();
-
-      } else if (readIdent()) {
-        currentToken.type = Token::IDENTIFIER;
-
-        if (currentToken == "url" && readUrl())
-          currentToken.type = Token::URL;
-        else if (currentToken == "u" && lastReadEq('+')) {
-          currentToken.append(lastRead);
-          readChar();
-          currentToken.type = Token::UNICODE_RANGE;
-          readUnicodeRange();
-        }
-      } else if (readWhitespace()) {
-        currentToken.type = Token::WHITESPACE;
-        while (readWhitespace()) {
-        };
-      } else {
-        currentToken.append(lastRead);
-        readChar();
-      }
       break;
   }
+  readChar();
+}
 
-  return currentToken.type;
+size_t CssTokenizer::readOffset() const {
+  return (eof ? end : pos - 1) - buffer->getData();
+}
+
+bool CssTokenizer::tokenEquals(const char* str, size_t len) const {
+  return (readOffset() - tokenStart == len &&
+          std::memcmp(buffer->getData() + tokenStart, str, len) == 0);
 }
 
 bool CssTokenizer::readIdent() {
   if (lastReadEq('-')) {
-    currentToken.append(lastRead);
     readChar();
   }
   if (!readNMStart())
     return false;
   else
-    while (readNMChar()) {
-    }
+    readNMChars();
   return true;
 }
 
 bool CssTokenizer::readName() {
   if (!readNMChar())
     return false;
-  while (readNMChar()) {
-  }
+  readNMChars();
   return true;
 }
 
 bool CssTokenizer::readNMStart() {
-  if (in == NULL)
-    return false;
-
-  if (lastReadEq('_') || lastReadInRange('a', 'z') ||
-      lastReadInRange('A', 'Z')) {
-    currentToken.append(lastRead);
+  if (lastReadIs(CharClass::NAME_START)) {
     readChar();
     return true;
   } else
-    return (readNonAscii() || readEscape());
-}
-bool CssTokenizer::readNonAscii() {
-  if (in == NULL || lastRead >= 0)
-    return false;
-
-  currentToken.append(lastRead);
-  readChar();
-  return true;
+    return readEscape();
 }
 
 bool CssTokenizer::readEscape() {
   if (!lastReadEq('\\'))
     return false;
-  currentToken.append(lastRead);
   readChar();
 
   if (readUnicode())
     return true;
   else if (!lastReadEq('\n') && !lastReadEq('\r') && !lastReadEq('\f')) {
-    currentToken.append(lastRead);
     readChar();
     return true;
   } else
@@ -252,48 +306,46 @@ bool CssTokenizer::readEscape() {
 }
 
 bool CssTokenizer::readUnicode() {
-  if (!lastReadIsHex())
+  if (!lastReadIs(CharClass::HEX))
     return false;
 
   // [0-9a-f]{1,6}(\r\n|[ \n\r\t\f])?
   for (int i = 0; i < 6; i++) {
-    currentToken.append(lastRead);
     readChar();
-    if (readWhitespace() || !lastReadIsHex())
+    if (readWhitespace() || !lastReadIs(CharClass::HEX))
       break;
   }
   return true;
 }
 
 bool CssTokenizer::readNMChar() {
-  if (in == NULL)
-    return false;
-
-  if (lastReadEq('_') || lastReadInRange('a', 'z') ||
-      lastReadInRange('A', 'Z') || lastReadIsDigit() || lastReadEq('-')) {
-    currentToken.append(lastRead);
+  if (lastReadIs(CharClass::NAME)) {
     readChar();
     return true;
   } else
-    return (readNonAscii() || readEscape());
+    return readEscape();
+}
+
+void CssTokenizer::readNMChars() {
+  const char* p;
+
+  while (!eof) {
+    p = CharScanner::skipName(pos - 1, end);
+    if (p != pos - 1)
+      skipTo(p);
+    else if (!readEscape())
+      return;
+  }
 }
 
 bool CssTokenizer::readNum(bool readDecimals) {
-  if (!lastReadIsDigit())
+  if (!lastReadIs(CharClass::DIGIT))
     return false;
-  while (lastReadIsDigit()) {
-    currentToken.append(lastRead);
-    readChar();
-  }
+  readClass(CharClass::DIGIT);
 
   if (readDecimals && lastReadEq('.')) {
-    currentToken.append(lastRead);
     readChar();
-
-    while (lastReadIsDigit()) {
-      currentToken.append(lastRead);
-      readChar();
-    }
+    readClass(CharClass::DIGIT);
   }
   return true;
 }
@@ -301,7 +353,6 @@ bool CssTokenizer::readNum(bool readDecimals) {
 bool CssTokenizer::readNumSuffix() {
   if (lastRead == '%') {
     currentToken.type = Token::PERCENTAGE;
-    currentToken.append(lastRead);
     readChar();
     return true;
   } else if (readIdent()) {
@@ -317,41 +368,34 @@ bool CssTokenizer::readString() {
     return false;
   char delim = lastRead;
 
-  currentToken.append(lastRead);
   readChar();
-  while (in != NULL) {
+  while (!eof) {
     if (lastReadEq(delim)) {
-      currentToken.append(lastRead);
       readChar();
       return true;
     } else if (lastReadEq('\n') || lastReadEq('\r') || lastReadEq('\f')) {
       throw new ParseException(
-          "end of line", "end of string", line, column, source);
+          "end of line", "end of string", sourceId, readOffset());
     } else if (lastReadEq('\\'))
       // note that even though readEscape() returns false it still
       // eats the '\'.
       readEscape() || readNewline();
-    else {
-      currentToken.append(lastRead);
-      readChar();
-    }
+    else
+      skipTo(CharScanner::findStringEnd(pos, end, delim));
   }
   throw new ParseException(
-      "end of input", "end of string", line, column, source);
+      "end of input", "end of string", sourceId, readOffset());
   return false;
 }
 
 bool CssTokenizer::readNewline() {
   if (lastReadEq('\r')) {
-    currentToken.append(lastRead);
     readChar();
     if (lastReadEq('\n')) {
-      currentToken.append(lastRead);
       readChar();
     }
     return true;
   } else if (lastReadEq('\n') || lastReadEq('\f')) {
-    currentToken.append(lastRead);
     readChar();
     return true;
   } else
@@ -359,9 +403,7 @@ bool CssTokenizer::readNewline() {
 }
 
 bool CssTokenizer::readWhitespace() {
-  if (lastReadEq(' ') || lastReadEq('\t') || lastReadEq('\r') ||
-      lastReadEq('\n') || lastReadEq('\f')) {
-    currentToken.append(lastRead);
+  if (lastReadIs(CharClass::WHITESPACE)) {
     readChar();
     return true;
   } else
@@ -369,91 +411,74 @@ bool CssTokenizer::readWhitespace() {
 }
 
 bool CssTokenizer::readUrl() {
-  string urlchars = "!#$%&*-[]-~";
-
   if (!lastReadEq('('))
     return false;
-  currentToken.append(lastRead);
   readChar();
-  while (readWhitespace()) {
-  };
+  readClass(CharClass::WHITESPACE);
 
   if (readString()) {
     if (lastReadEq(')')) {
-      currentToken.append(lastRead);
       readChar();
       return true;
     } else {
       throw new ParseException(
-          &lastRead, "end of url (')')", line, column, source);
+          &lastRead, "end of url (')')", sourceId, readOffset());
     }
   }
 
-  while (in != NULL) {
-    if (readWhitespace() || lastReadEq(')')) {
-      while (readWhitespace()) {
-      };
+  while (!eof) {
+    if (lastReadIs(CharClass::WHITESPACE) || lastReadEq(')')) {
+      readClass(CharClass::WHITESPACE);
       if (lastReadEq(')')) {
-        currentToken.append(lastRead);
         readChar();
         return true;
       } else {
         throw new ParseException(
-            &lastRead, "end of url (')')", line, column, source);
+            &lastRead, "end of url (')')", sourceId, readOffset());
       }
-    } else if (in != NULL && urlchars.find(lastRead)) {
-      currentToken.append(lastRead);
-      readChar();
-    } else if (!readNonAscii() && !readEscape()) {
-      throw new ParseException(
-          &lastRead, "end of url (')')", line, column, source);
     }
+    readClass(CharClass::URL);
   }
-  throw new ParseException(&lastRead, "end of url (')')", line, column, source);
+  throw new ParseException(
+      &lastRead, "end of url (')')", sourceId, readOffset());
   return false;
 }
 
 bool CssTokenizer::readComment() {
   if (!lastReadEq('*'))
     return false;
-  currentToken.append(lastRead);
   readChar();
-  while (in != NULL) {
+  while (!eof) {
     if (lastReadEq('*')) {
-      currentToken.append(lastRead);
       readChar();
 
       if (lastReadEq('/')) {
-        currentToken.append(lastRead);
         readChar();
         return true;
       }
       continue;
     }
-    currentToken.append(lastRead);
-    readChar();
+    skipTo(CharScanner::find(pos, end, '*'));
   }
   throw new ParseException(
-      &lastRead, "end of comment (*/)", line, column, source);
+      &lastRead, "end of comment (*/)", sourceId, readOffset());
   return false;
 }
 
 bool CssTokenizer::readUnicodeRange() {
-  if (in == NULL)
+  if (eof)
     return false;
   for (int i = 0; i < 6; i++) {
-    if (!lastReadIsHex())
+    if (!lastReadIs(CharClass::HEX))
       break;
-    currentToken.append(lastRead);
     readChar();
   }
   if (!lastReadEq('-'))
     return true;
 
   for (int i = 0; i < 6; i++) {
-    if (!lastReadIsHex())
+    if (!lastReadIs(CharClass::HEX))
       break;
-    currentToken.append(lastRead);
     readChar();
   }
   return true;
@@ -467,16 +492,5 @@ Token::Type CssTokenizer::getTokenType() {
 }
 
 bool CssTokenizer::lastReadEq(char c) {
-  return (in != NULL && lastRead == c);
-}
-
-bool CssTokenizer::lastReadInRange(char c1, char c2) {
-  return (in != NULL && lastRead >= c1 && lastRead <= c2);
-}
-bool CssTokenizer::lastReadIsDigit() {
-  return (in != NULL && lastReadInRange('0', '9'));
-}
-bool CssTokenizer::lastReadIsHex() {
-  return (in != NULL && (lastReadIsDigit() || lastReadInRange('a', 'f') ||
-                         lastReadInRange('A', 'F')));
+  return (!eof && lastRead == c);
 }
@@ -62,7 +62,7 @@ void CssWriter::writeTokenList(const TokenList &tokens) {
 }
 
 void CssWriter::writeSelector(const Selector &selector) {
-  std::list<TokenList>::const_iterator s_it;
+  Selector::const_iterator s_it;
   TokenList::const_iterator token;
 
   for(s_it = selector.begin();
@@ -89,14 +89,15 @@ void CssWriter::writeValue(const TokenList &value) {
     it++;
   }
 
-  if (sourcemap != NULL) {
+  if (sourcemap != NULL && it != value.end()) {
     sourcemap->writeMapping(column, *it);
     t = &(*it);
   }
 
   for (; it != value.end(); it++) {
     if (sourcemap != NULL) {
-      if ((*it).source != t->source || (*it).line != t->line) {
+      if ((*it).sourceId != t->sourceId ||
+          (*it).getLine() != t->getLine()) {
         if (sourcemap->writeMapping(column, (*it)))
           t = &(*it);
       }
@@ -38,6 +38,19 @@ ParseException::ParseException(const char* found,
   err.append("\" when expecting ");
   err.append(expected);
 }
+ParseException::ParseException(const char* found,
+                               const char* expected,
+                               unsigned int sourceId,
+                               unsigned int offset) :
+  LessException(sourceId, offset) {
+  err.append("Found \"");
+  if (found[0] == -1)
+    err.append("end of file");
+  else
+    err.append(translate(std::string(found)));
+  err.append("\" when expecting ");
+  err.append(expected);
+}
 ParseException::ParseException(const Token& found, const char* expected) :
   LessException(found) {
   err.append("Found \"");
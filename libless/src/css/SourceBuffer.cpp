@@ -0,0 +1,144 @@
+#include "less/css/SourceBuffer.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceBuffer::SourceBuffer()
+    : in(NULL), data(NULL), size(0), capacity(0), mapped(false),
+      complete(true) {
+}
+
+SourceBuffer::SourceBuffer(std::istream &in)
+    : in(&in), data(NULL), size(0), capacity(0), mapped(false),
+      complete(false) {
+}
+
+SourceBuffer::~SourceBuffer() {
+  release();
+}
+
+void SourceBuffer::release() {
+  if (mapped)
+    munmap(data, capacity);
+  else
+    delete[] data;
+
+  data = NULL;
+  size = capacity = 0;
+  mapped = false;
+}
+
+bool SourceBuffer::open(const char *filename) {
+  int fd;
+  struct stat st;
+  void *map;
+  bool ret;
+
+  release();
+  in = NULL;
+  complete = true;
+
+  if ((fd = ::open(filename, O_RDONLY)) < 0)
+    return false;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map != MAP_FAILED) {
+      madvise(map, st.st_size, MADV_SEQUENTIAL);
+      data = (char *)map;
+      size = capacity = st.st_size;
+      mapped = true;
+      close(fd);
+
+      truncateAtEscape(0);
+      return true;
+    }
+  }
+
+  ret = readFile(fd);
+  close(fd);
+  return ret;
+}
+
+bool SourceBuffer::readFile(int fd) {
+  ssize_t n;
+
+  do {
+    reserve(size + BLOCK_SIZE);
+    n = read(fd, data + size, capacity - size);
+    if (n > 0)
+      size += n;
+  } while (n > 0);
+
+  truncateAtEscape(0);
+  return n == 0;
+}
+
+bool SourceBuffer::fill() {
+  size_t offset = size;
+  std::streamsize n;
+
+  if (complete || in == NULL)
+    return false;
+
+  reserve(size + BLOCK_SIZE);
+  in->read(data + size, BLOCK_SIZE);
+  n = in->gcount();
+
+  if (in->bad() || (in->fail() && !in->eof()))
+    throw new IOException("Error reading input");
+
+  size += n;
+  if (n < (std::streamsize)BLOCK_SIZE)
+    complete = true;
+
+  truncateAtEscape(offset);
+  return n > 0;
+}
+
+void SourceBuffer::reserve(size_t n) {
+  char *tmp;
+
+  if (n <= capacity)
+    return;
+
+  if (n < capacity * 2)
+    n = capacity * 2;
+
+  tmp = new char[n];
+  if (size > 0)
+    std::memcpy(tmp, data, size);
+  delete[] data;
+  data = tmp;
+  capacity = n;
+}
+
+void SourceBuffer::truncateAtEscape(size_t offset) {
+  const char *esc;
+
+  if (offset >= size)
+    return;
+
+  esc = (const char *)std::memchr(data + offset, 27, size - offset);
+  if (esc != NULL) {
+    size = esc - data;
+    complete = true;
+  }
+}
+
+bool SourceBuffer::isComplete() const {
+  return complete;
+}
+
+const char *SourceBuffer::getData() const {
+  return data;
+}
+
+size_t SourceBuffer::getSize() const {
+  return size;
+}
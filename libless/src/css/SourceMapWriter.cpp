@@ -4,7 +4,7 @@ const char* SourceMapWriter::base64 =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 SourceMapWriter::SourceMapWriter(std::ostream& sourcemap,
-                                 std::list<const char*>& sources,
+                                 const SourceSet& sources,
                                  std::list<const char*>& relative_sources,
                                  const char* out_filename,
                                  const char* rootpath)
@@ -79,35 +79,28 @@ void SourceMapWriter::writeNewline() {
   firstSegment = true;
 }
 
-size_t SourceMapWriter::sourceFileIndex(const char* file) {
-  std::list<const char*>::iterator i;
-  size_t pos = 0;
-
-  for (i = sources.begin(); i != sources.end(); i++, pos++) {
-    if (*i == file)
-      return pos;
-  }
-  return sources.size();
-}
-
 size_t SourceMapWriter::encodeMapping(unsigned int column,
                                       const Token& source,
                                       char* buffer) {
-  unsigned int srcFileIndex = sourceFileIndex(source.source);
+  unsigned int srcFileIndex = sources.indexOf(source.sourceId);
+  unsigned int srcLine, srcColumn;
   char* start = buffer;
 
   if (srcFileIndex == sources.size())
     return 0;
 
+  SourceRegistry::getLocation(
+      source.sourceId, source.offset, srcLine, srcColumn);
+
   buffer += encodeField(column - lastDstColumn, buffer);
   buffer += encodeField(srcFileIndex - lastSrcFile, buffer);
-  buffer += encodeField(source.line - lastSrcLine, buffer);
-  buffer += encodeField(source.column - lastSrcColumn, buffer);
+  buffer += encodeField(srcLine - lastSrcLine, buffer);
+  buffer += encodeField(srcColumn - lastSrcColumn, buffer);
 
   lastDstColumn = column;
   lastSrcFile = srcFileIndex;
-  lastSrcLine = source.line;
-  lastSrcColumn = source.column;
+  lastSrcLine = srcLine;
+  lastSrcColumn = srcColumn;
 
   return buffer - start;
 }
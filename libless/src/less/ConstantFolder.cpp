@@ -0,0 +1,124 @@
+#include "less/less/ConstantFolder.h"
+
+#include "less/LessException.h"
+#include "less/less/ReferenceRuleset.h"
+#include "less/lessstylesheet/LessMediaQuery.h"
+
+/**
+ * Functions that read files or depend on where they are evaluated.
+ */
+static const char *const unfoldable[] = {
+  "default", "url", "data-uri", "image-width", "image-height",
+  "imgwidth", "imgheight", "imgbackground", NULL
+};
+
+ConstantFolder::ConstantFolder() {
+}
+
+ConstantFolder::~ConstantFolder() {
+}
+
+void ConstantFolder::fold(LessStylesheet &stylesheet) {
+  std::list<StylesheetStatement *>::const_iterator it;
+  LessRuleset *ruleset;
+  const ReferenceRuleset *skipped;
+  LessMediaQuery *query;
+
+  for (it = stylesheet.getStatements().begin();
+       it != stylesheet.getStatements().end();
+       it++) {
+    if ((ruleset = dynamic_cast<LessRuleset *>(*it)) != NULL) {
+      skipped = dynamic_cast<const ReferenceRuleset *>(ruleset);
+      if (skipped == NULL || skipped->isLoaded())
+        fold(*ruleset);
+
+    } else if ((query = dynamic_cast<LessMediaQuery *>(*it)) != NULL) {
+      fold((LessStylesheet &)*query);
+    }
+  }
+}
+
+void ConstantFolder::fold(LessRuleset &ruleset) {
+  std::list<LessDeclaration *>::const_iterator d_it;
+  std::list<LessRuleset *>::const_iterator r_it;
+
+  for (d_it = ruleset.getLessDeclarations().begin();
+       d_it != ruleset.getLessDeclarations().end();
+       d_it++) {
+    fold(**d_it);
+  }
+
+  for (r_it = ruleset.getNestedRules().begin();
+       r_it != ruleset.getNestedRules().end();
+       r_it++) {
+    fold(**r_it);
+  }
+}
+
+bool ConstantFolder::fold(LessDeclaration &declaration) {
+  TokenList value;
+
+  if (declaration.isFolded() || !isConstant(declaration.getValue()))
+    return false;
+
+  value = declaration.getValue();
+  try {
+    processor.processValue(value, *this);
+  } catch (LessException *e) {
+    delete e;
+    return false;
+  }
+
+  declaration.setFolded(value);
+  return true;
+}
+
+bool ConstantFolder::isConstant(const TokenList &value) {
+  TokenList::const_iterator it, next;
+
+  for (it = value.begin(); it != value.end(); it++) {
+    switch ((*it).type) {
+      case Token::ATKEYWORD:
+      case Token::URL:
+        return false;
+
+      case Token::OTHER:
+        // '@' of an interpolated variable
+        if (!(*it).empty() && (*it)[0] == '@')
+          return false;
+        break;
+
+      case Token::STRING:
+        if ((*it).find("@{") != std::string::npos)
+          return false;
+        break;
+
+      case Token::IDENTIFIER:
+        next = it + 1;
+        if (next == value.end() || (*next).type != Token::PAREN_OPEN)
+          break;
+        if (!isFoldable(*it))
+          return false;
+        break;
+
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+bool ConstantFolder::isFoldable(const Token &function) {
+  const char *const *name;
+
+  for (name = unfoldable; *name != NULL; name++) {
+    if (function == *name)
+      return false;
+  }
+  return true;
+}
+
+const TokenList *ConstantFolder::getVariable(unsigned int atom) const {
+  (void)atom;
+  return NULL;
+}
@@ -0,0 +1,183 @@
+#include "less/less/DependencyScanner.h"
+
+#include <cstring>
+
+#include "less/css/ParseException.h"
+#include "less/less/LessParser.h"
+
+DependencyScanner::DependencyScanner(ImportResolver &resolver,
+                                     SourceSet &sources)
+    : resolver(resolver), sources(sources) {
+}
+
+DependencyScanner::~DependencyScanner() {
+}
+
+void DependencyScanner::scan(LessTokenizer &tokenizer) {
+  // Depth of the block that is skipped: the block of an at-rule other
+  // than @media, or a block inside parentheses.
+  unsigned int skipped = 0;
+  // Depth of parentheses and square brackets in the current statement.
+  unsigned int parens = 0;
+  // The next token starts a statement.
+  bool start = true;
+  // The statement is an at-rule other than @media.
+  bool atrule = false;
+  // The previous token ends with '@', so a '{' starts an interpolated
+  // variable rather than a block.
+  bool at = false;
+  bool interpolation = false;
+  bool begin;
+  Token::Type type = tokenizer.readNextToken();
+
+  while (type != Token::EOS) {
+    Token &t = tokenizer.getToken();
+
+    if (skipped > 0) {
+      if (type == Token::BRACKET_OPEN)
+        skipped++;
+      else if (type == Token::BRACKET_CLOSED)
+        skipped--;
+
+    } else if (type == Token::WHITESPACE || type == Token::COMMENT) {
+      at = false;
+
+    } else if (type == Token::ATKEYWORD && start && parens == 0 &&
+               t == "@import") {
+      // Leaves the token after the statement to be looked at next.
+      scanImport(tokenizer);
+      type = tokenizer.getTokenType();
+      start = at = false;
+      atrule = true;
+      continue;
+
+    } else {
+      begin = false;
+
+      switch (type) {
+        case Token::ATKEYWORD:
+          if (start && parens == 0)
+            atrule = t != "@media";
+          break;
+
+        case Token::PAREN_OPEN:
+        case Token::BRACE_OPEN:
+          parens++;
+          break;
+
+        case Token::PAREN_CLOSED:
+        case Token::BRACE_CLOSED:
+          if (parens > 0)
+            parens--;
+          break;
+
+        case Token::DELIMITER:
+          begin = parens == 0;
+          break;
+
+        case Token::BRACKET_OPEN:
+          if (at) {
+            interpolation = true;
+          } else if (parens > 0) {
+            skipped = 1;
+          } else {
+            if (atrule)
+              skipped = 1;
+            begin = true;
+          }
+          break;
+
+        case Token::BRACKET_CLOSED:
+          if (interpolation) {
+            interpolation = false;
+          } else {
+            parens = 0;
+            begin = true;
+          }
+          break;
+
+        default:
+          break;
+      }
+
+      if (begin) {
+        start = true;
+        atrule = at = false;
+      } else {
+        start = false;
+        at = t[t.size() - 1] == '@';
+      }
+    }
+    type = tokenizer.readNextToken();
+  }
+}
+
+void DependencyScanner::scanImport(LessTokenizer &tokenizer) {
+  TokenList rule;
+  unsigned int parens = 0, directive;
+  Token::Type type;
+
+  // The tokens up to the end of the statement, as
+  // LessParser::parseAtRuleValue() would read them.
+  while ((type = tokenizer.readNextToken()) != Token::EOS) {
+    if (type == Token::PAREN_OPEN || type == Token::BRACE_OPEN) {
+      parens++;
+    } else if (type == Token::PAREN_CLOSED || type == Token::BRACE_CLOSED) {
+      if (parens > 0)
+        parens--;
+    } else if (parens == 0 && (type == Token::DELIMITER ||
+                               type == Token::BRACKET_OPEN ||
+                               type == Token::BRACKET_CLOSED)) {
+      break;
+    }
+
+    if (type != Token::WHITESPACE && type != Token::COMMENT)
+      rule.push_back(tokenizer.getToken());
+  }
+
+  // A variable named @import.
+  if (rule.empty() || rule.front().type == Token::COLON)
+    return;
+
+  Token &uri = LessParser::parseImportRule(rule, directive);
+  importFile(uri, directive);
+}
+
+void DependencyScanner::importFile(Token &uri, unsigned int directive) {
+  std::string source, directory, filename, path;
+  size_t pos;
+  SourceBuffer *buffer;
+  char *name;
+
+  if (!LessParser::getImportFilename(uri, directive))
+    return;
+
+  source = uri.getSource();
+  pos = source.find_last_of("/\\");
+  if (pos != std::string::npos)
+    directory = source.substr(0, pos + 1);
+
+  if (!resolver.resolve(directory, uri, filename, path)) {
+    if (directive & LessParser::IMPORT_OPTIONAL)
+      return;
+    throw new ParseException(uri, "existing file");
+  }
+
+  // The parser reads files imported with the multiple directive again,
+  // but that can not add files that are not in sources yet.
+  if (sources.containsPath(path))
+    return;
+
+  buffer = new SourceBuffer();
+  if (!buffer->open(filename.c_str())) {
+    delete buffer;
+    throw new ParseException(uri, "readable file");
+  }
+
+  name = new char[filename.length() + 1];
+  std::strcpy(name, filename.c_str());
+
+  LessTokenizer tokenizer(buffer, name);
+  sources.add(tokenizer.getSourceId());
+  scan(tokenizer);
+}
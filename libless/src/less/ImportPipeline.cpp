@@ -0,0 +1,234 @@
+#include "less/less/ImportPipeline.h"
+
+#include <cstring>
+
+#include "less/SourceSet.h"
+#include "less/css/SourceBuffer.h"
+#include "less/less/LessParser.h"
+#include "less/less/LessTokenizer.h"
+
+ImportPipeline::ImportPipeline(ImportResolver& resolver,
+                               unsigned int threads,
+                               StylesheetCache* cache)
+    : resolver(&resolver), cache(cache), stopping(false) {
+  unsigned int i;
+
+  // Tokens cache their atom the first time they are compared. Intern
+  // the shared builtin tokens now, so workers only read them.
+  Token::BUILTIN_COMMA.getAtom();
+  Token::BUILTIN_PAREN_OPEN.getAtom();
+  Token::BUILTIN_PAREN_CLOSED.getAtom();
+  Token::BUILTIN_IMPORTANT.getAtom();
+
+  for (i = 0; i < threads; i++)
+    workers.push_back(std::thread(&ImportPipeline::work, this));
+}
+
+ImportPipeline::~ImportPipeline() {
+  std::map<Key, std::shared_ptr<Job> >::iterator it;
+  std::vector<std::thread>::iterator t_it;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+
+  for (t_it = workers.begin(); t_it != workers.end(); t_it++)
+    (*t_it).join();
+
+  // Files that were never imported.
+  for (it = jobs.begin(); it != jobs.end(); it++) {
+    if (it->second != NULL && it->second->file != NULL) {
+      SourceRegistry::release(it->second->file->sourceId);
+      delete it->second->file;
+    }
+  }
+}
+
+void ImportPipeline::prefetch(const std::string& filename, bool reference) {
+  std::shared_ptr<Job> job;
+  Key key(filename, reference);
+
+  if (workers.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (jobs.find(key) != jobs.end())
+      return;
+
+    job = std::make_shared<Job>();
+    job->filename = filename;
+    job->reference = reference;
+    job->started = job->done = false;
+    job->file = NULL;
+    job->sourceId = 0;
+    job->begin = job->end = 0;
+
+    jobs[key] = job;
+    queue.push_back(job);
+  }
+  wakeup.notify_one();
+}
+
+ImportedFile* ImportPipeline::take(const std::string& filename,
+                                   bool reference) {
+  std::map<Key, std::shared_ptr<Job> >::iterator it;
+  std::shared_ptr<Job> job;
+  std::unique_lock<std::mutex> lock(mutex);
+
+  it = jobs.find(Key(filename, reference));
+  if (it == jobs.end() || it->second == NULL) {
+    lock.unlock();
+    return parse(filename, reference);
+  }
+
+  job = it->second;
+  it->second.reset();
+
+  if (!job->started) {
+    // Waiting for a worker to get to it would take longer.
+    job->started = true;
+    lock.unlock();
+    return parse(filename, reference);
+  }
+
+  finished.wait(lock, [&job] { return job->done; });
+  return job->file;
+}
+
+std::vector<ImportedFile*> ImportPipeline::parseChunks(
+    unsigned int sourceId,
+    const std::vector<size_t>& offsets,
+    bool reference) {
+  std::vector<std::shared_ptr<Job> > chunks;
+  std::vector<std::shared_ptr<Job> >::iterator it;
+  std::vector<ImportedFile*> files;
+  std::shared_ptr<Job> job;
+  size_t i;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (i = 0; i + 1 < offsets.size(); i++) {
+      job = std::make_shared<Job>();
+      job->reference = reference;
+      job->started = job->done = false;
+      job->file = NULL;
+      job->sourceId = sourceId;
+      job->begin = offsets[i];
+      job->end = offsets[i + 1];
+
+      chunks.push_back(job);
+      // The first chunk is parsed on this thread right away.
+      if (i > 0)
+        queue.push_back(job);
+    }
+  }
+  wakeup.notify_all();
+
+  // Parse the chunks that no worker has started yet here, in order.
+  for (it = chunks.begin(); it != chunks.end(); it++) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    job = *it;
+    if (!job->started) {
+      job->started = true;
+      lock.unlock();
+      job->file = parse(*job);
+    } else
+      finished.wait(lock, [&job] { return job->done; });
+    files.push_back(job->file);
+  }
+  return files;
+}
+
+unsigned int ImportPipeline::getThreads() const {
+  return workers.size();
+}
+
+void ImportPipeline::work() {
+  std::shared_ptr<Job> job;
+  ImportedFile* file;
+  std::unique_lock<std::mutex> lock(mutex);
+
+  for (;;) {
+    wakeup.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (stopping)
+      return;
+
+    job = queue.front();
+    queue.pop_front();
+    if (job->started)
+      continue;
+    job->started = true;
+
+    lock.unlock();
+    file = parse(*job);
+    lock.lock();
+
+    job->file = file;
+    job->done = true;
+    finished.notify_all();
+  }
+}
+
+ImportedFile* ImportPipeline::parse(const Job& job) {
+  if (job.filename.empty())
+    return parse(job.sourceId, job.begin, job.end, job.reference);
+  return parse(job.filename, job.reference);
+}
+
+ImportedFile* ImportPipeline::parse(const std::string& filename,
+                                    bool reference) {
+  ImportedFile* file = new ImportedFile(NULL);
+  SourceBuffer* buffer = new SourceBuffer();
+  char* source;
+  SourceSet sources;
+
+  if (!buffer->open(filename.c_str())) {
+    delete buffer;
+    file->readable = false;
+    return file;
+  }
+
+  source = new char[filename.length() + 1];
+  std::strcpy(source, filename.c_str());
+
+  LessTokenizer tokenizer(buffer, source);
+  LessParser parser(tokenizer, sources, reference);
+
+  parser.includePaths = resolver->getIncludePaths();
+  parser.resolver = resolver;
+  parser.pipeline = this;
+  file->sourceId = tokenizer.getSourceId();
+
+  if (cache != NULL && cache->load(*buffer, reference, *file))
+    return file;
+
+  parser.parseStylesheet(*file);
+
+  if (cache != NULL)
+    cache->store(*buffer, reference, *file);
+  return file;
+}
+
+ImportedFile* ImportPipeline::parse(unsigned int sourceId,
+                                    size_t begin,
+                                    size_t end,
+                                    bool reference) {
+  ImportedFile* file = new ImportedFile(NULL);
+  SourceSet sources;
+  LessTokenizer tokenizer(sourceId, begin, end);
+  LessParser parser(tokenizer, sources, reference);
+
+  parser.includePaths = resolver->getIncludePaths();
+  parser.resolver = resolver;
+  parser.pipeline = this;
+  file->sourceId = sourceId;
+
+  parser.parseStylesheet(*file);
+  return file;
+}
@@ -0,0 +1,84 @@
+#include "less/less/ImportResolver.h"
+
+#include <sys/stat.h>
+
+#include "less/SourceRegistry.h"
+
+ImportResolver::ImportResolver(std::list<const char *> *includePaths)
+    : includePaths(includePaths) {
+}
+
+ImportResolver::~ImportResolver() {
+}
+
+std::list<const char *> *ImportResolver::getIncludePaths() const {
+  return includePaths;
+}
+
+bool ImportResolver::resolve(const std::string &directory,
+                             const std::string &uri,
+                             std::string &filename,
+                             std::string &path) {
+  std::string key = directory + '\0' + uri;
+  std::unordered_map<std::string, Resolution>::iterator it;
+  std::list<const char *>::iterator i;
+  Resolution r;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    it = resolutions.find(key);
+    if (it != resolutions.end()) {
+      filename = it->second.filename;
+      path = it->second.path;
+      return it->second.found;
+    }
+  }
+
+  // Probe without holding the lock; two threads resolving the same
+  // import at once both get the same answer.
+  r.filename = directory + uri;
+  r.found = exists(r.filename);
+
+  if (!r.found && includePaths != NULL) {
+    for (i = includePaths->begin(); i != includePaths->end(); i++) {
+      r.filename = (*i);
+      r.filename.append(uri);
+
+      if ((r.found = exists(r.filename)))
+        break;
+    }
+  }
+
+  if (r.found)
+    r.path = SourceRegistry::canonicalPath(r.filename.c_str());
+  else
+    r.filename.clear();
+
+  filename = r.filename;
+  path = r.path;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  resolutions.insert(std::make_pair(key, r));
+  return r.found;
+}
+
+bool ImportResolver::exists(const std::string &filename) {
+  std::unordered_map<std::string, bool>::iterator it;
+  struct stat st;
+  bool found;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    it = files.find(filename);
+    if (it != files.end())
+      return it->second;
+  }
+
+  found = stat(filename.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  files[filename] = found;
+  return found;
+}
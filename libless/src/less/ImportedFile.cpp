@@ -0,0 +1,20 @@
+#include "less/less/ImportedFile.h"
+
+ImportedFile::ImportedFile(LessStylesheet* target)
+    : target(target), sourceId(0), readable(true), serial(false) {
+}
+
+ImportedFile::~ImportedFile() {
+  std::vector<LessStylesheet*>::iterator it;
+
+  for (it = segments.begin(); it != segments.end(); it++)
+    delete *it;
+}
+
+LessStylesheet& ImportedFile::current() {
+  return segments.empty() ? *target : *segments.back();
+}
+
+bool ImportedFile::isDeferring() const {
+  return !segments.empty();
+}
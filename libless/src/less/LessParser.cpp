@@ -1,16 +1,126 @@
 #include "less/less/LessParser.h"
 
 #include <libgen.h>
+#include <utility>
+
+#include "less/less/ImportPipeline.h"
+#include "less/less/ReferenceRuleset.h"
+#include "less/less/StatementSplitter.h"
 
 /**
  * Only allows LessStylesheets
  */
 void LessParser::parseStylesheet(LessStylesheet &stylesheet) {
-  CssParser::parseStylesheet(stylesheet);
+  if (pipeline == NULL) {
+    CssParser::parseStylesheet(stylesheet);
+    return;
+  }
+
+  if (splitSize > 0 && parseChunks(stylesheet))
+    return;
+
+  ImportedFile file(&stylesheet);
+
+  parseStylesheet(file);
+  splice(file, stylesheet);
+}
+
+bool LessParser::parseChunks(LessStylesheet &stylesheet) {
+  unsigned int sourceId = tokenizer->getSourceId();
+  const SourceBuffer *content;
+  std::vector<size_t> offsets;
+  std::vector<ImportedFile *> files;
+  size_t i;
+  bool parsed = true;
+
+  if (pipeline->getThreads() < 2 || !SourceRegistry::hasContent(sourceId))
+    return false;
+
+  content = SourceRegistry::getContent(sourceId);
+  if (!content->isComplete() ||
+      !StatementSplitter::split(content->getData(),
+                                content->getSize(),
+                                pipeline->getThreads(),
+                                splitSize,
+                                offsets)) {
+    return false;
+  }
+
+  files = pipeline->parseChunks(sourceId, offsets, reference);
+
+  for (i = 0; i < files.size(); i++) {
+    if (files[i]->error || files[i]->serial)
+      parsed = false;
+  }
+  if (!parsed) {
+    for (i = 0; i < files.size(); i++)
+      delete files[i];
+    return false;
+  }
+
+  for (i = 0; i < files.size(); i++) {
+    try {
+      splice(*files[i], stylesheet);
+    } catch (...) {
+      for (; i < files.size(); i++)
+        delete files[i];
+      throw;
+    }
+    delete files[i];
+  }
+  return true;
+}
+
+void LessParser::parseStylesheet(ImportedFile &file) {
+  deferred = &file;
+  file.segments.push_back(new LessStylesheet());
+
+  try {
+    tokenizer->readNextToken();
+
+    skipWhitespace();
+    // An import can start a new segment, so look up the current one for
+    // every statement.
+    while (parseStatement(file.current()) || parseEmptyStatement(file)) {
+      skipWhitespace();
+    }
+
+    if (tokenizer->getTokenType() != Token::EOS) {
+      throw new ParseException(tokenizer->getToken(), "end of input");
+    }
+  } catch (...) {
+    file.error = std::current_exception();
+  }
+  deferred = NULL;
+}
+
+bool LessParser::parseEmptyStatement(ImportedFile &file) {
+  ImportedFile::Warning w;
+
+  if (!file.isDeferring() || tokenizer->getTokenType() != Token::DELIMITER)
+    return CssParser::parseEmptyStatement();
+
+  // The file may be parsed ahead of time, or never be imported, so the
+  // warning waits until the segment is spliced.
+  w.segment = file.segments.size() - 1;
+  w.token = tokenizer->getToken();
+  file.warnings.push_back(w);
+
+  tokenizer->readNextToken();
+  return true;
 }
 
 void LessParser::parseStylesheet(LessRuleset &ruleset) {
-  while (parseRulesetStatement(ruleset));
+  tokenizer->readNextToken();
+  skipWhitespace();
+
+  while (parseRulesetStatement(ruleset) || CssParser::parseEmptyStatement()) {
+    skipWhitespace();
+  }
+
+  if (tokenizer->getTokenType() != Token::EOS) {
+    throw new ParseException(tokenizer->getToken(), "end of input");
+  }
 }
 
 void LessParser::skipWhitespace() {
@@ -58,14 +168,13 @@ bool LessParser::parseStatement(Stylesheet &stylesheet) {
 
 bool LessParser::parseAtRuleOrVariable(LessStylesheet *stylesheet,
                                        LessRuleset *ruleset) {
-  Token token;
-  TokenList value, rule;
-  AtRule *atrule = NULL;
-
   if (tokenizer->getTokenType() != Token::ATKEYWORD)
     return false;
 
-  token = tokenizer->getToken();
+  Token token = tokenizer->getToken();
+  TokenList value, rule;
+  AtRule *atrule = NULL;
+
   tokenizer->readNextToken();
   CssParser::skipWhitespace();
 
@@ -197,6 +306,11 @@ bool LessParser::parseRuleset(TokenList &selector,
   if (tokenizer->getTokenType() != Token::BRACKET_OPEN)
     return false;
 
+  if (reference && parentRuleset == NULL) {
+    parseReferenceRuleset(selector, *stylesheet);
+    return true;
+  }
+
   tokenizer->readNextToken();
   skipWhitespace();
 
@@ -222,6 +336,80 @@ bool LessParser::parseRuleset(TokenList &selector,
   return true;
 }
 
+void LessParser::parseReferenceRuleset(TokenList &selector,
+                                       LessStylesheet &stylesheet) {
+  LessRuleset *ruleset;
+  LessSelector *s;
+  size_t begin, end;
+  unsigned int depth = 1;
+  bool imports = false;
+
+  tokenizer->readNextToken();
+  begin = tokenizer->getToken().offset;
+
+  // Find the closing brace with the tokenizer, so braces in strings
+  // and comments are passed over.
+  for (;;) {
+    switch (tokenizer->getTokenType()) {
+      case Token::EOS:
+        throw new ParseException(tokenizer->getToken(),
+                                 "end of declaration block ('}')");
+      case Token::BRACKET_OPEN:
+        depth++;
+        break;
+      case Token::BRACKET_CLOSED:
+        depth--;
+        break;
+      case Token::ATKEYWORD:
+        if (tokenizer->getToken() == "@import")
+          imports = true;
+        break;
+      default:
+        break;
+    }
+    if (depth == 0)
+      break;
+    tokenizer->readNextToken();
+  }
+  end = tokenizer->getToken().offset;
+
+  s = new LessSelector();
+  lessSelectorParser.parse(selector, *s);
+
+  if (imports) {
+    ruleset = stylesheet.createLessRuleset(*s);
+    ruleset->setReference(reference);
+
+    LessTokenizer block(tokenizer->getSourceId(), begin, end);
+    LessParser parser(block, sources, reference);
+
+    parser.includePaths = includePaths;
+    parser.pipeline = pipeline;
+    parser.resolver = resolver;
+    parser.deferred = deferred;
+    parser.parseRulesetBlock(*ruleset);
+  } else {
+    ruleset = new ReferenceRuleset(
+        *s, stylesheet, tokenizer->getSourceId(), begin, end);
+    stylesheet.addLessRuleset(*ruleset);
+  }
+
+  tokenizer->readNextToken();
+  skipWhitespace();
+}
+
+void LessParser::parseRulesetBlock(LessRuleset &ruleset) {
+  tokenizer->readNextToken();
+  skipWhitespace();
+
+  while (parseRulesetStatement(ruleset));
+
+  if (tokenizer->getTokenType() != Token::EOS) {
+    throw new ParseException(tokenizer->getToken(),
+                             "end of declaration block ('}')");
+  }
+}
+
 bool LessParser::parseRuleset(LessStylesheet &parent, TokenList &selector) {
   return parseRuleset(selector, &parent, NULL);
 }
@@ -298,7 +486,17 @@ bool LessParser::parsePropertyVariable(TokenList &selector) {
 }
 
 bool LessParser::parseRulesetStatement(LessRuleset &ruleset) {
-  TokenList tokens;
+  TokenList tokens(std::move(statementBuffer));
+  bool ret = parseRulesetStatement(ruleset, tokens);
+
+  tokens.clear();
+  if (tokens.capacity() > statementBuffer.capacity())
+    statementBuffer = std::move(tokens);
+  return ret;
+}
+
+bool LessParser::parseRulesetStatement(LessRuleset &ruleset,
+                                       TokenList &tokens) {
   size_t property_i;
 
   if (parseComment(ruleset))
@@ -330,18 +528,22 @@ bool LessParser::parseRulesetStatement(LessRuleset &ruleset) {
   tokens.trim();
 
   if (tokens.empty())
-    return NULL;
+    return false;
 
   if (parseRuleset(ruleset, tokens))
     return true;
 
   parseValue(tokens);
-  
-  if (parseExtension(tokens, ruleset) ||
-      parseDeclaration(tokens, property_i, ruleset)) {
-  } else {
+
+  // The whole statement has been read, so its kind is decided here
+  // and only the parse function for that kind looks at the tokens.
+  if (isExtension(tokens))
+    parseExtension(tokens, ruleset);
+  else if (property_i > 0 && tokens.front().type != Token::HASH &&
+           tokens.front() != ".")
+    parseDeclaration(tokens, property_i, ruleset);
+  else
     parseMixin(tokens, ruleset);
-  }
 
   if (tokenizer->getTokenType() == Token::DELIMITER) {
     tokenizer->readNextToken();
@@ -362,21 +564,22 @@ bool LessParser::parseComment(LessRuleset& ruleset) {
   return true;
 }
 
-bool LessParser::parseExtension(TokenList &statement, LessRuleset &ruleset) {
-  TokenList::iterator i = statement.begin();
+bool LessParser::isExtension(const TokenList &statement) const {
+  TokenList::const_iterator i = statement.begin();
+
+  return statement.size() > 5 &&
+    (*i) == "&" &&
+    (*++i).type == Token::COLON &&
+    (*++i).type == Token::IDENTIFIER &&
+    (*i) == "extend" &&
+    (*++i).type == Token::PAREN_OPEN;
+}
+
+void LessParser::parseExtension(TokenList &statement, LessRuleset &ruleset) {
+  TokenList::iterator i = statement.begin() + 4, begin = i;
   int parentheses = 1;
   Extension extension;
-  TokenList target;
-
-  if (statement.size() <= 5 ||
-      (*i) != "&" ||
-      (*++i).type != Token::COLON ||
-      (*++i).type != Token::IDENTIFIER ||
-      (*i) != "extend" ||
-      (*++i).type != Token::PAREN_OPEN)
-    return false;
 
-  i++;
   for (; i != statement.end() && parentheses > 0; i++) {
     switch ((*i).type) {
     case Token::PAREN_OPEN:
@@ -388,52 +591,45 @@ bool LessParser::parseExtension(TokenList &statement, LessRuleset &ruleset) {
     default:
       break;
     }
-    if (parentheses > 0)
-      target.push_back(*i);
   }
 
   if (parentheses > 0) {
     throw new ParseException("end of statement",
                              ")",
-                             statement.front().line,
-                             statement.front().column,
-                             statement.front().source);
+                             statement.front().getLine(),
+                             statement.front().getColumn(),
+                             statement.front().getSource());
   }
 
-  if (!target.empty() && target.back() == "all") {
+  // The target is what is inside the parentheses.
+  statement.erase(i - 1, statement.end());
+  statement.erase(statement.begin(), begin);
+
+  if (!statement.empty() && statement.back() == "all") {
     extension.setAll(true);
-    target.pop_back();
-    target.rtrim();
+    statement.pop_back();
+    statement.rtrim();
   }
-  selectorParser.parse(target, extension.getTarget());
+  selectorParser.parse(statement, extension.getTarget());
 
   ruleset.addExtension(extension);
-  
-  return true;
 }
 
-bool LessParser::parseDeclaration(TokenList &tokens,
+void LessParser::parseDeclaration(TokenList &tokens,
                                   size_t property_i,
                                   LessRuleset &ruleset) {
   LessDeclaration* d;
-  TokenList::iterator i;
-  TokenList property;
+  TokenList::iterator i, end;
   Token keyword;
-  
-  if (property_i == 0 ||
-      tokens.front().type == Token::HASH ||
-      tokens.front() == ".") {
-    return false;
-  }
-  
+
   d = ruleset.createLessDeclaration();
 
   i = tokens.begin();
-  std::advance(i, property_i);
-  
-  property.insert(property.begin(), tokens.begin(), i);
-  keyword = property.front();
-  keyword.assign(property.toString());
+  end = i + property_i;
+
+  keyword = *i;
+  for (i++; i != end; i++)
+    keyword.append(*i);
   d->setProperty(keyword);
 
   while (i != tokens.end() && (*i).type == Token::WHITESPACE) 
@@ -444,10 +640,8 @@ bool LessParser::parseDeclaration(TokenList &tokens,
   
   while (i != tokens.end() && (*i).type == Token::WHITESPACE) 
     i++;
-  
-  d->getValue().insert(d->getValue().begin(), i, tokens.end());
 
-  return true;
+  d->getValue().insert(d->getValue().begin(), i, tokens.end());
 }
 
 bool LessParser::parseMixin(TokenList &tokens,
@@ -465,12 +659,11 @@ bool LessParser::parseMixin(TokenList &tokens,
                             LessStylesheet *parent_s) {
   TokenList::const_iterator i = tokens.begin();
   Mixin *mixin;
-  TokenList name;
-  
-  for (; i != tokens.end() && (*i).type != Token::PAREN_OPEN; i++) {
-    name.push_back(*i);
-  }
 
+  while (i != tokens.end() && (*i).type != Token::PAREN_OPEN)
+    i++;
+
+  TokenList name(tokens.begin(), i);
   name.rtrim();
   if (parent_r != NULL)
     mixin = parent_r->createMixin(name);
@@ -565,6 +758,14 @@ bool LessParser::parseImportStatement(TokenList &statement,
                                       LessStylesheet *stylesheet,
                                       LessRuleset *ruleset) {
   unsigned int directive = 0;
+  Token &uri = parseImportRule(statement, directive);
+
+  return importFile(uri, stylesheet, ruleset, directive);
+}
+
+Token &LessParser::parseImportRule(TokenList &statement,
+                                   unsigned int &directive) {
+  directive = 0;
 
   // parse directives and strip from statement (the statement becomes a valid
   // css import statement.)
@@ -595,7 +796,7 @@ bool LessParser::parseImportStatement(TokenList &statement,
 
   if (statement.size() > 0 && (statement.front().type == Token::URL ||
                                statement.front().type == Token::STRING)) {
-    return importFile(statement.front(), stylesheet, ruleset, directive);
+    return statement.front();
 
   } else
     throw new ParseException(statement,
@@ -636,15 +837,9 @@ unsigned int LessParser::parseImportDirective(Token &t) {
                              "inline, less, css, once, multiple or optional");
 }
 
-bool LessParser::importFile(Token uri,
-                            LessStylesheet *stylesheet,
-                            LessRuleset *ruleset,
-                            unsigned int directive) {
+bool LessParser::getImportFilename(Token &uri, unsigned int directive) {
   size_t pathend;
   size_t extension_pos;
-  std::list<const char *>::iterator i;
-  std::string relative_filename;
-  char *relative_filename_cpy;
   std::string extension;
 
   if (uri.type == Token::URL) {
@@ -676,40 +871,95 @@ bool LessParser::importFile(Token uri,
       (directive & IMPORT_CSS)) {
     return false;
   }
+  return true;
+}
 
-  if (!findFile(uri, relative_filename)) {
+bool LessParser::importFile(Token uri,
+                            LessStylesheet *stylesheet,
+                            LessRuleset *ruleset,
+                            unsigned int directive) {
+  Token import = uri;
+  std::string relative_filename;
+  std::string path;
+  char *relative_filename_cpy;
+  SourceBuffer *buffer;
+  ImportedFile *file;
+
+  if (!getImportFilename(uri, directive))
+    return false;
+
+  if (deferred != NULL && deferred->isDeferring()) {
+    if (stylesheet == &deferred->current())
+      return deferImport(import, uri, directive);
+
+    // Imports inside a ruleset or media query are followed in place,
+    // after everything before them.
+    if (deferred->target == NULL) {
+      deferred->serial = true;
+      return true;
+    }
+    splice(*deferred, *deferred->target);
+  }
+
+  if (!findFile(uri, relative_filename, path)) {
     if (directive & IMPORT_OPTIONAL)
       return true;
     else {
-      throw new ParseException(
-          uri, "existing file", uri.line, uri.column, uri.source);
+      throw new ParseException(uri, "existing file");
     }
   }
 
-  if (!(directive & IMPORT_MULTIPLE)) {
-    // check if the file has already been imported.
-    for (i = sources.begin(); i != sources.end(); i++) {
-      if (relative_filename == (*i))
-        return true;
+  // check if the file has already been imported.
+  if (!(directive & IMPORT_MULTIPLE) &&
+      sources.containsPath(path))
+    return true;
+
+  if (pipeline != NULL && stylesheet != NULL) {
+    file = pipeline->take(relative_filename,
+                          (directive & IMPORT_REFERENCE) != 0);
+
+    if (!file->readable) {
+      delete file;
+      throw new ParseException(uri, "readable file");
+    }
+
+    if (!file->serial) {
+      sources.add(file->sourceId);
+      try {
+        splice(*file, *stylesheet);
+      } catch (...) {
+        delete file;
+        throw;
+      }
+      delete file;
+      return true;
     }
+    // The file is parsed again in place, from a new source.
+    SourceRegistry::release(file->sourceId);
+    delete file;
   }
 
-  ifstream in(relative_filename.c_str());
+  buffer = new SourceBuffer();
+  if (!buffer->open(relative_filename.c_str())) {
+    delete buffer;
+    throw new ParseException(uri, "readable file");
+  }
 
   relative_filename_cpy = new char[relative_filename.length() + 1];
   std::strcpy(relative_filename_cpy, relative_filename.c_str());
 
-  sources.push_back(relative_filename_cpy);
-  LessTokenizer tokenizer(in, relative_filename_cpy);
+  LessTokenizer tokenizer(buffer, relative_filename_cpy);
+  sources.add(tokenizer.getSourceId());
   LessParser parser(tokenizer, sources, (directive & IMPORT_REFERENCE));
 
   parser.includePaths = includePaths;
+  parser.pipeline = pipeline;
+  parser.resolver = resolver;
 
   if (stylesheet != NULL)
     parser.parseStylesheet(*stylesheet);
   else
     parser.parseStylesheet(*ruleset);
-  in.close();
   return true;
 }
 
@@ -724,43 +974,79 @@ bool LessParser::importFile(Token uri,
   return importFile(uri, NULL, &ruleset, directive);
 }
 
-bool LessParser::findFile(Token &uri, std::string &filename) {
-  ifstream *in;
+bool LessParser::findFile(Token &uri,
+                          std::string &filename,
+                          std::string &path) {
   size_t pos;
   std::string source;
-  std::list<const char *>::iterator i;
+  std::string directory;
 
-  source = uri.source;
+  source = uri.getSource();
   pos = source.find_last_of("/\\");
 
   // if the current stylesheet is outside of the current working
-  //  directory then add the directory to the filename.
-  if (pos != std::string::npos) {
-    filename.append(source.substr(0, pos + 1));
-  }
-  filename.append(uri);
+  //  directory then look in that directory first.
+  if (pos != std::string::npos)
+    directory = source.substr(0, pos + 1);
 
-  in = new ifstream(filename.c_str());
-  if (in->good()) {
-    in->close();
-    return true;
-  }
+  if (resolver != NULL)
+    return resolver->resolve(directory, uri, filename, path);
 
-  if (includePaths != NULL) {
-    for (i = includePaths->begin(); i != includePaths->end(); i++) {
-      filename.clear();
+  ImportResolver uncached(includePaths);
+  return uncached.resolve(directory, uri, filename, path);
+}
 
-      filename.append((*i));
-      filename.append(uri);
+bool LessParser::deferImport(const Token &import,
+                             Token &uri,
+                             unsigned int directive) {
+  ImportedFile::Import i;
+  std::string filename, path;
 
-      in = new ifstream(filename.c_str());
-      if (in->good()) {
-        in->close();
-        return true;
-      }
+  i.uri = import;
+  i.directive = directive;
+  deferred->imports.push_back(i);
+  deferred->segments.push_back(new LessStylesheet());
+
+  if (pipeline != NULL && findFile(uri, filename, path))
+    pipeline->prefetch(filename, (directive & IMPORT_REFERENCE) != 0);
+  return true;
+}
+
+void LessParser::splice(ImportedFile &file, LessStylesheet &stylesheet) {
+  std::vector<LessStylesheet *> segments;
+  std::vector<ImportedFile::Import> imports;
+  std::vector<ImportedFile::Warning> warnings;
+  std::vector<ImportedFile::Warning>::iterator w;
+  std::exception_ptr error;
+  size_t i = 0;
+
+  // Taking the segments ends deferring, so the imports below are
+  // followed.
+  segments.swap(file.segments);
+  imports.swap(file.imports);
+  warnings.swap(file.warnings);
+  w = warnings.begin();
+  std::swap(error, file.error);
+
+  try {
+    for (; i < segments.size(); i++) {
+      stylesheet.merge(*segments[i]);
+      delete segments[i];
+
+      for (; w != warnings.end() && w->segment == i; w++)
+        warnEmptyStatement(w->token);
+
+      if (i < imports.size())
+        importFile(imports[i].uri, &stylesheet, NULL, imports[i].directive);
     }
+  } catch (...) {
+    for (i++; i < segments.size(); i++)
+      delete segments[i];
+    throw;
   }
-  return false;
+
+  if (error)
+    std::rethrow_exception(error);
 }
 
 void LessParser::parseLessMediaQuery(Token &mediatoken,
@@ -5,7 +5,7 @@
 
 bool LessSelectorParser::parse(TokenList& tokens,
                                LessSelector& selector) {
-  std::list<TokenList>::iterator it;
+  Selector::iterator it;
   TokenList::iterator offset;
   
   bool args = (tokens.front().type == Token::HASH ||
@@ -21,7 +21,7 @@ bool LessSelectorParser::parse(TokenList& tokens,
        it != selector.end();
        it++) {
 
-    for (offset = (*it).begin(); offset != (*it).end(); offset++) {
+    for (offset = (*it).begin(); offset != (*it).end();) {
       
       if (parseExtension(*it, offset, selector)) {
         while (parseExtension(*it, offset, selector));
@@ -44,6 +44,10 @@ bool LessSelectorParser::parse(TokenList& tokens,
 
         parseConditions(*it, offset, selector);
       }
+
+      // the arguments and conditions may have been the last tokens.
+      if (offset != (*it).end())
+        offset++;
     }
     (*it).trim();
   }
@@ -56,8 +60,6 @@ bool LessSelectorParser::parseExtension(TokenList &tokens,
                                         LessSelector &s) {
   TokenList::iterator it = offset;
   int parentheses = 1;
-  Extension extension;
-  TokenList target, ext;
   
   if (it == tokens.end() ||
       (*it).type != Token::COLON ||
@@ -69,7 +71,7 @@ bool LessSelectorParser::parseExtension(TokenList &tokens,
     return false;
   
   it++;
-  tokens.erase(offset, it);
+  it = tokens.erase(offset, it);
   offset = it;
   
   for (; it != tokens.end() && parentheses > 0; it++) {
@@ -84,11 +86,13 @@ bool LessSelectorParser::parseExtension(TokenList &tokens,
                              "end of extension (')')");
   }
   it--;
-  
-  target.splice(target.begin(), tokens, offset, it);
+
+  Extension extension;
+  TokenList target(offset, it);
+  it = tokens.erase(offset, it);
   offset = it;
-  ext.insert(ext.begin(), tokens.begin(), offset);
-    
+  TokenList ext(tokens.begin(), offset);
+
   if (!target.empty() && target.back() == "all") {
     extension.setAll(true);
     target.pop_back();
@@ -98,8 +102,7 @@ bool LessSelectorParser::parseExtension(TokenList &tokens,
   selectorParser.parse(ext, extension.getExtension());
   s.addExtension(extension);
 
-  offset++;
-  tokens.erase(it);
+  offset = tokens.erase(it);
   return true;
 }
 
@@ -124,7 +127,7 @@ bool LessSelectorParser::isArguments(TokenList &selector,
     it++;
   }
   
-  if ((*it).type != Token::PAREN_CLOSED)
+  if (it == selector.end() || (*it).type != Token::PAREN_CLOSED)
     return false;
   it++;
   
@@ -185,8 +188,7 @@ bool LessSelectorParser::parseArguments(TokenList &selector,
     return false;
   } else {
     it++;
-    selector.erase(offset, it);
-    offset = it;
+    offset = selector.erase(offset, it);
     return true;
   }
 }
@@ -252,11 +254,12 @@ bool LessSelectorParser::parseDefaultValue(TokenList &arguments,
 bool LessSelectorParser::parseConditions(TokenList &selector,
                                          TokenList::iterator &offset,
                                          LessSelector &s) {
-  TokenList condition;
   TokenList::iterator it = offset;
   
   if (it == selector.end() || *it != "when")
     return false;
+
+  TokenList condition;
   it = selector.erase(it);
   offset = it;
   
@@ -265,7 +268,8 @@ bool LessSelectorParser::parseConditions(TokenList &selector,
       it++;
     }
     
-    condition.splice(condition.begin(), selector, offset, it);
+    condition.insert(condition.begin(), offset, it);
+    it = selector.erase(offset, it);
     condition.trim();
     s.addCondition(condition);
     condition.clear();
@@ -1,4 +1,7 @@
 #include "less/less/LessTokenizer.h"
+#include "less/css/CharScanner.h"
+
+constexpr unsigned char LessTokenizer::charClasses[256];
 
 LessTokenizer::~LessTokenizer() {
 }
@@ -7,11 +10,9 @@ bool LessTokenizer::readComment() {
   if (!lastReadEq('/'))
     return CssTokenizer::readComment();
 
-  currentToken.append(lastRead);
   readChar();
-  while (in != NULL && !lastReadEq('\n')) {
-    currentToken.append(lastRead);
-    readChar();
+  while (!eof && !lastReadEq('\n')) {
+    skipTo(CharScanner::find(pos, end, '\n'));
   }
   return true;
 }
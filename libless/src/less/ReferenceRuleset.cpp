@@ -0,0 +1,57 @@
+#include "less/less/ReferenceRuleset.h"
+
+#include "less/SourceSet.h"
+#include "less/less/LessParser.h"
+#include "less/less/LessTokenizer.h"
+
+ReferenceRuleset::ReferenceRuleset(LessSelector &selector,
+                                   const LessStylesheet &parent,
+                                   unsigned int sourceId,
+                                   size_t begin,
+                                   size_t end)
+    : LessRuleset(selector, parent),
+      sourceId(sourceId),
+      begin(begin),
+      end(end),
+      loaded(false) {
+  setReference(true);
+}
+
+ReferenceRuleset::~ReferenceRuleset() {
+}
+
+unsigned int ReferenceRuleset::getSourceId() const {
+  return sourceId;
+}
+size_t ReferenceRuleset::getBegin() const {
+  return begin;
+}
+size_t ReferenceRuleset::getEnd() const {
+  return end;
+}
+
+bool ReferenceRuleset::isLoaded() const {
+  return loaded;
+}
+
+void ReferenceRuleset::load() const {
+  if (loaded)
+    return;
+  loaded = true;
+
+  // Blocks that hold an @import are parsed right away, so no files
+  // are added to these sources.
+  LessTokenizer tokenizer(sourceId, begin, end);
+  SourceSet sources;
+  LessParser parser(tokenizer, sources, true);
+
+  parser.parseRulesetBlock(const_cast<ReferenceRuleset &>(*this));
+}
+
+void ReferenceRuleset::getFunctions(std::list<const Function *> &functionList,
+                                    const Mixin &mixin,
+                                    TokenList::const_iterator selector_offset,
+                                    const ProcessingContext &context) const {
+  load();
+  LessRuleset::getFunctions(functionList, mixin, selector_offset, context);
+}
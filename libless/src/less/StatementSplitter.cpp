@@ -0,0 +1,182 @@
+#include "less/less/StatementSplitter.h"
+
+#include <cstring>
+
+#include "less/css/CharScanner.h"
+
+namespace {
+
+bool isNameChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '-' || c == '_' ||
+         (unsigned char)c >= 0x80;
+}
+
+}  // namespace
+
+bool StatementSplitter::split(const char *data,
+                              size_t size,
+                              unsigned int chunks,
+                              size_t minSize,
+                              std::vector<size_t> &offsets) {
+  const char *p = data, *end = data + size, *next;
+  // Depth of blocks, and of parentheses and square brackets.
+  unsigned int blocks = 0, parens = 0;
+  size_t offset;
+  bool boundary;
+
+  if (minSize > 0 && size / minSize < chunks)
+    chunks = size / minSize;
+  if (chunks < 2)
+    return false;
+
+  offsets.clear();
+  offsets.push_back(0);
+
+  while (p != end && offsets.size() < chunks) {
+    boundary = false;
+
+    switch (*p) {
+      case '"':
+      case '\'':
+        if ((p = skipString(p, end)) == NULL)
+          return false;
+        continue;
+
+      case '/':
+        if (p + 1 != end && p[1] == '*') {
+          if ((p = skipComment(p, end)) == NULL)
+            return false;
+          continue;
+        } else if (p + 1 != end && p[1] == '/') {
+          p = CharScanner::find(p, end, '\n');
+          continue;
+        }
+        break;
+
+      case '\\':
+        // The escaped character is part of a name.
+        if (++p == end)
+          return false;
+        break;
+
+      case '(':
+        if (isUrl(data, p)) {
+          if ((next = skipUrl(p, end)) == NULL)
+            return false;
+          if (next != p) {
+            p = next;
+            continue;
+          }
+        }
+        parens++;
+        break;
+
+      case '[':
+        parens++;
+        break;
+
+      case ')':
+      case ']':
+        if (parens == 0)
+          return false;
+        parens--;
+        break;
+
+      case '{':
+        if (p != data && p[-1] == '@') {
+          if ((p = skipInterpolation(p, end)) == NULL)
+            return false;
+          continue;
+        }
+        blocks++;
+        break;
+
+      case '}':
+        if (blocks == 0)
+          return false;
+        if (--blocks == 0 && parens == 0) {
+          next = CharScanner::skipWhitespace(p + 1, end);
+          boundary = (next == end || *next != ';');
+        }
+        break;
+
+      case ';':
+        boundary = (blocks == 0 && parens == 0);
+        break;
+
+      default:
+        break;
+    }
+    p++;
+
+    // Each boundary is the first one past its share of the data.
+    offset = p - data;
+    if (boundary && offset < size &&
+        offset >= size / chunks * offsets.size())
+      offsets.push_back(offset);
+  }
+
+  if (offsets.size() < 2)
+    return false;
+  offsets.push_back(size);
+  return true;
+}
+
+const char *StatementSplitter::skipString(const char *p, const char *end) {
+  char delim = *p;
+
+  p++;
+  while ((p = CharScanner::findStringEnd(p, end, delim)) != end) {
+    if (*p == delim)
+      return p + 1;
+    if (*p != '\\')
+      return NULL;
+
+    // An escaped character or newline.
+    if (++p == end)
+      return NULL;
+    if (*p == '\r' && p + 1 != end && p[1] == '\n')
+      p++;
+    p++;
+  }
+  return NULL;
+}
+
+const char *StatementSplitter::skipComment(const char *p, const char *end) {
+  for (p += 2; (p = CharScanner::find(p, end, '*')) != end; p++) {
+    if (p + 1 != end && p[1] == '/')
+      return p + 2;
+  }
+  return NULL;
+}
+
+bool StatementSplitter::isUrl(const char *data, const char *p) {
+  if (p - data < 3 || std::memcmp(p - 3, "url", 3) != 0)
+    return false;
+  p -= 3;
+
+  // Otherwise the name is longer, or part of an @-keyword or a hash.
+  return p == data ||
+         !(isNameChar(p[-1]) || p[-1] == '\\' || p[-1] == '@' ||
+           p[-1] == '#');
+}
+
+const char *StatementSplitter::skipUrl(const char *p, const char *end) {
+  const char *q = CharScanner::skipWhitespace(p + 1, end);
+
+  if (q != end && (*q == '"' || *q == '\''))
+    return p;
+
+  for (; q != end && *q != ')'; q++) {
+    if (*q == '"' || *q == '\'' || *q == '(' || *q == '\\')
+      return NULL;
+  }
+  return q == end ? NULL : q + 1;
+}
+
+const char *StatementSplitter::skipInterpolation(const char *p,
+                                                 const char *end) {
+  p = CharScanner::skipName(p + 1, end);
+  return (p != end && *p == '}') ? p + 1 : NULL;
+}
@@ -0,0 +1,1010 @@
+#include "less/less/StylesheetCache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "less/SourceRegistry.h"
+#include "less/SourceSet.h"
+#include "less/css/IOException.h"
+#include "less/less/ReferenceRuleset.h"
+#include "less/lessstylesheet/LessDeclaration.h"
+#include "less/lessstylesheet/LessMediaQuery.h"
+#include "less/lessstylesheet/MediaQueryRuleset.h"
+#include "less/stylesheet/CssComment.h"
+
+namespace {
+
+const char MAGIC[4] = {'L', 'S', 'C', '\n'};
+const char SNAPSHOT_MAGIC[4] = {'L', 'S', 'S', '\n'};
+
+enum Tag {
+  COMMENT,
+  RULESET,
+  MIXIN,
+  ATRULE,
+  MEDIA,
+  DECLARATION,
+  MEDIA_RULESET,
+  REFERENCE_RULESET
+};
+
+/**
+ * Serializes the statements of one file, or of all files of a
+ * compilation for a snapshot. Numbers are written 7 bits at a time,
+ * strings as an index into a table that is written in front of the
+ * statements.
+ */
+class Writer {
+public:
+  std::string body;
+
+  /**
+   * Cleared when a statement or token is found that can't be stored.
+   */
+  bool cacheable;
+
+  /**
+   * Tokens read from files in the set are stored with the index of
+   * their file.
+   */
+  Writer(unsigned int sourceId, const SourceSet *files = NULL)
+      : cacheable(true), sourceId(sourceId), files(files) {
+  }
+
+  void writeNumber(unsigned long long n) {
+    while (n >= 0x80) {
+      body.push_back((char)(n | 0x80));
+      n >>= 7;
+    }
+    body.push_back((char)n);
+  }
+
+  void writeString(const std::string &s) {
+    std::pair<std::unordered_map<std::string, size_t>::iterator, bool> ret;
+
+    ret = indices.insert(std::make_pair(s, strings.size()));
+    if (ret.second)
+      strings.push_back(&ret.first->first);
+    writeNumber(ret.first->second);
+  }
+
+  void writeToken(const Token &t) {
+    size_t i;
+
+    writeNumber(t.type);
+    writeString(t);
+
+    // Tokens of the file itself get the source id of the file they
+    // are loaded as; the others keep the name of their source.
+    if (t.sourceId == sourceId) {
+      writeNumber(0);
+    } else if (files != NULL &&
+               (i = files->indexOf(t.sourceId)) < files->size()) {
+      writeNumber(2);
+      writeNumber(i);
+    } else if (!SourceRegistry::hasContent(t.sourceId)) {
+      writeNumber(1);
+      writeString(SourceRegistry::getName(t.sourceId));
+    } else
+      cacheable = false;
+    writeNumber(t.offset);
+  }
+
+  void writeTokens(const TokenList &tokens) {
+    TokenList::const_iterator it;
+
+    writeNumber(tokens.size());
+    for (it = tokens.begin(); it != tokens.end(); it++)
+      writeToken(*it);
+  }
+
+  void writeSelector(const Selector &selector) {
+    Selector::const_iterator it;
+
+    writeNumber(selector.size());
+    for (it = selector.begin(); it != selector.end(); it++)
+      writeTokens(*it);
+  }
+
+  void writeExtension(const Extension &extension) {
+    writeSelector(extension.getTarget());
+    writeSelector(extension.getExtension());
+    writeNumber(extension.isAll());
+  }
+
+  void writeExtensions(const std::list<Extension> &extensions) {
+    std::list<Extension>::const_iterator it;
+
+    writeNumber(extensions.size());
+    for (it = extensions.begin(); it != extensions.end(); it++)
+      writeExtension(*it);
+  }
+
+  void writeLessSelector(const LessSelector &selector) {
+    std::list<std::string>::const_iterator p_it;
+    std::list<TokenList>::const_iterator d_it, c_it;
+
+    writeSelector(selector);
+    writeExtensions(selector.getExtensions());
+
+    writeNumber(selector.getParameters().size());
+    d_it = selector.getDefaults().begin();
+    for (p_it = selector.getParameters().begin();
+         p_it != selector.getParameters().end();
+         p_it++, d_it++) {
+      writeString(*p_it);
+      writeTokens(*d_it);
+    }
+
+    writeNumber(selector.getConditions().size());
+    for (c_it = selector.getConditions().begin();
+         c_it != selector.getConditions().end();
+         c_it++) {
+      writeTokens(*c_it);
+    }
+
+    writeNumber(selector.unlimitedArguments());
+    writeNumber(selector.needsArguments());
+    writeString(selector.getRestIdentifier());
+  }
+
+  void writeVariables(const VariableMap &variables) {
+    VariableMap::const_iterator it;
+
+    writeNumber(variables.size());
+    for (it = variables.begin(); it != variables.end(); it++) {
+      writeString(VariableMap::getName(it));
+      writeTokens(it->second);
+    }
+  }
+
+  void writeMixin(const Mixin &mixin) {
+    std::map<std::string, TokenList>::const_iterator it;
+    size_t i;
+
+    writeTokens(mixin.name);
+    writeNumber(mixin.arguments.count());
+    for (i = 0; i < mixin.arguments.count(); i++)
+      writeTokens(*mixin.arguments.get(i));
+
+    writeNumber(mixin.arguments.getNamedArguments().size());
+    for (it = mixin.arguments.getNamedArguments().begin();
+         it != mixin.arguments.getNamedArguments().end();
+         it++) {
+      writeString(it->first);
+      writeTokens(it->second);
+    }
+    writeNumber(mixin.isImportant());
+    writeNumber(mixin.isReference());
+  }
+
+  void writeAtRule(const AtRule &atrule) {
+    writeToken(atrule.getKeyword());
+    writeTokens(atrule.getRule());
+    writeNumber(atrule.isReference());
+  }
+
+  void writeRuleset(const LessRuleset &ruleset) {
+    std::list<RulesetStatement *>::const_iterator s_it;
+    std::list<LessRuleset *>::const_iterator r_it;
+    const CssComment *comment;
+    const LessDeclaration *declaration;
+    const Mixin *mixin;
+    const LessAtRule *atrule;
+    const MediaQueryRuleset *query;
+
+    writeNumber(ruleset.isReference());
+
+    writeNumber(ruleset.getStatements().size());
+    for (s_it = ruleset.getStatements().begin();
+         s_it != ruleset.getStatements().end();
+         s_it++) {
+      if ((comment = dynamic_cast<const CssComment *>(*s_it)) != NULL) {
+        writeNumber(COMMENT);
+        writeToken(comment->getComment());
+        writeNumber(comment->isReference());
+
+      } else if ((declaration =
+                      dynamic_cast<const LessDeclaration *>(*s_it)) != NULL) {
+        writeNumber(DECLARATION);
+        writeToken(declaration->getProperty());
+        writeTokens(declaration->getValue());
+
+      } else if ((mixin = dynamic_cast<const Mixin *>(*s_it)) != NULL) {
+        writeNumber(MIXIN);
+        writeMixin(*mixin);
+
+      } else if ((atrule = dynamic_cast<const LessAtRule *>(*s_it)) != NULL) {
+        writeNumber(ATRULE);
+        writeAtRule(*atrule);
+
+      } else
+        cacheable = false;
+    }
+
+    writeNumber(ruleset.getNestedRules().size());
+    for (r_it = ruleset.getNestedRules().begin();
+         r_it != ruleset.getNestedRules().end();
+         r_it++) {
+      if ((query = dynamic_cast<const MediaQueryRuleset *>(*r_it)) != NULL) {
+        writeNumber(MEDIA_RULESET);
+        writeTokens(query->getMediaSelector());
+      } else {
+        writeNumber(RULESET);
+        writeLessSelector((*r_it)->getLessSelector());
+      }
+      writeRuleset(**r_it);
+    }
+
+    writeExtensions(ruleset.getExtensions());
+    writeVariables(((LessRuleset &)ruleset).getVariables());
+  }
+
+  void writeStylesheet(const LessStylesheet &stylesheet) {
+    std::list<StylesheetStatement *>::const_iterator it;
+    const CssComment *comment;
+    const LessRuleset *ruleset;
+    const ReferenceRuleset *skipped;
+    const Mixin *mixin;
+    const LessAtRule *atrule;
+    const LessMediaQuery *query;
+
+    writeNumber(stylesheet.getStatements().size());
+    for (it = stylesheet.getStatements().begin();
+         it != stylesheet.getStatements().end();
+         it++) {
+      if ((comment = dynamic_cast<const CssComment *>(*it)) != NULL) {
+        writeNumber(COMMENT);
+        writeToken(comment->getComment());
+        writeNumber(comment->isReference());
+
+      } else if ((ruleset = dynamic_cast<const LessRuleset *>(*it)) != NULL) {
+        skipped = dynamic_cast<const ReferenceRuleset *>(ruleset);
+        if (skipped != NULL && skipped->isLoaded())
+          skipped = NULL;
+
+        if (skipped != NULL && skipped->getSourceId() == sourceId) {
+          // The block is parsed from the file the entry is loaded for.
+          writeNumber(REFERENCE_RULESET);
+          writeLessSelector(skipped->getLessSelector());
+          writeNumber(skipped->getBegin());
+          writeNumber(skipped->getEnd());
+
+        } else if (skipped != NULL && files == NULL) {
+          cacheable = false;
+
+        } else {
+          // Snapshots do not keep the content of their files.
+          if (skipped != NULL)
+            skipped->load();
+
+          writeNumber(RULESET);
+          writeLessSelector(ruleset->getLessSelector());
+          writeRuleset(*ruleset);
+        }
+
+      } else if ((mixin = dynamic_cast<const Mixin *>(*it)) != NULL) {
+        writeNumber(MIXIN);
+        writeMixin(*mixin);
+
+      } else if ((atrule = dynamic_cast<const LessAtRule *>(*it)) != NULL) {
+        writeNumber(ATRULE);
+        writeAtRule(*atrule);
+
+      } else if ((query = dynamic_cast<const LessMediaQuery *>(*it)) !=
+                 NULL) {
+        writeNumber(MEDIA);
+        writeTokens(query->getSelector());
+        writeNumber(query->isReference());
+        writeStylesheet(*query);
+
+      } else
+        cacheable = false;
+    }
+    writeVariables(stylesheet.getVariables());
+  }
+
+  void writeFile(const ImportedFile &file) {
+    std::vector<LessStylesheet *>::const_iterator s_it;
+    std::vector<ImportedFile::Import>::const_iterator i_it;
+    std::vector<ImportedFile::Warning>::const_iterator w_it;
+
+    writeNumber(file.segments.size());
+    for (s_it = file.segments.begin(); s_it != file.segments.end(); s_it++)
+      writeStylesheet(**s_it);
+
+    writeNumber(file.imports.size());
+    for (i_it = file.imports.begin(); i_it != file.imports.end(); i_it++) {
+      writeToken(i_it->uri);
+      writeNumber(i_it->directive);
+    }
+
+    writeNumber(file.warnings.size());
+    for (w_it = file.warnings.begin(); w_it != file.warnings.end(); w_it++) {
+      writeNumber(w_it->segment);
+      writeToken(w_it->token);
+    }
+  }
+
+  /**
+   * The string table, to be written in front of the body.
+   */
+  std::string getTable() {
+    std::vector<const std::string *>::iterator it;
+    std::string ret;
+
+    ret.swap(body);
+    writeNumber(strings.size());
+    for (it = strings.begin(); it != strings.end(); it++) {
+      writeNumber((*it)->size());
+      body.append(**it);
+    }
+    ret.swap(body);
+    return ret;
+  }
+
+private:
+  unsigned int sourceId;
+  const SourceSet *files;
+  std::unordered_map<std::string, size_t> indices;
+  std::vector<const std::string *> strings;
+};
+
+/**
+ * Reads what a Writer wrote, creating the statements with the same
+ * calls the parser makes. Throws an IOException if the data ends early
+ * or holds a value the writer could not have written.
+ */
+class Reader {
+public:
+  /**
+   * Tokens that were stored with the index of their file get the
+   * source id at that index in files.
+   */
+  Reader(const char *data,
+         const char *end,
+         unsigned int sourceId,
+         const std::vector<unsigned int> *files = NULL)
+      : p(data), end(end), sourceId(sourceId), files(files) {
+  }
+
+  bool atEnd() const {
+    return p == end;
+  }
+
+  unsigned long long readNumber() {
+    unsigned long long n = 0;
+    unsigned int shift = 0;
+
+    do {
+      if (p == end || shift > 63)
+        throw new IOException("Truncated cache entry.");
+      n |= (unsigned long long)(*p & 0x7F) << shift;
+      shift += 7;
+    } while (*p++ & 0x80);
+    return n;
+  }
+
+  size_t readCount() {
+    unsigned long long n = readNumber();
+
+    // Every item takes at least one byte.
+    if (n > (unsigned long long)(end - p))
+      throw new IOException("Corrupt cache entry.");
+    return n;
+  }
+
+  void readTable() {
+    size_t n = readCount(), length;
+
+    strings.reserve(n);
+    sources.resize(n, 0);
+    resolved.resize(n, false);
+    while (n-- > 0) {
+      length = readCount();
+      strings.push_back(std::string(p, length));
+      p += length;
+    }
+  }
+
+  const std::string &readString() {
+    unsigned long long i = readNumber();
+
+    if (i >= strings.size())
+      throw new IOException("Corrupt cache entry.");
+    return strings[i];
+  }
+
+  void readToken(Token &t) {
+    unsigned long long type = readNumber(), i;
+    unsigned int source = sourceId;
+
+    if (type > Token::EOS)
+      throw new IOException("Corrupt cache entry.");
+    t.assign(readString());
+    t.type = (Token::Type)type;
+
+    switch (readNumber()) {
+      case 0:
+        break;
+      case 1:
+        i = readNumber();
+        if (i >= strings.size())
+          throw new IOException("Corrupt cache entry.");
+        if (!resolved[i]) {
+          sources[i] = SourceRegistry::getId(strings[i].c_str());
+          resolved[i] = true;
+        }
+        source = sources[i];
+        break;
+      case 2:
+        i = readNumber();
+        if (files == NULL || i >= files->size())
+          throw new IOException("Corrupt cache entry.");
+        source = (*files)[i];
+        break;
+      default:
+        throw new IOException("Corrupt cache entry.");
+    }
+    t.sourceId = source;
+    t.offset = readNumber();
+  }
+
+  void readTokens(TokenList &tokens) {
+    size_t n = readCount();
+    Token t;
+
+    tokens.reserve(n);
+    while (n-- > 0) {
+      readToken(t);
+      tokens.push_back(t);
+    }
+  }
+
+  void readSelector(Selector &selector) {
+    size_t n = readCount();
+
+    selector.reserve(n);
+    while (n-- > 0) {
+      selector.push_back(TokenList());
+      readTokens(selector.back());
+    }
+  }
+
+  void readExtension(Extension &extension) {
+    readSelector(extension.getTarget());
+    readSelector(extension.getExtension());
+    extension.setAll(readNumber() != 0);
+  }
+
+  void readLessSelector(LessSelector &selector) {
+    size_t n;
+    bool unlimited;
+
+    readSelector(selector);
+
+    n = readCount();
+    while (n-- > 0) {
+      Extension extension;
+      readExtension(extension);
+      selector.addExtension(extension);
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      Token keyword;
+      TokenList value;
+
+      keyword.assign(readString());
+      readTokens(value);
+      selector.addParameter(keyword, value);
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      TokenList condition;
+      readTokens(condition);
+      selector.addCondition(condition);
+    }
+
+    unlimited = readNumber() != 0;
+    selector.setNeedsArguments(readNumber() != 0);
+
+    Token rest;
+    rest.assign(readString());
+    selector.setUnlimitedArguments(unlimited, rest);
+  }
+
+  void readVariables(VariableMap &variables) {
+    size_t n = readCount();
+
+    while (n-- > 0) {
+      const std::string &key = readString();
+      readTokens(variables[key]);
+    }
+  }
+
+  void readMixin(Mixin &mixin) {
+    size_t n = readCount();
+
+    while (n-- > 0) {
+      TokenList argument;
+      readTokens(argument);
+      mixin.arguments.add(argument);
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      std::string name = readString();
+      TokenList argument;
+
+      readTokens(argument);
+      mixin.arguments.add(name, argument);
+    }
+    mixin.setImportant(readNumber() != 0);
+    mixin.setReference(readNumber() != 0);
+  }
+
+  void readAtRule(AtRule &atrule) {
+    TokenList rule;
+
+    readTokens(rule);
+    atrule.setRule(rule);
+    atrule.setReference(readNumber() != 0);
+  }
+
+  void readRuleset(LessRuleset &ruleset) {
+    size_t n;
+    Token t;
+
+    ruleset.setReference(readNumber() != 0);
+
+    n = readCount();
+    while (n-- > 0) {
+      switch (readNumber()) {
+        case COMMENT: {
+          CssComment *comment = ruleset.createComment();
+
+          readToken(t);
+          comment->setComment(t);
+          comment->setReference(readNumber() != 0);
+          break;
+        }
+        case DECLARATION: {
+          LessDeclaration *declaration = ruleset.createLessDeclaration();
+
+          readToken(t);
+          declaration->setProperty(t);
+          readTokens(declaration->getValue());
+          break;
+        }
+        case MIXIN: {
+          TokenList name;
+
+          readTokens(name);
+          readMixin(*ruleset.createMixin(name));
+          break;
+        }
+        case ATRULE:
+          readToken(t);
+          readAtRule(*ruleset.createLessAtRule(t));
+          break;
+        default:
+          throw new IOException("Corrupt cache entry.");
+      }
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      switch (readNumber()) {
+        case RULESET: {
+          LessSelector *selector = new LessSelector();
+
+          readLessSelector(*selector);
+          readRuleset(*ruleset.createNestedRule(*selector));
+          break;
+        }
+        case MEDIA_RULESET: {
+          TokenList selector;
+
+          readTokens(selector);
+          readRuleset(*ruleset.createMediaQuery(selector));
+          break;
+        }
+        default:
+          throw new IOException("Corrupt cache entry.");
+      }
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      Extension extension;
+      readExtension(extension);
+      ruleset.addExtension(extension);
+    }
+    readVariables(ruleset.getVariables());
+  }
+
+  void readStylesheet(LessStylesheet &stylesheet) {
+    size_t n = readCount();
+    VariableMap variables;
+    VariableMap::iterator it;
+    Token t;
+
+    while (n-- > 0) {
+      switch (readNumber()) {
+        case COMMENT: {
+          CssComment *comment = stylesheet.createComment();
+
+          readToken(t);
+          comment->setComment(t);
+          comment->setReference(readNumber() != 0);
+          break;
+        }
+        case RULESET: {
+          LessSelector *selector = new LessSelector();
+
+          readLessSelector(*selector);
+          readRuleset(*stylesheet.createLessRuleset(*selector));
+          break;
+        }
+        case REFERENCE_RULESET: {
+          LessSelector *selector = new LessSelector();
+          const SourceBuffer *content = SourceRegistry::getContent(sourceId);
+          unsigned long long begin, end;
+          ReferenceRuleset *ruleset;
+
+          readLessSelector(*selector);
+          begin = readNumber();
+          end = readNumber();
+          if (files != NULL || content == NULL || begin > end ||
+              end >= content->getSize()) {
+            delete selector;
+            throw new IOException("Corrupt cache entry.");
+          }
+          ruleset = new ReferenceRuleset(
+              *selector, stylesheet, sourceId, begin, end);
+          stylesheet.addLessRuleset(*ruleset);
+          break;
+        }
+        case MIXIN: {
+          TokenList name;
+
+          readTokens(name);
+          readMixin(*stylesheet.createMixin(name));
+          break;
+        }
+        case ATRULE:
+          readToken(t);
+          readAtRule(*stylesheet.createLessAtRule(t));
+          break;
+        case MEDIA: {
+          TokenList selector;
+          LessMediaQuery *query;
+
+          readTokens(selector);
+          query = stylesheet.createLessMediaQuery(selector);
+          query->setReference(readNumber() != 0);
+          readStylesheet(*query);
+          break;
+        }
+        default:
+          throw new IOException("Corrupt cache entry.");
+      }
+    }
+
+    readVariables(variables);
+    for (it = variables.begin(); it != variables.end(); it++)
+      stylesheet.putVariable(VariableMap::getName(it), it->second);
+  }
+
+  void readFile(ImportedFile &file) {
+    size_t n = readCount();
+
+    while (n-- > 0) {
+      file.segments.push_back(new LessStylesheet());
+      readStylesheet(*file.segments.back());
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      ImportedFile::Import i;
+
+      readToken(i.uri);
+      i.directive = readNumber();
+      file.imports.push_back(i);
+    }
+
+    n = readCount();
+    while (n-- > 0) {
+      ImportedFile::Warning w;
+
+      w.segment = readNumber();
+      if (w.segment >= file.segments.size() ||
+          (!file.warnings.empty() && w.segment < file.warnings.back().segment))
+        throw new IOException("Corrupt cache entry.");
+      readToken(w.token);
+      file.warnings.push_back(w);
+    }
+
+    if (p != end || file.segments.size() != file.imports.size() + 1)
+      throw new IOException("Corrupt cache entry.");
+  }
+
+private:
+  const char *p, *end;
+  unsigned int sourceId;
+  const std::vector<unsigned int> *files;
+  std::vector<std::string> strings;
+
+  /**
+   * Source id of each string that is used as the name of a source.
+   */
+  std::vector<unsigned int> sources;
+  std::vector<bool> resolved;
+};
+
+}  // namespace
+
+StylesheetCache::StylesheetCache(const std::string &directory)
+    : directory(directory) {
+  mkdir(directory.c_str(), 0777);
+}
+
+StylesheetCache::~StylesheetCache() {
+}
+
+bool StylesheetCache::load(const SourceBuffer &content,
+                           bool reference,
+                           ImportedFile &file) {
+  unsigned long long h = hash(content);
+  std::string entry = getEntry(h, reference);
+  int fd;
+  struct stat st;
+  void *map;
+  const char *data;
+  bool ret = false;
+
+  if ((fd = open(entry.c_str(), O_RDONLY)) < 0)
+    return false;
+
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MAGIC) ||
+      (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) ==
+          MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  close(fd);
+  data = (const char *)map;
+
+  Reader reader(data + sizeof(MAGIC), data + st.st_size, file.sourceId);
+
+  try {
+    if (std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0 &&
+        reader.readNumber() == FORMAT_VERSION &&
+        reader.readNumber() == content.getSize() &&
+        reader.readNumber() == h &&
+        reader.readNumber() == (unsigned long long)reference) {
+      reader.readTable();
+      reader.readFile(file);
+      ret = true;
+    }
+  } catch (IOException *e) {
+    delete e;
+  }
+
+  if (!ret) {
+    while (!file.segments.empty()) {
+      delete file.segments.back();
+      file.segments.pop_back();
+    }
+    file.imports.clear();
+    file.warnings.clear();
+  }
+  munmap(map, st.st_size);
+  return ret;
+}
+
+void StylesheetCache::store(const SourceBuffer &content,
+                            bool reference,
+                            const ImportedFile &file) {
+  unsigned long long h;
+  std::string entry, tmp, table;
+  std::ostringstream suffix;
+  Writer writer(file.sourceId);
+
+  if (file.error || file.serial || !file.readable)
+    return;
+  h = hash(content);
+
+  writer.writeFile(file);
+  if (!writer.cacheable)
+    return;
+  table = writer.getTable();
+
+  std::string body;
+  body.swap(writer.body);
+  writer.body.append(MAGIC, sizeof(MAGIC));
+  writer.writeNumber(FORMAT_VERSION);
+  writer.writeNumber(content.getSize());
+  writer.writeNumber(h);
+  writer.writeNumber(reference);
+
+  // Write to a file of our own and rename it, so that compilations
+  // running at the same time never see a partial entry.
+  entry = getEntry(h, reference);
+  suffix << ".tmp" << getpid() << '-'
+         << std::hash<std::thread::id>()(std::this_thread::get_id());
+  tmp = entry + suffix.str();
+
+  std::ofstream out(tmp.c_str(), std::ios::binary);
+  out << writer.body << table << body;
+  out.close();
+
+  if (!out.good() || std::rename(tmp.c_str(), entry.c_str()) != 0)
+    std::remove(tmp.c_str());
+}
+
+bool StylesheetCache::writeSnapshot(const std::string &filename,
+                                    const LessStylesheet &stylesheet,
+                                    const SourceSet &sources) {
+  Writer writer(SourceRegistry::BUILTIN, &sources);
+  std::string statements, files, table;
+  std::vector<unsigned int> lines;
+  std::vector<unsigned int>::iterator it;
+  unsigned int id, previous;
+  struct stat st;
+  size_t i;
+
+  writer.writeStylesheet(stylesheet);
+  if (!writer.cacheable)
+    return false;
+  statements.swap(writer.body);
+
+  // The files the statements were read from, with what it takes to
+  // check that they did not change and to locate tokens in them.
+  writer.writeNumber(sources.size());
+  for (i = 0; i < sources.size(); i++) {
+    id = sources.getSourceId(i);
+    writer.writeString(sources.getName(i));
+    writer.writeString(SourceRegistry::getPath(id));
+
+    if (stat(SourceRegistry::getPath(id).c_str(), &st) == 0) {
+      writer.writeNumber(1);
+      writer.writeNumber(st.st_size);
+      writer.writeNumber(st.st_mtime);
+    } else
+      writer.writeNumber(0);
+
+    SourceRegistry::getLines(id, lines);
+    writer.writeNumber(lines.size());
+    for (it = lines.begin(), previous = 0; it != lines.end(); it++) {
+      writer.writeNumber(*it - previous);
+      previous = *it;
+    }
+  }
+  files.swap(writer.body);
+  table = writer.getTable();
+
+  writer.body.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  writer.writeNumber(FORMAT_VERSION);
+
+  std::ofstream out(filename.c_str(), std::ios::binary);
+  out << writer.body << table << files << statements;
+  out.close();
+  return out.good();
+}
+
+void StylesheetCache::readSnapshot(const std::string &filename,
+                                   LessStylesheet &stylesheet,
+                                   SourceSet &sources) {
+  int fd;
+  struct stat st;
+  void *map;
+  const char *data;
+  std::vector<unsigned int> files, lines;
+  LessStylesheet snapshot;
+  size_t mapped, n, count;
+  unsigned int previous;
+  char *name;
+  std::string source, path;
+  unsigned long long size, mtime;
+
+  if ((fd = open(filename.c_str(), O_RDONLY)) < 0)
+    throw new IOException("Could not open snapshot.");
+
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SNAPSHOT_MAGIC) ||
+      (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) ==
+          MAP_FAILED) {
+    close(fd);
+    throw new IOException("Could not read snapshot.");
+  }
+  close(fd);
+  data = (const char *)map;
+  mapped = st.st_size;
+
+  Reader reader(data + sizeof(SNAPSHOT_MAGIC),
+                data + mapped,
+                SourceRegistry::BUILTIN,
+                &files);
+
+  try {
+    if (std::memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        reader.readNumber() != FORMAT_VERSION) {
+      throw new IOException("Snapshot was made by another version.");
+    }
+    reader.readTable();
+
+    n = reader.readCount();
+    while (n-- > 0) {
+      source = reader.readString();
+      path = reader.readString();
+
+      if (reader.readNumber() != 0) {
+        size = reader.readNumber();
+        mtime = reader.readNumber();
+        if (stat(path.c_str(), &st) != 0 ||
+            (unsigned long long)st.st_size != size ||
+            (unsigned long long)st.st_mtime != mtime) {
+          throw new IOException(
+              "A file changed after the snapshot was made. Emit it again.");
+        }
+      }
+
+      count = reader.readCount();
+      lines.clear();
+      lines.reserve(count);
+      for (previous = 0; count > 0; count--) {
+        previous += reader.readNumber();
+        lines.push_back(previous);
+      }
+
+      name = new char[source.size() + 1];
+      std::strcpy(name, source.c_str());
+      files.push_back(SourceRegistry::add(name, path, lines));
+      sources.add(files.back());
+    }
+
+    reader.readStylesheet(snapshot);
+    if (!reader.atEnd())
+      throw new IOException("Corrupt cache entry.");
+  } catch (IOException *) {
+    munmap(map, mapped);
+    throw;
+  }
+  munmap(map, mapped);
+  stylesheet.merge(snapshot);
+}
+
+std::string StylesheetCache::getEntry(unsigned long long hash,
+                                      bool reference) const {
+  char name[32];
+
+  std::snprintf(name, sizeof(name), "/%016llx%s.ast", hash,
+                reference ? "-r" : "");
+  return directory + name;
+}
+
+unsigned long long StylesheetCache::hash(const SourceBuffer &content) {
+  // 64-bit FNV-1a.
+  unsigned long long h = 14695981039346656037ULL;
+  const unsigned char *p = (const unsigned char *)content.getData();
+  const unsigned char *end = p + content.getSize();
+
+  for (; p != end; p++) {
+    h ^= *p;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
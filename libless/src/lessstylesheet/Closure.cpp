@@ -25,9 +25,9 @@ void Closure::getFunctions(std::list<const Function*>& functionList,
                            const Mixin& mixin,
                            TokenList::const_iterator offset,
                            const ProcessingContext &context) const {
-  const std::list<LessRuleset*>& nestedRules = ruleset->getNestedRules();
   const std::list<Closure*> *closures = context.getClosures(ruleset);
-  std::list<LessRuleset*>::const_iterator r_it;
+  std::vector<LessRuleset*> rules;
+  std::vector<LessRuleset*>::const_iterator r_it;
   std::list<Closure*>::const_iterator c_it;
   TokenList::const_iterator offset2;
 
@@ -45,7 +45,8 @@ void Closure::getFunctions(std::list<const Function*>& functionList,
     if (offset2 == mixin.name.end()) {
       functionList.push_back(this);
     } else {
-      for (r_it = nestedRules.begin(); r_it != nestedRules.end(); r_it++) {
+      ruleset->findNestedRules(offset2, mixin.name.end(), rules);
+      for (r_it = rules.begin(); r_it != rules.end(); r_it++) {
         (*r_it)->getFunctions(functionList, mixin, offset2, context);
       }
       if (closures != NULL) {
@@ -61,13 +62,13 @@ const LessSelector &Closure::getLessSelector() const {
   return ruleset->getLessSelector();
 }
 
-const TokenList* Closure::getVariable(const std::string& key,
+const TokenList* Closure::getVariable(unsigned int atom,
                                       const ProcessingContext &context) const {
   const TokenList* t;
 
-  if ((t = ruleset->getVariable(key, context)) != NULL)
+  if ((t = ruleset->getVariable(atom, context)) != NULL)
     return t;
-  return this->stack->getVariable(key, context);  
+  return this->stack->getVariable(atom, context);  
 }
 
 void Closure::getLocalFunctions(std::list<const Function*>& functionList,
@@ -44,18 +44,20 @@ void Extension::updateSelector(Selector &s) const {
   }
 }
 void Extension::replaceInSelector(Selector &s) const {
-  std::list<TokenList>::const_iterator it1, it2;
+  Selector::const_iterator it;
 
-  for (it1 = target.begin();
-       it1 != target.end(); it1++) {
+  for (it = target.begin(); it != target.end(); it++)
+    replaceInSelector(s, TokenMatcher(*it));
+}
 
-    for (it2 = extension.begin();
-         it2 != extension.end(); it2++) {
+void Extension::replaceInSelector(Selector &s,
+                                  const TokenMatcher &target) const {
+  Selector::const_iterator it;
 
-      // If no matches are found, there is no need to try other extension
-      // selectors.
-      if (! s.replace(*it1, *it2))
-        break;
-    }
+  for (it = extension.begin(); it != extension.end(); it++) {
+    // If no matches are found, there is no need to try other extension
+    // selectors.
+    if (! s.replace(target, *it))
+      break;
   }
 }
@@ -0,0 +1,136 @@
+#include "less/lessstylesheet/ExtensionMatcher.h"
+
+ExtensionMatcher::ExtensionMatcher(const std::list<Extension>& extensions) {
+  std::list<Extension>::const_iterator e_it;
+  Selector::const_iterator t_it;
+  const Token* key;
+  size_t index, hash;
+  bool indexed;
+
+  entries.reserve(extensions.size());
+
+  for (e_it = extensions.begin(); e_it != extensions.end(); e_it++) {
+    index = entries.size();
+    entries.push_back(Entry());
+    entries.back().extension = &(*e_it);
+    indexed = true;
+
+    for (t_it = (*e_it).getTarget().begin();
+         t_it != (*e_it).getTarget().end();
+         t_it++) {
+      if ((*e_it).isAll()) {
+        entries.back().targets.push_back(TokenMatcher(*t_it));
+
+        if ((key = keyToken(*t_it)) != NULL)
+          tokenIndex[key->hash()].push_back(index);
+        else
+          indexed = false;
+
+      } else if (matchHash(*t_it, hash))
+        selectorIndex[hash].push_back(index);
+      else
+        indexed = false;
+    }
+
+    if (!indexed)
+      unindexed.push_back(index);
+  }
+}
+
+const Token* ExtensionMatcher::keyToken(const TokenList& target) {
+  TokenList::const_iterator it;
+  const Token* key = NULL;
+
+  // Class names and ids are more selective than the delimiters between
+  // them.
+  for (it = target.begin(); it != target.end(); it++) {
+    if ((*it).type == Token::IDENTIFIER || (*it).type == Token::HASH)
+      return &(*it);
+    if (key == NULL && (*it).type != Token::WHITESPACE)
+      key = &(*it);
+  }
+  return key;
+}
+
+bool ExtensionMatcher::matchHash(const TokenList& selector, size_t& hash) {
+  TokenList::const_iterator it;
+  bool empty = true;
+
+  hash = 0;
+  for (it = selector.begin(); it != selector.end(); it++) {
+    if ((*it).type == Token::WHITESPACE || *it == ">")
+      continue;
+    hash = hash * 1000003 ^ (*it).hash();
+    empty = false;
+  }
+  return !empty;
+}
+
+void ExtensionMatcher::findCandidates(const Selector& s,
+                                      size_t first,
+                                      size_t from,
+                                      std::set<size_t>& candidates) const {
+  std::unordered_map<size_t, std::vector<size_t> >::const_iterator i_it;
+  std::vector<size_t>::const_iterator it;
+  TokenList::const_iterator t_it;
+  size_t i, hash;
+
+  for (i = first; i < s.size(); i++) {
+    const TokenList& selector = s[i];
+
+    if (!tokenIndex.empty()) {
+      for (t_it = selector.begin(); t_it != selector.end(); t_it++) {
+        if ((*t_it).type == Token::WHITESPACE ||
+            (i_it = tokenIndex.find((*t_it).hash())) == tokenIndex.end())
+          continue;
+
+        for (it = i_it->second.begin(); it != i_it->second.end(); it++) {
+          if (*it >= from)
+            candidates.insert(*it);
+        }
+      }
+    }
+
+    if (!selectorIndex.empty() && matchHash(selector, hash) &&
+        (i_it = selectorIndex.find(hash)) != selectorIndex.end()) {
+      for (it = i_it->second.begin(); it != i_it->second.end(); it++) {
+        if (*it >= from)
+          candidates.insert(*it);
+      }
+    }
+  }
+}
+
+void ExtensionMatcher::apply(const Entry& entry, Selector& s) const {
+  std::vector<TokenMatcher>::const_iterator it;
+
+  if (entry.extension->isAll()) {
+    for (it = entry.targets.begin(); it != entry.targets.end(); it++)
+      entry.extension->replaceInSelector(s, *it);
+  } else
+    entry.extension->updateSelector(s);
+}
+
+void ExtensionMatcher::updateSelector(Selector& s) const {
+  std::set<size_t> candidates(unindexed.begin(), unindexed.end());
+  size_t scanned = s.size(), i;
+
+  if (entries.empty())
+    return;
+
+  findCandidates(s, 0, 0, candidates);
+
+  // Extensions can add selectors that match later extensions, so the
+  // added selectors are scanned too. Earlier extensions have already
+  // been applied and are not tried again, as before.
+  while (!candidates.empty()) {
+    i = *candidates.begin();
+    candidates.erase(candidates.begin());
+    apply(entries[i], s);
+
+    if (s.size() > scanned) {
+      findCandidates(s, scanned, i + 1, candidates);
+      scanned = s.size();
+    }
+  }
+}
@@ -1,6 +1,9 @@
 #include "less/lessstylesheet/LessDeclaration.h"
 #include "less/lessstylesheet/LessRuleset.h"
 
+LessDeclaration::LessDeclaration() : lessRuleset(NULL), folded(false) {
+}
+
 void LessDeclaration::setLessRuleset(LessRuleset &r) {
   lessRuleset = &r;
 }
@@ -8,6 +11,14 @@ LessRuleset *LessDeclaration::getLessRuleset() {
   return lessRuleset;
 }
 
+void LessDeclaration::setFolded(const TokenList &value) {
+  setValue(value);
+  folded = true;
+}
+bool LessDeclaration::isFolded() const {
+  return folded;
+}
+
 
 void LessDeclaration::process(Ruleset &r, void* context) const {
   Declaration *d = r.createDeclaration();
@@ -15,7 +26,8 @@ void LessDeclaration::process(Ruleset &r, void* context) const {
   d->setValue(value);
 
   ((ProcessingContext*)context)->interpolate(d->getProperty());
-  ((ProcessingContext*)context)->processValue(d->getValue());
+  if (!folded)
+    ((ProcessingContext*)context)->processValue(d->getValue());
 
   // If the `important` flag is set, append '!important'
   if(((ProcessingContext*)context)->isImportant()) {
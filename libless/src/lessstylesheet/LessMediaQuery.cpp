@@ -16,6 +16,11 @@ const TokenList &LessMediaQuery::getSelector() const {
   return selector;
 }
 
+void LessMediaQuery::setStylesheet(Stylesheet *s) {
+  StylesheetStatement::setStylesheet(s);
+  parent = (const LessStylesheet *)s;
+}
+
 const LessStylesheet &LessMediaQuery::getLessStylesheet() const {
   return *parent;
 }
@@ -27,11 +32,11 @@ void LessMediaQuery::getFunctions(std::list<const Function *> &functionList,
   getLessStylesheet().getFunctions(functionList, mixin, context);
 }
 
-const TokenList *LessMediaQuery::getVariable(const std::string &key,
+const TokenList *LessMediaQuery::getVariable(unsigned int atom,
                                              const ProcessingContext &context) const {
-  const TokenList *t = LessStylesheet::getVariable(key, context);
+  const TokenList *t = LessStylesheet::getVariable(atom, context);
   if (t == NULL)
-    t = getLessStylesheet().getVariable(key, context);
+    t = getLessStylesheet().getVariable(atom, context);
   return t;
 }
 
@@ -5,12 +5,14 @@
 LessRuleset::LessRuleset(LessSelector& selector,
                          const LessRuleset& parent) :
   Ruleset(selector),
+  nestedIndexed(false),
   parent(&parent), lessStylesheet(NULL), selector(&selector) {
 
 }
 LessRuleset::LessRuleset(LessSelector& selector,
                          const LessStylesheet& parent) :
   Ruleset(selector),
+  nestedIndexed(false),
   parent(NULL), lessStylesheet(&parent), selector(&selector) {
 }
 
@@ -28,6 +30,9 @@ const LessSelector& LessRuleset::getLessSelector() const {
 void LessRuleset::addExtension(Extension &extension) {
   extensions.push_back(extension);
 }
+const std::list<Extension>& LessRuleset::getExtensions() const {
+  return extensions;
+}
 
 LessDeclaration* LessRuleset::createLessDeclaration() {
   LessDeclaration* d = new LessDeclaration();
@@ -80,6 +85,7 @@ LessRuleset* LessRuleset::createNestedRule(LessSelector& selector) {
   LessRuleset* r = new LessRuleset(selector, *this);
 
   nestedRules.push_back(r);
+  nestedIndexed = false;
   return r;
 }
 
@@ -87,11 +93,13 @@ MediaQueryRuleset* LessRuleset::createMediaQuery(TokenList &selector) {
   MediaQueryRuleset* r = new MediaQueryRuleset(selector, *this);
 
   nestedRules.push_back(r);
+  nestedIndexed = false;
   return r;
 }
 
 void LessRuleset::deleteNestedRule(LessRuleset& ruleset) {
   nestedRules.remove(&ruleset);
+  nestedIndexed = false;
   delete &ruleset;
 }
 
@@ -99,6 +107,21 @@ const std::list<LessRuleset*>& LessRuleset::getNestedRules() const {
   return nestedRules;
 }
 
+void LessRuleset::findNestedRules(TokenList::const_iterator offset,
+                                  const TokenList::const_iterator &end,
+                                  std::vector<LessRuleset*> &rules) const {
+  std::list<LessRuleset*>::const_iterator r_it;
+
+  if (!nestedIndexed) {
+    nestedIndex.clear();
+    for (r_it = nestedRules.begin(); r_it != nestedRules.end(); r_it++) {
+      nestedIndex.add(**r_it);
+    }
+    nestedIndexed = true;
+  }
+  nestedIndex.find(offset, end, rules);
+}
+
 void LessRuleset::putVariable(const std::string& key, const TokenList& value) {
   variables[key] = value;
 }
@@ -118,6 +141,15 @@ const LessRuleset* LessRuleset::getParent() const {
   return parent;
 }
 
+void LessRuleset::setStylesheet(Stylesheet* s) {
+  Ruleset::setStylesheet(s);
+
+  // Rulesets are only ever added to a LessStylesheet, which can change
+  // when stylesheets are merged.
+  if (lessStylesheet != NULL)
+    lessStylesheet = (const LessStylesheet*)s;
+}
+
 void LessRuleset::setLessStylesheet(const LessStylesheet& s) {
   lessStylesheet = &s;
 }
@@ -264,33 +296,34 @@ void LessRuleset::processStatements(Stylesheet& target,
   insertNestedRules(target, NULL, *(ProcessingContext*)context);
 }
 
-const TokenList* LessRuleset::getVariable(const std::string& key,
+const TokenList* LessRuleset::getVariable(unsigned int atom,
                                           const ProcessingContext &context) const {
   const TokenList* t;
   const VariableMap* m;
 
-  if ((t = getVariable(key)) != NULL)
+  if ((t = variables.getVariable(atom)) != NULL)
     return t;
 
   if ((m = context.getStackArguments(this)) != NULL) {
-    if ((t = m->getVariable(key)) != NULL)
+    if ((t = m->getVariable(atom)) != NULL)
       return t;
   }
   
-  if ((t = context.getFunctionVariable(key, this)) != NULL)
+  if ((t = context.getFunctionVariable(atom, this)) != NULL)
     return t;
 
   if (parent != NULL)
-    return parent->getVariable(key, context);
+    return parent->getVariable(atom, context);
   else
-    return getLessStylesheet()->getVariable(key, context);
+    return getLessStylesheet()->getVariable(atom, context);
 }
 
 void LessRuleset::getFunctions(list<const Function*>& functionList,
                                const Mixin& mixin,
                                TokenList::const_iterator offset,
                                const ProcessingContext &context) const {
-  std::list<LessRuleset*>::const_iterator r_it;
+  std::vector<LessRuleset*> rules;
+  std::vector<LessRuleset*>::const_iterator r_it;
   const std::list<Closure*>* closures;
   std::list<Closure*>::const_iterator c_it;
   TokenList::const_iterator offset2;
@@ -312,7 +345,8 @@ void LessRuleset::getFunctions(list<const Function*>& functionList,
   } else {
     if (!selector->needsArguments() && matchConditions(context)) {
       
-      for (r_it = nestedRules.begin(); r_it != nestedRules.end(); r_it++) {
+      findNestedRules(offset2, mixin.name.end(), rules);
+      for (r_it = rules.begin(); r_it != rules.end(); r_it++) {
         (*r_it)->getFunctions(functionList, mixin, offset2, context);
       }
       closures = context.getClosures(this);
@@ -335,11 +369,13 @@ void LessRuleset::getLocalFunctions(std::list<const Function*>& functionList,
                                     const Mixin& mixin,
                                     const LessRuleset* exclude,
                                     const ProcessingContext &context) const {
-  std::list<LessRuleset*>::const_iterator r_it;
+  std::vector<LessRuleset*> rules;
+  std::vector<LessRuleset*>::const_iterator r_it;
   const std::list<Closure*>* closures;
   std::list<Closure*>::const_iterator c_it;
 
-  for (r_it = nestedRules.begin(); r_it != nestedRules.end(); r_it++) {
+  findNestedRules(mixin.name.begin(), mixin.name.end(), rules);
+  for (r_it = rules.begin(); r_it != rules.end(); r_it++) {
     if ((*r_it) != exclude) {
       (*r_it)->getFunctions(functionList, mixin, mixin.name.begin(), context);
     }
@@ -422,7 +458,7 @@ bool LessRuleset::putArguments(MixinArguments& args, VariableMap& scope) const {
     if (variable == NULL || variable->empty())
       return false;
 
-    scope.insert(pair<std::string, TokenList>(*pit, *variable));
+    scope.insert(*pit, *variable);
 
     argsCombined.insert(argsCombined.end(), variable->begin(), variable->end());
     argsCombined.push_back(Token::BUILTIN_SPACE);
@@ -438,11 +474,10 @@ bool LessRuleset::putArguments(MixinArguments& args, VariableMap& scope) const {
     }
 
     restVar.trim();
-    scope.insert(
-        pair<std::string, TokenList>(selector->getRestIdentifier(), restVar));
+    scope.insert(selector->getRestIdentifier(), restVar);
   }
 
-  scope.insert(pair<std::string, TokenList>("@arguments", argsCombined));
+  scope.insert("@arguments", argsCombined);
   return true;
 }
 
@@ -23,6 +23,10 @@ const std::list<std::string> &LessSelector::getParameters() const {
   return parameters;
 }
 
+const std::list<TokenList> &LessSelector::getDefaults() const {
+  return defaults;
+}
+
 const std::list<TokenList> &LessSelector::getConditions() const {
   return conditions;
 }
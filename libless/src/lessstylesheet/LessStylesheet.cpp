@@ -1,4 +1,5 @@
 #include "less/lessstylesheet/LessStylesheet.h"
+#include "less/lessstylesheet/ExtensionMatcher.h"
 #include "less/lessstylesheet/LessMediaQuery.h"
 
 LessStylesheet::LessStylesheet() {
@@ -8,16 +9,17 @@ LessStylesheet::~LessStylesheet() {
 }
 
 LessRuleset* LessStylesheet::createLessRuleset(LessSelector &selector) {
-  std::list<TokenList>::iterator it;
   LessRuleset* r = new LessRuleset(selector, *this);
 
-  addRuleset(*r);
-  for(it = selector.begin(); it != selector.end(); it++) {
-    lessrulesets.insert(std::pair<TokenList, LessRuleset*>((*it), r));
-  }
+  addLessRuleset(*r);
   return r;
 }
 
+void LessStylesheet::addLessRuleset(LessRuleset &ruleset) {
+  addRuleset(ruleset);
+  lessrulesets.add(ruleset);
+}
+
 Mixin* LessStylesheet::createMixin(const TokenList &selector) {
   Mixin* m = new Mixin(selector, *this);
 
@@ -39,13 +41,7 @@ LessMediaQuery* LessStylesheet::createLessMediaQuery(const TokenList &selector)
 }
 
 void LessStylesheet::deleteLessRuleset(LessRuleset& ruleset) {
-  std::list<TokenList>::const_iterator it;
-  for(it = ruleset.getLessSelector().begin();
-      it != ruleset.getLessSelector().end();
-      it++) {
-    lessrulesets.erase(*it);
-  }
-
+  lessrulesets.remove(ruleset);
   deleteStatement(ruleset);
 }
 
@@ -53,27 +49,33 @@ void LessStylesheet::deleteMixin(Mixin& mixin) {
   deleteStatement(mixin);
 }
 
+void LessStylesheet::merge(LessStylesheet& source) {
+  std::vector<LessRuleset*> rulesets;
+  std::vector<LessRuleset*>::iterator it;
+
+  takeStatements(source);
+
+  source.lessrulesets.getRulesets(rulesets);
+  for (it = rulesets.begin(); it != rulesets.end(); it++) {
+    lessrulesets.add(**it);
+  }
+  source.lessrulesets.clear();
+
+  variables.overwrite(source.variables);
+  source.variables.clear();
+}
+
 void LessStylesheet::getFunctions(std::list<const Function*>& functionList,
                                   const Mixin& mixin,
                                   const ProcessingContext &context) const {
-  std::multimap<TokenList,LessRuleset*>::const_iterator i, low, up;
+  std::vector<LessRuleset*> rulesets;
+  std::vector<LessRuleset*>::const_iterator r_it;
   const std::list<Closure*>* closures;
   std::list<Closure*>::const_iterator c_it;
-  TokenList::const_iterator t_it;
-  TokenList search;
-  for(t_it = mixin.name.begin();
-      t_it != mixin.name.end() &&
-        (*t_it).type != Token::WHITESPACE &&
-        (*t_it) != ">";
-      t_it++) {
-    search.push_back(*t_it);
-  }
 
-  low = lessrulesets.lower_bound(search);
-  up = lessrulesets.upper_bound(search);
-
-  for (i = low; i != up; i++) {
-    (*i).second->getFunctions(functionList, mixin, mixin.name.begin(), context);
+  lessrulesets.find(mixin.name.begin(), mixin.name.end(), rulesets);
+  for (r_it = rulesets.begin(); r_it != rulesets.end(); r_it++) {
+    (*r_it)->getFunctions(functionList, mixin, mixin.name.begin(), context);
   }
   
   closures = context.getBaseClosures();
@@ -89,21 +91,23 @@ void LessStylesheet::putVariable(const std::string& key,
 const TokenList* LessStylesheet::getVariable(const std::string& key) const {
   return variables.getVariable(key);
 }
-const TokenList* LessStylesheet::getVariable(const std::string& key,
+const VariableMap& LessStylesheet::getVariables() const {
+  return variables;
+}
+const TokenList* LessStylesheet::getVariable(unsigned int atom,
                                              const ProcessingContext &context) const {
   const TokenList* t;
 
-  if ((t = getVariable(key)) != NULL)
+  if ((t = variables.getVariable(atom)) != NULL)
     return t;
 
-  return context.getBaseVariable(key);
+  return context.getBaseVariable(atom);
 }
 
 void LessStylesheet::process(Stylesheet& s, void* context) const {
   std::list<Extension> extensions;
 
   std::list<Ruleset*>::const_iterator r_it;
-  std::list<Extension>::iterator e_it;
   std::list<Closure*> closureScope;
 
   ((ProcessingContext*)context)->setLessStylesheet(*this);
@@ -112,9 +116,11 @@ void LessStylesheet::process(Stylesheet& s, void* context) const {
   Stylesheet::process(s, context);
 
   // post processing
-  for (e_it = extensions.begin(); e_it != extensions.end(); e_it++) {
+  if (!extensions.empty()) {
+    ExtensionMatcher matcher(extensions);
+
     for (r_it = s.getRulesets().begin(); r_it != s.getRulesets().end(); r_it++) {
-      (*e_it).updateSelector((*r_it)->getSelector());
+      matcher.updateSelector((*r_it)->getSelector());
     }
   }
   ((ProcessingContext*)context)->popExtensionScope();
@@ -10,6 +10,10 @@ MediaQueryRuleset::MediaQueryRuleset(TokenList &selector,
 MediaQueryRuleset::~MediaQueryRuleset() {
 }
 
+const TokenList& MediaQueryRuleset::getMediaSelector() const {
+  return selector;
+}
+
 void MediaQueryRuleset::process(Stylesheet& s,
                                 const Selector* prefix,
                                 ProcessingContext& context) const {
@@ -79,6 +79,12 @@ bool Mixin::isImportant() const {
   return important;
 }
 
+void Mixin::setStylesheet(Stylesheet *s) {
+  StylesheetStatement::setStylesheet(s);
+  if (lessStylesheet != NULL)
+    lessStylesheet = (const LessStylesheet *)s;
+}
+
 const LessStylesheet *Mixin::getLessStylesheet() const {
   return lessStylesheet;
 }
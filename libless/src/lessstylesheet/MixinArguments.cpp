@@ -21,6 +21,11 @@ const TokenList *MixinArguments::get(const std::string &name) const {
     return NULL;
 }
 
+const std::map<std::string, TokenList> &MixinArguments::getNamedArguments()
+    const {
+  return namedArguments;
+}
+
 void MixinArguments::add(TokenList &argument) {
   arguments.push_back(argument);
 }
@@ -12,15 +12,15 @@ MixinCall::MixinCall(MixinCall* parent,
   this->important = important || (parent != NULL && parent->important);
 }
 
-const TokenList* MixinCall::getVariable(const std::string& key,
+const TokenList* MixinCall::getVariable(unsigned int atom,
                                         const ProcessingContext& context) const {
   const TokenList* t;
     
-  if ((t = function->getVariable(key, context)) != NULL)
+  if ((t = function->getVariable(atom, context)) != NULL)
     return t;
 
   if (parent != NULL)
-    return parent->getVariable(key, context);
+    return parent->getVariable(atom, context);
   return NULL;
 }
 
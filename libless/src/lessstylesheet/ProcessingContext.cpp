@@ -1,4 +1,5 @@
 #include "less/lessstylesheet/ProcessingContext.h"
+#include <algorithm>
 #include "less/lessstylesheet/LessRuleset.h"
 #include "less/lessstylesheet/LessStylesheet.h"
 #include "less/lessstylesheet/MixinCall.h"
@@ -8,50 +9,174 @@ ProcessingContext::ProcessingContext() {
   contextStylesheet = NULL;
 }
 ProcessingContext::~ProcessingContext() {
+  clearCaches();
+}
+
+Arena &ProcessingContext::getArena() {
+  return arena;
 }
 
 void ProcessingContext::setLessStylesheet(const LessStylesheet &stylesheet) {
   contextStylesheet = &stylesheet;
+  clearCaches();
 }
 const LessStylesheet *ProcessingContext::getLessStylesheet() const {
   return contextStylesheet;
 }
 
-const TokenList *ProcessingContext::getVariable(const std::string &key) const {
+const TokenList *ProcessingContext::getVariable(unsigned int atom) const {
+  VariableCacheKey key = {stack, atom};
+  std::unordered_map<VariableCacheKey, const TokenList *,
+                     VariableCacheHash>::const_iterator it;
   const TokenList* t;
-  
-  if (stack != NULL) {
-    if ((t = stack->getVariable(key, *this)) != NULL)
-      return t;
+
+  if ((it = variableCache.find(key)) != variableCache.end()) {
+    t = it->second;
+  } else {
+    if (stack != NULL)
+      t = stack->getVariable(atom, *this);
+    else
+      t = getLessStylesheet()->getVariable(atom, *this);
+
+    variableCache[key] = t;
+  }
+
+  if (!recording.empty())
+    recording.back().push_back(std::make_pair(atom, t));
+  return t;
+}
+
+bool ProcessingContext::isCurrent(const Evaluation &evaluation) const {
+  Dependencies::const_iterator it;
+
+  for (it = evaluation.dependencies.begin();
+       it != evaluation.dependencies.end();
+       it++) {
+    if (getVariable(it->first) != it->second)
+      return false;
+  }
+  return true;
+}
+
+bool ProcessingContext::getEvaluated(const TokenList *variable,
+                                     const Value *&value) const {
+  std::unordered_map<const TokenList *, Evaluation>::const_iterator it;
+
+  if ((it = evaluated.find(variable)) == evaluated.end() ||
+      !isCurrent(it->second))
+    return false;
+
+  value = it->second.value;
+  return true;
+}
+
+const TokenList *ProcessingContext::getProcessed
+(const TokenList *variable) const {
+  std::unordered_map<const TokenList *, Evaluation>::const_iterator it;
+
+  if ((it = processed.find(variable)) == processed.end() ||
+      !isCurrent(it->second))
     return NULL;
-  } else
-    return getLessStylesheet()->getVariable(key, *this);
+
+  return &it->second.tokens;
+}
+
+void ProcessingContext::beginEvaluation() const {
+  recording.push_back(Dependencies());
+}
+
+void ProcessingContext::endEvaluation(Evaluation &evaluation) const {
+  Dependencies::iterator it;
+
+  evaluation.dependencies.clear();
+  evaluation.dependencies.swap(recording.back());
+  recording.pop_back();
+
+  // drop repeated lookups; a lookup is the same in the whole evaluation
+  for (it = evaluation.dependencies.begin();
+       it != evaluation.dependencies.end();) {
+    if (std::find(evaluation.dependencies.begin(), it, *it) != it)
+      it = evaluation.dependencies.erase(it);
+    else
+      it++;
+  }
+
+  // the enclosing evaluation depends on the same lookups
+  if (!recording.empty()) {
+    recording.back().insert(recording.back().end(),
+                            evaluation.dependencies.begin(),
+                            evaluation.dependencies.end());
+  }
+}
+
+void ProcessingContext::putEvaluated(const TokenList *variable,
+                                     Value *value) const {
+  std::pair<std::unordered_map<const TokenList *, Evaluation>::iterator,
+            bool> ret =
+    evaluated.insert(std::make_pair(variable, Evaluation()));
+
+  if (!ret.second)
+    delete ret.first->second.value;
+  ret.first->second.value = value;
+  endEvaluation(ret.first->second);
+}
+
+void ProcessingContext::putProcessed(const TokenList *variable,
+                                     const TokenList &value) const {
+  Evaluation &evaluation = processed[variable];
+
+  evaluation.value = NULL;
+  evaluation.tokens = value;
+  endEvaluation(evaluation);
+}
+
+void ProcessingContext::cancelEvaluation() const {
+  Dependencies dependencies;
+
+  dependencies.swap(recording.back());
+  recording.pop_back();
+
+  if (!recording.empty()) {
+    recording.back().insert(recording.back().end(),
+                            dependencies.begin(), dependencies.end());
+  }
+}
+
+void ProcessingContext::clearCaches() {
+  std::unordered_map<const TokenList *, Evaluation>::iterator it;
+
+  variableCache.clear();
+  for (it = evaluated.begin(); it != evaluated.end(); it++)
+    delete it->second.value;
+  evaluated.clear();
+  processed.clear();
 }
 
 const TokenList *ProcessingContext::getFunctionVariable
-(const std::string &key,
+(unsigned int atom,
  const Function* function) const {
   
   std::map<const Function*, VariableMap>::const_iterator it;
 
   if ((it = variables.find(function)) != variables.end())
-    return (*it).second.getVariable(key);
+    return (*it).second.getVariable(atom);
   else
     return NULL;
 }
 
 const TokenList *ProcessingContext::getBaseVariable
-(const std::string &key) const {
-  return base_variables.getVariable(key);
+(unsigned int atom) const {
+  return base_variables.getVariable(atom);
 }
 
 void ProcessingContext::pushMixinCall(const Function &function,
                                       bool savepoint,
                                       bool important) {
-  stack = new MixinCall(stack, function, savepoint, important);
+  stack = arena.create<MixinCall>(stack, function, savepoint, important);
 }
 
 void ProcessingContext::popMixinCall() {
+  // The frame stays in the arena; closures may still point to it.
   if (stack != NULL) {
     stack = stack->parent;
   }
@@ -128,7 +253,7 @@ void ProcessingContext::addClosure(const LessRuleset &ruleset) {
     return;
   
   const Function* fnc = getSavePoint();
-  Closure *c = new Closure(ruleset, *stack);
+  Closure *c = arena.create<Closure>(ruleset, *stack);
   
   if (fnc != NULL)
     closures[fnc].push_back(c);
@@ -138,10 +263,15 @@ void ProcessingContext::addClosure(const LessRuleset &ruleset) {
 
 void ProcessingContext::addVariables(const VariableMap &variables) {
   const Function* fnc = getSavePoint();
-  if (fnc != NULL)
-    this->variables[fnc].overwrite(variables);
+  VariableMap &target = (fnc != NULL) ? this->variables[fnc] : base_variables;
+
+  // New variables can change what a name resolves to, which the
+  // remembered evaluations check for themselves. A definition that is
+  // replaced in place cannot be told apart.
+  if (target.overwrite(variables))
+    clearCaches();
   else
-    base_variables.overwrite(variables);
+    variableCache.clear();
 }
 
 const std::list<Closure *> *ProcessingContext::getClosures(const Function *function) const {
@@ -161,7 +291,7 @@ ValueProcessor *ProcessingContext::getValueProcessor() {
 }
 
 void ProcessingContext::interpolate(Selector &selector) const {
-  std::list<TokenList>::iterator it;
+  Selector::iterator it;
   
   for (it = selector.begin(); it != selector.end(); it++) {
     processor.interpolate(*it, *this);
@@ -174,6 +304,9 @@ void ProcessingContext::interpolate(TokenList &tokens) const {
 void ProcessingContext::interpolate(std::string &str) const {
   processor.interpolate(str, *this);
 }
+void ProcessingContext::interpolate(Token &token) const {
+  processor.interpolate(token, *this);
+}
 
 void ProcessingContext::processValue(TokenList &value) const {
   processor.processValue(value, *this);
@@ -0,0 +1,109 @@
+#include "less/lessstylesheet/RulesetIndex.h"
+#include <algorithm>
+#include <iterator>
+#include "less/lessstylesheet/LessRuleset.h"
+
+bool RulesetIndex::firstAtom(TokenList::const_iterator it,
+                             const TokenList::const_iterator &end,
+                             TokenList &key) {
+  if (it != end && *it == ">") {
+    it++;
+    while (it != end && (*it).type == Token::WHITESPACE)
+      it++;
+  }
+  if (it == end)
+    return false;
+
+  key.push_back(*it);
+  if (*it == "." && ++it != end && (*it).type == Token::IDENTIFIER) {
+    key.push_back(*it);
+    return true;
+  }
+  return false;
+}
+
+void RulesetIndex::add(LessRuleset &ruleset) {
+  const Selector &selector = ruleset.getLessSelector();
+  Selector::const_iterator it;
+  size_t pos = rulesets.size();
+  TokenList key;
+
+  rulesets.push_back(&ruleset);
+
+  for (it = selector.begin(); it != selector.end(); it++) {
+    key.clear();
+    firstAtom((*it).begin(), (*it).end(), key);
+    if (key.empty())
+      continue;
+
+    std::vector<size_t> &positions = atoms[key];
+    if (positions.empty() || positions.back() != pos)
+      positions.push_back(pos);
+  }
+}
+
+void RulesetIndex::remove(const LessRuleset &ruleset) {
+  std::vector<LessRuleset *>::iterator it;
+
+  for (it = rulesets.begin(); it != rulesets.end(); it++) {
+    if (*it == &ruleset)
+      *it = NULL;
+  }
+}
+
+void RulesetIndex::clear() {
+  rulesets.clear();
+  atoms.clear();
+}
+
+void RulesetIndex::getRulesets(std::vector<LessRuleset *> &result) const {
+  std::vector<LessRuleset *>::const_iterator it;
+
+  for (it = rulesets.begin(); it != rulesets.end(); it++) {
+    if (*it != NULL)
+      result.push_back(*it);
+  }
+}
+
+void RulesetIndex::find(TokenList::const_iterator offset,
+                        const TokenList::const_iterator &end,
+                        std::vector<LessRuleset *> &result) const {
+  std::unordered_map<TokenList, std::vector<size_t> >::const_iterator
+      single, pair;
+  std::vector<size_t> merged;
+  const std::vector<size_t> *positions;
+  std::vector<size_t>::const_iterator it;
+  TokenList key;
+  bool twoTokens = firstAtom(offset, end, key);
+
+  if (key.empty())
+    return;
+
+  // A selector that starts with a '.' that is not followed by an
+  // identifier is keyed by the '.' alone, so a name that starts with
+  // '.class' has to look for both keys.
+  pair = atoms.end();
+  if (twoTokens) {
+    pair = atoms.find(key);
+    key.pop_back();
+  }
+  single = atoms.find(key);
+
+  if (pair != atoms.end() && single != atoms.end()) {
+    std::merge(pair->second.begin(), pair->second.end(),
+               single->second.begin(), single->second.end(),
+               std::back_inserter(merged));
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    positions = &merged;
+  } else if (pair != atoms.end()) {
+    positions = &pair->second;
+  } else if (single != atoms.end()) {
+    positions = &single->second;
+  } else
+    return;
+
+  for (it = positions->begin(); it != positions->end(); it++) {
+    if (rulesets[*it] != NULL)
+      result.push_back(rulesets[*it]);
+  }
+}
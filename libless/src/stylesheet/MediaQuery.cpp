@@ -1,7 +1,7 @@
 #include "less/stylesheet/MediaQuery.h"
 
 const Token MediaQuery::BUILTIN_AND(
-                                    "and", Token::IDENTIFIER, 0, 0, Token::BUILTIN_SOURCE);
+                                    "and", Token::IDENTIFIER, SourceRegistry::BUILTIN, 0);
 
 MediaQuery::MediaQuery(const TokenList &selector) : selector(selector) {
 }
@@ -12,8 +12,8 @@ void Selector::appendSelector(const Selector &selector) {
 }
 
 
-const TokenList::const_iterator Selector::walk(const TokenList::const_iterator &t_begin,
-                                               const TokenList::const_iterator &t_end) const {
+TokenList::const_iterator Selector::walk(const TokenList::const_iterator &t_begin,
+                                         const TokenList::const_iterator &t_end) const {
   const_iterator it;
   TokenList::const_iterator t_it1, t_it2;
   
@@ -72,31 +72,36 @@ bool Selector::match(const Selector &selector) const {
 
 bool Selector::replace(const TokenList &find,
                        const TokenList &replace) {
-  const_iterator s_it;
+  return this->replace(TokenMatcher(find), replace);
+}
+
+bool Selector::replace(const TokenMatcher &find,
+                       const TokenList &replace) {
+  size_t i;
   
   TokenList::const_iterator t_it, t_match, t_start;
   TokenList newselector;
   bool ret = false;
 
-  for (s_it = begin();
-       s_it != end();
-       s_it++) {
+  // Selectors that are added are searched as well, so iterate by index.
+  for (i = 0; i < size(); i++) {
+    const TokenList &selector = (*this)[i];
 
-    t_it = t_start = (*s_it).begin();
-    t_match = (*s_it).find(find, t_it);
+    t_it = t_start = selector.begin();
+    t_match = find.find(selector, t_it);
     
-    if (t_match != (*s_it).begin()) {
+    if (t_match != selector.begin()) {
       newselector.insert(newselector.end(), t_start, t_it);
       newselector.insert(newselector.end(), replace.begin(), replace.end());
       
       t_it = t_start = t_match;
-      while ((t_match = (*s_it).find(find, t_it)) != (*s_it).begin()) {
+      while ((t_match = find.find(selector, t_it)) != selector.begin()) {
         newselector.insert(newselector.end(), t_start, t_it);
         newselector.insert(newselector.end(), replace.begin(), replace.end());
         t_it = t_start = t_match;
       }
-      newselector.insert(newselector.end(), t_start, (*s_it).end());
-      push_back(newselector);
+      newselector.insert(newselector.end(), t_start, selector.end());
+      push_back(std::move(newselector));
       newselector.clear();
       ret = true;
     }
@@ -105,28 +110,26 @@ bool Selector::replace(const TokenList &find,
 }
 
 void Selector::addPrefix(const Selector &prefix) {
-  iterator it;
-  const_iterator it2;
-  TokenList tl;
-  TokenList *inserted;
-
-  const TokenList* tmp;
+  Selector prefixed;
+  const_iterator it, it2;
   TokenList::const_iterator tmp_it;
-  
+  TokenList *inserted;
   
   bool containsAmp;
 
-  for (it = begin(); it != end(); ) {
-    tmp = &(*it);
-    containsAmp = tmp->contains(Token::OTHER, "&");
+  prefixed.reserve(size() * prefix.size());
+
+  for (it = begin(); it != end(); it++) {
+    containsAmp = (*it).contains(Token::OTHER, "&");
     
     for (it2 = prefix.begin();
          it2 != prefix.end();
          it2++) {
-      inserted = &(*insert(it, tl));
+      prefixed.push_back(TokenList());
+      inserted = &prefixed.back();
       
       if (containsAmp) {
-        for (tmp_it = tmp->begin(); tmp_it != tmp->end(); tmp_it++) {
+        for (tmp_it = (*it).begin(); tmp_it != (*it).end(); tmp_it++) {
           if (*tmp_it == "&")
             inserted->insert(inserted->end(), (*it2).begin(), (*it2).end());
           else
@@ -135,12 +138,11 @@ void Selector::addPrefix(const Selector &prefix) {
       } else {
         inserted->insert(inserted->end(), (*it2).begin(), (*it2).end());
         inserted->push_back(Token::BUILTIN_SPACE);
-        inserted->insert(inserted->end(), tmp->begin(), tmp->end());
+        inserted->insert(inserted->end(), (*it).begin(), (*it).end());
       }
     }
-    it = erase(it);
   }
-
+  swap(prefixed);
 }
 
 std::string Selector::toString() const {
@@ -6,6 +6,10 @@
 #include "less/stylesheet/StylesheetStatement.h"
 
 Stylesheet::~Stylesheet() {
+  clear();
+}
+
+void Stylesheet::clear() {
   rulesets.clear();
   atrules.clear();
   while (!statements.empty()) {
@@ -59,6 +63,17 @@ void Stylesheet::deleteStatement(StylesheetStatement& statement) {
   delete &statement;
 }
 
+void Stylesheet::takeStatements(Stylesheet& source) {
+  std::list<StylesheetStatement*>::iterator it;
+
+  for (it = source.statements.begin(); it != source.statements.end(); it++)
+    (*it)->setStylesheet(this);
+
+  statements.splice(statements.end(), source.statements);
+  rulesets.splice(rulesets.end(), source.rulesets);
+  atrules.splice(atrules.end(), source.atrules);
+}
+
 void Stylesheet::deleteRuleset(Ruleset& ruleset) {
   rulesets.remove(&ruleset);
   deleteStatement(ruleset);
@@ -1,7 +1,7 @@
 #include "less/value/BooleanValue.h"
 
 BooleanValue::BooleanValue(bool value) {
-  Token t("true", Token::IDENTIFIER, 0, 0, "generated");
+  Token t("true", Token::IDENTIFIER, SourceRegistry::GENERATED, 0);
   tokens.push_back(t);
   setValue(value);
   type = Value::BOOLEAN;
@@ -15,6 +15,10 @@ BooleanValue::BooleanValue(const Token &t, bool value) {
 BooleanValue::~BooleanValue() {
 }
 
+Value *BooleanValue::clone() const {
+  return new BooleanValue(*this);
+}
+
 bool BooleanValue::getValue() const {
   return value;
 }
@@ -248,6 +248,10 @@ Color::Color(const Color &color) : Value() {
 Color::~Color() {
 }
 
+Value *Color::clone() const {
+  return new Color(*this);
+}
+
 bool Color::parseHash(const char* hash) {
   int len;
 
@@ -565,7 +569,7 @@ float Color::getLuminance() const {
 }
 
 const TokenList* Color::getTokens() const {
-  TokenList *tokens;
+  TokenList *tokens = &generated;
   ostringstream stm;
   string sColor[3];
   string hash;
@@ -574,23 +578,26 @@ const TokenList* Color::getTokens() const {
   if (color_type == TOKEN)
     return &this->tokens;
 
-  tokens = new TokenList();
+  tokens->clear();
 
   // If the color is not opaque the rgba() function needs to be used.
   if (alpha < 1) {
-    tokens->push_back(Token("rgba", Token::IDENTIFIER, 0, 0, "generated"));
+    tokens->push_back(
+        Token("rgba", Token::IDENTIFIER, SourceRegistry::GENERATED, 0));
     tokens->push_back(Token::BUILTIN_PAREN_OPEN);
 
     for (i = 0; i < 3; i++) {
       stm.str("");
       stm << (rgb[i] & 0xFF);
-      tokens->push_back(Token(stm.str(), Token::NUMBER, 0, 0, "generated"));
+      tokens->push_back(
+          Token(stm.str(), Token::NUMBER, SourceRegistry::GENERATED, 0));
       tokens->push_back(Token::BUILTIN_COMMA);
       tokens->push_back(Token::BUILTIN_SPACE);
     }
     stm.str("");
     stm << alpha;
-    tokens->push_back(Token(stm.str(), Token::NUMBER, 0, 0, "generated"));
+    tokens->push_back(
+        Token(stm.str(), Token::NUMBER, SourceRegistry::GENERATED, 0));
     tokens->push_back(Token::BUILTIN_PAREN_CLOSED);
 
   } else {
@@ -618,7 +625,8 @@ const TokenList* Color::getTokens() const {
       hash = stm.str();
     }
 
-    tokens->push_back(Token(hash, Token::HASH, 0, 0, "generated"));
+    tokens->push_back(
+        Token(hash, Token::HASH, SourceRegistry::GENERATED, 0));
   }
   return tokens;
 }
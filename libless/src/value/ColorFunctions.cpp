@@ -258,7 +258,7 @@ Value* ColorFunctions::argb(const vector<const Value*>& arguments) {
     stm << sColor[i];
   }
   hash = stm.str();
-  t = Token(hash, Token::STRING, 0, 0, "generated");
+  t = Token(hash, Token::STRING, SourceRegistry::GENERATED, 0);
   return new StringValue(t, false);
 }
 
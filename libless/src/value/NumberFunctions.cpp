@@ -58,7 +58,7 @@ Value* NumberFunctions::unit(const vector<const Value*>& arguments) {
 }
 
 Value* NumberFunctions::get_unit(const vector<const Value*>& arguments) {
-  Token t("", Token::IDENTIFIER, 0, 0, NULL);
+  Token t("", Token::IDENTIFIER, SourceRegistry::GENERATED, 0);
   const NumberValue* val;
   if (arguments[0]->type == Value::NUMBER ||
       arguments[0]->type == Value::DIMENSION) {
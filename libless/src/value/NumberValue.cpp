@@ -22,7 +22,8 @@ NumberValue::NumberValue(const Token& token) {
   }
 }
 NumberValue::NumberValue(double value) {
-  tokens.push_back(Token("", Token::NUMBER, 0, 0, "generated"));
+  tokens.push_back(
+      Token("", Token::NUMBER, SourceRegistry::GENERATED, 0));
   type = NUMBER;
   setValue(value);
 }
@@ -39,7 +40,7 @@ NumberValue::NumberValue(double value,
   if (type == Token::DIMENSION && unit == NULL)
     throw new ValueException("Dimension requires a unit.", *this->getTokens());
 
-  tokens.push_back(Token("", type, 0, 0, "generated"));
+  tokens.push_back(Token("", type, SourceRegistry::GENERATED, 0));
 
   switch (type) {
     case Token::NUMBER:
@@ -72,6 +73,10 @@ NumberValue::NumberValue(const NumberValue& n) : Value() {
 NumberValue::~NumberValue() {
 }
 
+Value *NumberValue::clone() const {
+  return new NumberValue(*this);
+}
+
 void NumberValue::verifyUnits(const NumberValue& n) {
   if (type == Value::DIMENSION && n.type == Value::DIMENSION &&
       getUnit().compare(n.getUnit()) != 0) {
@@ -115,7 +115,7 @@ Value* StringFunctions::color(const vector<const Value*>& arguments) {
 
   s = static_cast<const StringValue*>(arguments[0]);
 
-  t = Token(s->getString(), Token::HASH, 0, 0, "generated");
+  t = Token(s->getString(), Token::HASH, SourceRegistry::GENERATED, 0);
   return new Color(t);
 }
 Value* StringFunctions::data_uri(const vector<const Value*>& arguments) {
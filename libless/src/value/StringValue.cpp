@@ -10,7 +10,7 @@ StringValue::StringValue(const Token& token, bool quotes) {
 }
 
 StringValue::StringValue(const std::string& str, bool quotes) {
-  Token token(str, Token::STRING, 0, 0, "generated");
+  Token token(str, Token::STRING, SourceRegistry::GENERATED, 0);
 
   type = Value::STRING;
   tokens.push_back(token);
@@ -19,7 +19,7 @@ StringValue::StringValue(const std::string& str, bool quotes) {
 }
 
 StringValue::StringValue(const StringValue& s) : Value() {
-  Token token(s.getString(), Token::STRING, 0, 0, "generated");
+  Token token(s.getString(), Token::STRING, SourceRegistry::GENERATED, 0);
 
   type = Value::STRING;
   tokens.push_back(token);
@@ -48,6 +48,13 @@ StringValue::StringValue(const Value& val, bool quotes) {
 StringValue::~StringValue() {
 }
 
+Value *StringValue::clone() const {
+  StringValue *s = new StringValue(*this);
+  // the copy constructor does not keep the source location
+  s->setLocation(tokens.front());
+  return s;
+}
+
 void StringValue::updateTokens() {
   std::string::iterator i;
   std::string newstr;
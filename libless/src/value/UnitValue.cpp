@@ -8,6 +8,10 @@ UnitValue::UnitValue(Token &token) {
 UnitValue::~UnitValue() {
 }
 
+Value *UnitValue::clone() const {
+  return new UnitValue(*this);
+}
+
 const char *UnitValue::getUnit() const {
   return tokens.front().c_str();
 }
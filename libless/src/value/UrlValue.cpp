@@ -45,12 +45,16 @@ UrlValue::UrlValue(Token& token, std::string& path) : Value() {
 UrlValue::~UrlValue() {
 }
 
+Value *UrlValue::clone() const {
+  return new UrlValue(*this);
+}
+
 std::string UrlValue::getPath() const {
   return path;
 }
 
 std::string UrlValue::getRelativePath() const {
-  std::string source = tokens.front().source;
+  std::string source = tokens.front().getSource();
   size_t pos = source.find_last_of("/\\");
   std::string relative_path;
 
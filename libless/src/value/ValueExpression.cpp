@@ -0,0 +1,50 @@
+#include "less/value/ValueExpression.h"
+
+const size_t ValueExpression::NONE;
+const size_t ValueExpression::INVALID;
+
+ValueExpression::ValueExpression()
+    : valueState(UNPARSED),
+      statementState(UNPARSED),
+      statement(NONE),
+      conditionState(UNPARSED),
+      negate(false) {
+}
+
+ValueExpression::~ValueExpression() {
+  std::vector<Value *>::iterator it;
+
+  for (it = constants.begin(); it != constants.end(); it++)
+    delete *it;
+}
+
+size_t ValueExpression::addNode(NodeType type,
+                                size_t token,
+                                size_t first,
+                                size_t second) {
+  Node node;
+
+  node.type = type;
+  node.token = token;
+  node.first = first;
+  node.second = second;
+  node.op = 0;
+  node.function = NULL;
+  node.defaultVal = false;
+
+  switch (type) {
+    case COLOR:
+    case NUMBER:
+    case BOOLEAN:
+    case UNIT:
+    case COLOR_NAME:
+    case LITERAL:
+      node.constant = true;
+      break;
+    default:
+      node.constant = false;
+      break;
+  }
+  nodes.push_back(node);
+  return nodes.size() - 1;
+}
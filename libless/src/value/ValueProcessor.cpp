@@ -1,8 +1,23 @@
 #include "less/value/ValueProcessor.h"
+#include "less/LessException.h"
+#include "less/less/ConstantFolder.h"
 #include "less/value/ColorFunctions.h"
 #include "less/value/NumberFunctions.h"
 #include "less/value/StringFunctions.h"
 #include "less/value/UrlFunctions.h"
+#include "less/value/ValueExpression.h"
+
+/**
+ * The scope of constants, which has no variables.
+ */
+class ConstantScope : public ValueScope {
+public:
+  virtual const TokenList *getVariable(unsigned int atom) const {
+    (void)atom;
+    return NULL;
+  }
+  using ValueScope::getVariable;
+};
 
 
 ValueProcessor::ValueProcessor() {
@@ -12,17 +27,17 @@ ValueProcessor::ValueProcessor() {
   UrlFunctions::loadFunctions(functionLibrary);
 }
 ValueProcessor::~ValueProcessor() {
+  std::unordered_map<TokenList, ValueExpression *>::iterator it;
+
+  for (it = expressions.begin(); it != expressions.end(); it++)
+    delete it->second;
 }
 
 void ValueProcessor::processValue(TokenList &value,
                                   const ValueScope &scope) const {
   TokenList::iterator i;
   TokenList newvalue;
-  Value *v;
-  const TokenList *var;
-  TokenList variable;
-  const TokenList *oldvalue = &value;
-  TokenList::const_iterator i2, itmp, end;
+  ValueExpression *expression;
 
   if (!needsProcessing(value)) {
     // interpolate strings
@@ -33,6 +48,35 @@ void ValueProcessor::processValue(TokenList &value,
     return;
   }
 
+  expression = getExpression(value);
+  if (expression != NULL &&
+      expression->valueState == ValueExpression::UNPARSED)
+    parseValue(value, *expression);
+
+  if (expression != NULL &&
+      expression->valueState == ValueExpression::PARSED) {
+    // errors are reported by the interpreter
+    try {
+      if (evaluateValue(*expression, value, newvalue, scope)) {
+        value = newvalue;
+        return;
+      }
+    } catch (LessException *e) {
+      delete e;
+    }
+  }
+  interpretValue(value, scope);
+}
+
+void ValueProcessor::interpretValue(TokenList &value,
+                                    const ValueScope &scope) const {
+  TokenList newvalue;
+  Value *v;
+  const TokenList *var;
+  TokenList variable;
+  const TokenList *oldvalue = &value;
+  TokenList::const_iterator i2, itmp, end;
+
   end = oldvalue->end();
   for (i2 = oldvalue->begin(); i2 != end;) {
     try {
@@ -62,10 +106,7 @@ void ValueProcessor::processValue(TokenList &value,
       // variable containing a non-value.
       if ((*i2).type == Token::ATKEYWORD &&
           (var = scope.getVariable(*i2)) != NULL) {
-        variable = *var;
-        processValue(variable, scope);
-
-        newvalue.insert(newvalue.end(), variable.begin(), variable.end());
+        appendVariable(*var, newvalue, scope);
         i2++;
 
         // deep variable
@@ -110,10 +151,8 @@ bool ValueProcessor::needsProcessing(const TokenList &value) const {
 
     } else {
       if (*i == "~") {
-        if ((*++i).type == Token::STRING)
+        if (i + 1 != value.end() && (*(i + 1)).type == Token::STRING)
           return true;
-        else
-          i--;
 
       } else if ((*i).type == Token::IDENTIFIER || (*i).type == Token::OTHER) {
         // function
@@ -134,6 +173,28 @@ bool ValueProcessor::needsProcessing(const TokenList &value) const {
 bool ValueProcessor::validateCondition(const TokenList &value,
                                        const ValueScope &scope,
                                        bool defaultVal) const {
+  ValueExpression *expression = getExpression(value);
+  bool ret;
+
+  if (expression != NULL &&
+      expression->conditionState == ValueExpression::UNPARSED)
+    parseCondition(value, *expression);
+
+  if (expression != NULL &&
+      expression->conditionState == ValueExpression::PARSED) {
+    try {
+      if (evaluateCondition(*expression, value, scope, defaultVal, ret))
+        return ret;
+    } catch (LessException *e) {
+      delete e;
+    }
+  }
+  return interpretCondition(value, scope, defaultVal);
+}
+
+bool ValueProcessor::interpretCondition(const TokenList &value,
+                                        const ValueScope &scope,
+                                        bool defaultVal) const {
   TokenList::const_iterator i = value.begin();
   TokenList::const_iterator end = value.end();
   bool negate = false;
@@ -141,7 +202,7 @@ bool ValueProcessor::validateCondition(const TokenList &value,
 
   skipWhitespace(i, end);
 
-  if (*i == "not") {
+  if (i != end && *i == "not") {
     negate = true;
     i++;
   }
@@ -179,11 +240,7 @@ bool ValueProcessor::validateValue(TokenList::const_iterator &i,
   v = processStatement(i, end, scope, defaultVal);
 
   if (v == NULL) {
-    throw new ParseException(*reference,
-                             "condition",
-                             reference->line,
-                             reference->column,
-                             reference->source);
+    throw new ParseException(*reference, "condition");
   }
 
   ret = (*v == trueVal);
@@ -195,6 +252,31 @@ bool ValueProcessor::validateValue(TokenList::const_iterator &i,
 
 Value *ValueProcessor::processStatement(const TokenList &tokens,
                                         const ValueScope &scope) const {
+  ValueExpression *expression = getExpression(tokens);
+  Value *ret;
+
+  if (expression != NULL &&
+      expression->statementState == ValueExpression::UNPARSED)
+    parseSingleStatement(tokens, *expression);
+
+  if (expression != NULL &&
+      expression->statementState == ValueExpression::PARSED) {
+    if (expression->statement == ValueExpression::NONE)
+      return NULL;
+    try {
+      ret = evaluate(*expression, expression->statement, tokens, scope, false);
+      if (ret != NULL)
+        return ret;
+    } catch (LessException *e) {
+      delete e;
+    }
+  }
+
+  return interpretStatement(tokens, scope);
+}
+
+Value *ValueProcessor::interpretStatement(const TokenList &tokens,
+                                          const ValueScope &scope) const {
   TokenList::const_iterator i = tokens.begin();
   TokenList::const_iterator end = tokens.end();
   Value *ret = processStatement(i, end, scope);
@@ -258,12 +340,11 @@ Value *ValueProcessor::processOperation(TokenList::const_iterator &i,
     if (i == end)
       throw new ParseException("end of line",
                                "Constant or @-variable",
-                               opToken->line,
-                               opToken->column,
-                               opToken->source);
+                               opToken->getLine(),
+                               opToken->getColumn(),
+                               opToken->getSource());
     else
-      throw new ParseException(
-          *i, "Constant or @-variable", (*i).line, (*i).column, (*i).source);
+      throw new ParseException(*i, "Constant or @-variable");
   }
 
   skipWhitespace(i, end);
@@ -393,9 +474,7 @@ Value *ValueProcessor::processConstant(TokenList::const_iterator &i,
 
     case Token::ATKEYWORD:
       if ((var = scope.getVariable(token)) != NULL) {
-        variable = *var;
-
-        ret = processStatement(variable, scope);
+        ret = processVariable(*var, scope);
 
         if (ret != NULL) {
           i++;
@@ -427,9 +506,7 @@ Value *ValueProcessor::processConstant(TokenList::const_iterator &i,
         if (token == "default") {
           i++;
           if ((*i).type != Token::PAREN_CLOSED) {
-            throw new ParseException(*i,
-                                     ")",
-                                     (*i).line, (*i).column, (*i).source);
+            throw new ParseException(*i, ")");
           }
           return new BooleanValue(token, defaultVal);
         } else if (functionExists(token.c_str())) {
@@ -526,6 +603,55 @@ Value *ValueProcessor::processSubstatement(TokenList::const_iterator &i,
   return ret;
 }
 
+Value *ValueProcessor::processVariable(const TokenList &variable,
+                                       const ValueScope &scope) const {
+  const Value *cached;
+  Value *ret;
+
+  // a constant is cheaper to evaluate again than to look up
+  if (!needsProcessing(variable))
+    return interpretStatement(variable, scope);
+
+  if (scope.getEvaluated(&variable, cached))
+    return (cached != NULL) ? cached->clone() : NULL;
+
+  scope.beginEvaluation();
+  try {
+    ret = processStatement(variable, scope);
+  } catch (...) {
+    scope.cancelEvaluation();
+    throw;
+  }
+  scope.putEvaluated(&variable, (ret != NULL) ? ret->clone() : NULL);
+  return ret;
+}
+
+void ValueProcessor::appendVariable(const TokenList &variable,
+                                    TokenList &value,
+                                    const ValueScope &scope) const {
+  const TokenList *processed;
+  TokenList tokens = variable;
+
+  if (!needsProcessing(variable)) {
+    processValue(tokens, scope);
+    value.insert(value.end(), tokens.begin(), tokens.end());
+    return;
+  }
+
+  if ((processed = scope.getProcessed(&variable)) == NULL) {
+    scope.beginEvaluation();
+    try {
+      processValue(tokens, scope);
+    } catch (...) {
+      scope.cancelEvaluation();
+      throw;
+    }
+    scope.putProcessed(&variable, tokens);
+    processed = &tokens;
+  }
+  value.insert(value.end(), processed->begin(), processed->end());
+}
+
 const TokenList *ValueProcessor::processDeepVariable(
     TokenList::const_iterator &i,
     TokenList::const_iterator &end,
@@ -600,7 +726,9 @@ Value *ValueProcessor::processFunction(const Token &function,
       fnc_str << ")";
       throw new ParseException(fnc_str.str(),
                                functionLibrary.functionDefToString(function.c_str(), fi),
-                               function.line, function.column, function.source);
+                               function.getLine(),
+                               function.getColumn(),
+                               function.getSource());
     }
     ret = fi->func(arguments);
     ret->setLocation(function);
@@ -653,7 +781,7 @@ bool ValueProcessor::processArguments(TokenList::const_iterator &i,
     throw new ParseException("end of value", ")", 0, 0, "");
 
   if ((*i).type != Token::PAREN_CLOSED)
-    throw new ParseException(*i, ")", (*i).line, (*i).column, (*i).source);
+    throw new ParseException(*i, ")");
 
   i++;
   return true;
@@ -669,7 +797,7 @@ Value *ValueProcessor::processEscape(TokenList::const_iterator &i,
 
   i++;
 
-  if ((*i).type != Token::STRING) {
+  if (i == end || (*i).type != Token::STRING) {
     i--;
     return NULL;
   }
@@ -723,7 +851,7 @@ Value *ValueProcessor::processNegative(TokenList::const_iterator &i,
   Token minus;
   Value *constant;
   Value *zero, *ret;
-  Token t_zero("0", Token::NUMBER, 0, 0, "generated");
+  Token t_zero("0", Token::NUMBER, SourceRegistry::GENERATED, 0);
 
   if (i == end || (*i) != "-")
     return NULL;
@@ -750,6 +878,698 @@ Value *ValueProcessor::processNegative(TokenList::const_iterator &i,
   return ret;
 }
 
+ValueExpression *ValueProcessor::getExpression(const TokenList &value) const {
+  std::unordered_map<TokenList, ValueExpression *>::iterator it;
+
+  it = expressions.find(value);
+  if (it != expressions.end())
+    return it->second;
+  if (expressions.size() >= MAX_EXPRESSIONS)
+    return NULL;
+
+  return expressions[value] = new ValueExpression();
+}
+
+void ValueProcessor::parseValue(const TokenList &value,
+                                ValueExpression &expression) const {
+  TokenList::const_iterator i = value.begin(), itmp, end = value.end();
+  ValueExpression::Segment segment;
+  size_t node;
+
+  expression.valueState = ValueExpression::UNPARSABLE;
+
+  while (i != end) {
+    itmp = i;
+    node = parseStatement(value, itmp, expression, false);
+    i = itmp;
+
+    if (node == ValueExpression::INVALID)
+      return;
+
+    if (node != ValueExpression::NONE) {
+      segment.type =
+          (expression.nodes[node].type == ValueExpression::VARIABLE)
+              ? ValueExpression::VARIABLE_STATEMENT
+              : ValueExpression::STATEMENT;
+      segment.node = node;
+      segment.begin = segment.end = 0;
+
+    } else if (i != end) {
+      segment.type = ValueExpression::TOKENS;
+      segment.node = ValueExpression::NONE;
+      segment.begin = i - value.begin();
+      i++;
+
+      if ((*(i - 1)).type == Token::IDENTIFIER && i != end &&
+          (*i).type == Token::PAREN_OPEN)
+        i++;
+      segment.end = i - value.begin();
+    } else
+      break;
+
+    expression.segments.push_back(segment);
+  }
+  expression.valueState = ValueExpression::PARSED;
+}
+
+void ValueProcessor::parseSingleStatement(const TokenList &value,
+                                          ValueExpression &expression) const {
+  TokenList::const_iterator i = value.begin();
+  size_t node = parseStatement(value, i, expression, false);
+
+  if (node == ValueExpression::INVALID ||
+      (node != ValueExpression::NONE && i != value.end())) {
+    expression.statementState = ValueExpression::UNPARSABLE;
+    return;
+  }
+  expression.statement = node;
+  expression.statementState = ValueExpression::PARSED;
+}
+
+void ValueProcessor::parseCondition(const TokenList &value,
+                                    ValueExpression &expression) const {
+  TokenList::const_iterator i = value.begin();
+  TokenList::const_iterator end = value.end();
+  size_t node;
+  bool first = true;
+
+  expression.conditionState = ValueExpression::UNPARSABLE;
+
+  skipWhitespace(i, end);
+
+  if (i != end && *i == "not") {
+    expression.negate = true;
+    i++;
+  }
+
+  while (first || (i != end && *i == "and")) {
+    if (!first) {
+      i++;
+      skipWhitespace(i, end);
+    }
+    first = false;
+
+    if (i == end) {
+      expression.conditions.push_back(ValueExpression::NONE);
+      break;
+    }
+
+    node = parseStatement(value, i, expression, true);
+    if (node == ValueExpression::INVALID || node == ValueExpression::NONE)
+      return;
+    expression.conditions.push_back(node);
+
+    skipWhitespace(i, end);
+  }
+  expression.conditionState = ValueExpression::PARSED;
+}
+
+size_t ValueProcessor::parseStatement(const TokenList &value,
+                                      TokenList::const_iterator &i,
+                                      ValueExpression &expression,
+                                      bool defaultVal) const {
+  TokenList::const_iterator end = value.end();
+  size_t node, op;
+
+  skipWhitespace(i, end);
+  node = parseConstant(value, i, expression, defaultVal);
+
+  if (node == ValueExpression::NONE || node == ValueExpression::INVALID)
+    return node;
+
+  skipWhitespace(i, end);
+
+  while ((op = parseOperation(value, i, node, expression, OP_NONE,
+                              defaultVal)) != ValueExpression::NONE) {
+    if (op == ValueExpression::INVALID)
+      return op;
+    node = op;
+
+    skipWhitespace(i, end);
+  }
+  return node;
+}
+
+size_t ValueProcessor::parseOperation(const TokenList &value,
+                                      TokenList::const_iterator &i,
+                                      size_t operand1,
+                                      ValueExpression &expression,
+                                      ValueProcessor::Operator lastop,
+                                      bool defaultVal) const {
+  TokenList::const_iterator tmp, end = value.end();
+  size_t opToken, operand2, result;
+  Operator op;
+
+  if (i == end)
+    return ValueExpression::NONE;
+
+  opToken = i - value.begin();
+  tmp = i;
+
+  if ((op = processOperator(tmp, end)) == OP_NONE ||
+      (lastop != OP_NONE && lastop >= op))
+    return ValueExpression::NONE;
+
+  i = tmp;
+  skipWhitespace(i, end);
+
+  // a missing operand is a parse error
+  operand2 = parseConstant(value, i, expression, defaultVal);
+  if (operand2 == ValueExpression::NONE ||
+      operand2 == ValueExpression::INVALID)
+    return ValueExpression::INVALID;
+
+  skipWhitespace(i, end);
+
+  while ((result = parseOperation(value, i, operand2, expression, op,
+                                  defaultVal)) != ValueExpression::NONE) {
+    if (result == ValueExpression::INVALID)
+      return result;
+    operand2 = result;
+
+    skipWhitespace(i, end);
+  }
+
+  result = expression.addNode(
+      ValueExpression::OPERATION, opToken, operand1, operand2);
+  expression.nodes[result].op = op;
+  return foldNode(value, expression, result);
+}
+
+size_t ValueProcessor::parseConstant(const TokenList &value,
+                                     TokenList::const_iterator &i,
+                                     ValueExpression &expression,
+                                     bool defaultVal) const {
+  TokenList::const_iterator end = value.end();
+  size_t token, node;
+  Token t;
+  Value *constant;
+
+  if (i == end)
+    return ValueExpression::NONE;
+
+  token = i - value.begin();
+
+  switch ((*i).type) {
+    case Token::HASH:
+      i++;
+      return expression.addNode(ValueExpression::COLOR, token);
+
+    case Token::NUMBER:
+    case Token::PERCENTAGE:
+    case Token::DIMENSION:
+      i++;
+      return expression.addNode(ValueExpression::NUMBER, token);
+
+    case Token::ATKEYWORD:
+      // evaluates to NULL if the variable is not defined
+      i++;
+      return expression.addNode(ValueExpression::VARIABLE, token);
+
+    case Token::STRING:
+      i++;
+      node = expression.addNode(ValueExpression::STRING, token);
+      expression.nodes[node].constant =
+          (value[token].find("@{") == std::string::npos);
+      return node;
+
+    case Token::URL:
+      i++;
+      return expression.addNode(ValueExpression::URL, token);
+
+    case Token::IDENTIFIER:
+      i++;
+
+      if (i != end && (*i).type == Token::PAREN_OPEN) {
+        if (value[token] == "default") {
+          i++;
+          if (i == end || (*i).type != Token::PAREN_CLOSED)
+            return ValueExpression::INVALID;
+
+          node = expression.addNode(ValueExpression::DEFAULT, token);
+          expression.nodes[node].defaultVal = defaultVal;
+          return node;
+
+        } else if (functionExists(value[token].c_str())) {
+          i++;
+
+          if ((node = parseFunction(value, i, expression)) ==
+              ValueExpression::NONE) {
+            i--;
+            i--;
+          }
+          return node;
+
+        } else {
+          i--;
+          return ValueExpression::NONE;
+        }
+      }
+
+      t = value[token];
+      if (t.compare("true") == 0)
+        return expression.addNode(ValueExpression::BOOLEAN, token);
+
+      if ((constant = processUnit(t)) != NULL) {
+        delete constant;
+        return expression.addNode(ValueExpression::UNIT, token);
+      }
+      if ((constant = Color::fromName(t)) != NULL) {
+        delete constant;
+        return expression.addNode(ValueExpression::COLOR_NAME, token);
+      }
+      return expression.addNode(ValueExpression::LITERAL, token);
+
+    case Token::PAREN_OPEN:
+      return parseSubstatement(value, i, expression, defaultVal);
+
+    default:
+      break;
+  }
+
+  // variable variables are looked up when they are evaluated
+  if ((*i).type == Token::OTHER && *i == "@")
+    return ValueExpression::INVALID;
+
+  if (*i == "%") {
+    i++;
+    if (i != end && (*i).type == Token::PAREN_OPEN) {
+      i++;
+
+      if ((node = parseFunction(value, i, expression)) !=
+          ValueExpression::NONE)
+        return node;
+
+      i--;
+    }
+    i--;
+  }
+
+  if (*i == "~") {
+    i++;
+    if (i != end && (*i).type == Token::STRING) {
+      i++;
+      node = expression.addNode(ValueExpression::ESCAPE, token + 1);
+      expression.nodes[node].constant =
+          (value[token + 1].find("@{") == std::string::npos);
+      return node;
+    }
+    i--;
+  }
+
+  if (*i == "-") {
+    i++;
+    skipWhitespace(i, end);
+
+    // the interpreter does not restore the position of a lone minus
+    node = parseConstant(value, i, expression, false);
+    if (node == ValueExpression::NONE || node == ValueExpression::INVALID)
+      return ValueExpression::INVALID;
+    return foldNode(value,
+                    expression,
+                    expression.addNode(ValueExpression::NEGATIVE, token, node));
+  }
+  return ValueExpression::NONE;
+}
+
+size_t ValueProcessor::parseSubstatement(const TokenList &value,
+                                         TokenList::const_iterator &i,
+                                         ValueExpression &expression,
+                                         bool defaultVal) const {
+  TokenList::const_iterator i2 = i, end = value.end();
+  size_t node;
+
+  i2++;
+
+  node = parseStatement(value, i2, expression, defaultVal);
+  if (node == ValueExpression::NONE || node == ValueExpression::INVALID)
+    return node;
+
+  skipWhitespace(i2, end);
+
+  // the interpreter evaluates the statement before it gives up
+  if (i2 == end || (*i2).type != Token::PAREN_CLOSED)
+    return ValueExpression::INVALID;
+
+  node = expression.addNode(
+      ValueExpression::SUBSTATEMENT, i - value.begin(), node);
+  i = i2 + 1;
+  return foldNode(value, expression, node);
+}
+
+size_t ValueProcessor::parseFunction(const TokenList &value,
+                                     TokenList::const_iterator &i,
+                                     ValueExpression &expression) const {
+  TokenList::const_iterator i2 = i, end = value.end();
+  size_t function = (i - 2) - value.begin();
+  const FuncInfo *fi = functionLibrary.getFunction(value[function].c_str());
+  std::vector<size_t> arguments;
+  size_t node;
+
+  if (fi == NULL || i2 == end)
+    return ValueExpression::NONE;
+
+  if ((*i2).type != Token::PAREN_CLOSED) {
+    node = parseStatement(value, i2, expression, false);
+    if (node == ValueExpression::INVALID || i2 == end)
+      return ValueExpression::INVALID;
+
+    if (node == ValueExpression::NONE) {
+      node = expression.addNode(ValueExpression::LITERAL, i2 - value.begin());
+      i2++;
+    }
+    arguments.push_back(node);
+  }
+
+  while (i2 != end && (*i2 == "," || *i2 == ";")) {
+    i2++;
+
+    node = parseStatement(value, i2, expression, false);
+    if (node == ValueExpression::INVALID || i2 == end)
+      return ValueExpression::INVALID;
+
+    if (node != ValueExpression::NONE) {
+      arguments.push_back(node);
+    } else if ((*i2).type != Token::PAREN_CLOSED) {
+      arguments.push_back(
+          expression.addNode(ValueExpression::LITERAL, i2 - value.begin()));
+      i2++;
+    }
+  }
+
+  if (i2 == end || (*i2).type != Token::PAREN_CLOSED)
+    return ValueExpression::INVALID;
+  i = i2 + 1;
+
+  node = expression.addNode(ValueExpression::FUNCTION,
+                            function,
+                            expression.arguments.size(),
+                            arguments.size());
+  expression.nodes[node].function = fi;
+  expression.arguments.insert(
+      expression.arguments.end(), arguments.begin(), arguments.end());
+  return foldNode(value, expression, node);
+}
+
+size_t ValueProcessor::foldNode(const TokenList &value,
+                                ValueExpression &expression,
+                                size_t node) const {
+  ValueExpression::Node *n = &expression.nodes[node];
+  const ConstantScope scope;
+  Value *constant;
+  size_t i;
+
+  switch (n->type) {
+    case ValueExpression::OPERATION:
+      n->constant = expression.nodes[n->first].constant &&
+                    expression.nodes[n->second].constant;
+      break;
+
+    case ValueExpression::NEGATIVE:
+    case ValueExpression::SUBSTATEMENT:
+      n->constant = expression.nodes[n->first].constant;
+      break;
+
+    case ValueExpression::FUNCTION:
+      n->constant = ConstantFolder::isFoldable(value[n->token]);
+      for (i = n->first; i < n->first + n->second; i++) {
+        if (!expression.nodes[expression.arguments[i]].constant)
+          n->constant = false;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  if (!n->constant)
+    return node;
+
+  try {
+    constant = evaluate(expression, node, value, scope, false);
+  } catch (LessException *e) {
+    delete e;
+    constant = NULL;
+  }
+
+  // a copy of a string does not keep the type of its token
+  if (constant == NULL || constant->type == Value::STRING) {
+    delete constant;
+    n->constant = false;
+    return node;
+  }
+
+  n->type = ValueExpression::CONSTANT;
+  n->first = expression.constants.size();
+  expression.constants.push_back(constant);
+  return node;
+}
+
+Value *ValueProcessor::evaluate(const ValueExpression &expression,
+                                size_t node,
+                                const TokenList &value,
+                                const ValueScope &scope,
+                                bool defaultVal) const {
+  const ValueExpression::Node &n = expression.nodes[node];
+  const TokenList *var;
+  vector<const Value *> arguments;
+  vector<const Value *>::iterator it;
+  Value *operand1 = NULL, *operand2 = NULL, *ret = NULL;
+  Token token;
+  bool hasQuotes;
+  std::string str;
+  size_t i;
+
+  switch (n.type) {
+    case ValueExpression::COLOR:
+      return new Color(value[n.token]);
+
+    case ValueExpression::NUMBER:
+      return new NumberValue(value[n.token]);
+
+    case ValueExpression::VARIABLE:
+      if ((var = scope.getVariable(value[n.token])) == NULL)
+        return NULL;
+      return processVariable(*var, scope);
+
+    case ValueExpression::STRING:
+      token = value[n.token];
+      hasQuotes = token.stringHasQuotes();
+      interpolate(token, scope);
+      token.removeQuotes();
+      return new StringValue(token, hasQuotes);
+
+    case ValueExpression::URL:
+      token = value[n.token];
+      interpolate(token, scope);
+      str = token.getUrlString();
+      return new UrlValue(token, str);
+
+    case ValueExpression::DEFAULT:
+      return new BooleanValue(value[n.token], n.defaultVal && defaultVal);
+
+    case ValueExpression::BOOLEAN:
+      return new BooleanValue(value[n.token], true);
+
+    case ValueExpression::UNIT:
+      token = value[n.token];
+      return processUnit(token);
+
+    case ValueExpression::COLOR_NAME:
+      return Color::fromName(value[n.token]);
+
+    case ValueExpression::LITERAL:
+      return new StringValue(value[n.token], false);
+
+    case ValueExpression::ESCAPE:
+      token = value[n.token];
+      interpolate(token, scope);
+      token.removeQuotes();
+      return new StringValue(token, false);
+
+    case ValueExpression::FUNCTION:
+      try {
+        for (i = n.first; i < n.first + n.second; i++) {
+          if ((operand1 = evaluate(expression, expression.arguments[i],
+                                   value, scope, defaultVal)) == NULL)
+            break;
+          arguments.push_back(operand1);
+        }
+        // the interpreter reports wrong arguments
+        if (operand1 != NULL || n.second == 0) {
+          if (functionLibrary.checkArguments(n.function, arguments)) {
+            ret = n.function->func(arguments);
+            ret->setLocation(value[n.token]);
+          }
+        }
+      } catch (...) {
+        for (it = arguments.begin(); it != arguments.end(); it++)
+          delete (*it);
+        throw;
+      }
+      for (it = arguments.begin(); it != arguments.end(); it++)
+        delete (*it);
+      return ret;
+
+    case ValueExpression::NEGATIVE:
+      if ((operand2 = evaluate(expression, n.first, value, scope,
+                               defaultVal)) == NULL)
+        return NULL;
+      operand1 = new NumberValue(
+          Token("0", Token::NUMBER, SourceRegistry::GENERATED, 0));
+      try {
+        ret = *operand1 - *operand2;
+      } catch (...) {
+        delete operand1;
+        delete operand2;
+        throw;
+      }
+      ret->setLocation(value[n.token]);
+      delete operand1;
+      delete operand2;
+      return ret;
+
+    case ValueExpression::SUBSTATEMENT:
+      if ((ret = evaluate(expression, n.first, value, scope, defaultVal)) !=
+          NULL)
+        ret->setLocation(value[n.token]);
+      return ret;
+
+    case ValueExpression::CONSTANT:
+      ret = expression.constants[n.first]->clone();
+      ret->setLocation(value[n.token]);
+      return ret;
+
+    case ValueExpression::OPERATION:
+      if ((operand1 = evaluate(expression, n.first, value, scope,
+                               defaultVal)) == NULL)
+        return NULL;
+      try {
+        if ((operand2 = evaluate(expression, n.second, value, scope,
+                                 defaultVal)) != NULL) {
+          switch (n.op) {
+            case OP_ADD:
+              ret = *operand1 + *operand2;
+              break;
+            case OP_SUBSTRACT:
+              ret = *operand1 - *operand2;
+              break;
+            case OP_MULTIPLY:
+              ret = *operand1 * *operand2;
+              break;
+            case OP_DIVIDE:
+              ret = *operand1 / *operand2;
+              break;
+            case OP_EQUALS:
+              ret = new BooleanValue(*operand1 == *operand2);
+              break;
+            case OP_LESS:
+              ret = new BooleanValue(*operand1 < *operand2);
+              break;
+            case OP_GREATER:
+              ret = new BooleanValue(*operand1 > *operand2);
+              break;
+            case OP_LESS_EQUALS:
+              ret = new BooleanValue(*operand1 <= *operand2);
+              break;
+            case OP_GREATER_EQUALS:
+              ret = new BooleanValue(*operand1 >= *operand2);
+              break;
+          }
+          ret->setLocation(value[n.token]);
+        }
+      } catch (...) {
+        delete operand1;
+        delete operand2;
+        throw;
+      }
+      delete operand1;
+      delete operand2;
+      return ret;
+  }
+  return NULL;
+}
+
+bool ValueProcessor::evaluateValue(const ValueExpression &expression,
+                                   const TokenList &value,
+                                   TokenList &result,
+                                   const ValueScope &scope) const {
+  std::vector<ValueExpression::Segment>::const_iterator it;
+  const Token *first;
+  const TokenList *var, *tokens;
+  Value *v;
+
+  for (it = expression.segments.begin(); it != expression.segments.end();
+       it++) {
+    v = NULL;
+    var = NULL;
+
+    if ((*it).type == ValueExpression::STATEMENT) {
+      if ((v = evaluate(expression, (*it).node, value, scope, false)) == NULL)
+        return false;
+      first = NULL;
+
+    } else if ((*it).type == ValueExpression::VARIABLE_STATEMENT) {
+      first = &value[expression.nodes[(*it).node].token];
+      if ((var = scope.getVariable(*first)) != NULL)
+        v = processVariable(*var, scope);
+
+    } else
+      first = &value[(*it).begin];
+
+    // add spaces between values
+    if (!result.empty() && needsSpace(result.back(), false) &&
+        (v != NULL || needsSpace(*first, true)))
+      result.push_back(Token::BUILTIN_SPACE);
+
+    if (v != NULL) {
+      tokens = v->getTokens();
+      result.insert(result.end(), tokens->begin(), tokens->end());
+      delete v;
+
+    } else if ((*it).type == ValueExpression::VARIABLE_STATEMENT) {
+      // variable containing a non-value.
+      if (var != NULL)
+        appendVariable(*var, result, scope);
+      else
+        result.push_back(*first);
+
+    } else {
+      result.insert(result.end(),
+                    value.begin() + (*it).begin,
+                    value.begin() + (*it).end);
+    }
+  }
+  return true;
+}
+
+bool ValueProcessor::evaluateCondition(const ValueExpression &expression,
+                                       const TokenList &value,
+                                       const ValueScope &scope,
+                                       bool defaultVal,
+                                       bool &result) const {
+  std::vector<size_t>::const_iterator it;
+  const BooleanValue trueVal(true);
+  Value *v;
+  bool ret = true;
+
+  for (it = expression.conditions.begin();
+       ret == true && it != expression.conditions.end();
+       it++) {
+    if (*it == ValueExpression::NONE) {
+      ret = false;
+    } else {
+      if ((v = evaluate(expression, *it, value, scope, defaultVal)) == NULL)
+        return false;
+      ret = (*v == trueVal);
+      delete v;
+    }
+  }
+
+  result = expression.negate ? !ret : ret;
+  return true;
+}
+
 void ValueProcessor::interpolate(std::string &str,
                                  const ValueScope &scope) const {
   size_t start, end = 0;
@@ -782,6 +1602,19 @@ void ValueProcessor::interpolate(std::string &str,
   }
 }
 
+void ValueProcessor::interpolate(Token &token,
+                                 const ValueScope &scope) const {
+  std::string str;
+
+  if (token.find("@{") == string::npos)
+    return;
+
+  // Assign the result so the token drops its atom.
+  str = token;
+  interpolate(str, scope);
+  token.assign(str);
+}
+
 void ValueProcessor::interpolate(TokenList &tokens,
                                  const ValueScope &scope) const {
   TokenList::iterator i;
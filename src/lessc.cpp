@@ -3,11 +3,21 @@
 #include <string>
 #include <sstream>
 #include <getopt.h>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <thread>
+#include <climits>
+#include <unistd.h>
 
+#include <less/css/SourceBuffer.h>
 #include <less/less/LessTokenizer.h>
 #include <less/less/LessParser.h>
+#include <less/less/ImportPipeline.h>
+#include <less/less/DependencyScanner.h>
+#include <less/less/ConstantFolder.h>
+#include <less/CompileCache.h>
+#include <less/css/CssParser.h>
 #include <less/css/CssWriter.h>
 #include <less/css/CssPrettyWriter.h>
 #include <less/stylesheet/Stylesheet.h>
@@ -50,6 +60,24 @@ imported .less files.\n"
 file.\n"
     "   -l, --lint                      Don't generate output. Just display \
 parse errors.\n"
+    "   -j, --jobs=<N>                  Parse imported files on N threads. \
+Defaults to the number of processors.\n"
+    "       --split-input[=<KB>]        Split a source of at least twice \
+KB kilobytes into chunks that are parsed on the threads of --jobs. KB \
+defaults to 256.\n"
+    "       --cache-dir=<DIR>           Keep parsed imported files in DIR \
+and reuse them in later runs.\n"
+    "       --emit-snapshot=<FILE>      Write the parsed source to FILE \
+instead of compiling it.\n"
+    "       --snapshot=<FILE>           Load a snapshot written with \
+--emit-snapshot before parsing the source, as if it was imported first.\n"
+    "       --compile-cache=<DIR>       Keep the output in DIR and reuse \
+it while the source, the files it imports and the options are unchanged.\n"
+    "       --plain-css                 Read the source as plain CSS and \
+write each statement as soon as it is parsed, in constant memory.\n"
+    "       --fold-constants            Evaluate declaration values that \
+do not use variables once after parsing, instead of each time their \
+ruleset or mixin is used.\n"
     "\n"
     "Example:\n"
     "   lessc in.less -o out.css\n"
@@ -130,33 +158,108 @@ char* path_create_relative(const char* path, const char* relative) {
 }
 
 bool parseInput(LessStylesheet &stylesheet,
-                istream &in,
+                SourceBuffer *in,
                 const char* source,
-                std::list<const char*> &sources,
-                std::list<const char*> &includePaths) {
-  std::list<const char*>::iterator i;
-  
+                SourceSet &sources,
+                std::list<const char*> &includePaths,
+                unsigned int jobs,
+                size_t split_size,
+                const char* cache_dir,
+                const char* snapshot) {
   LessTokenizer tokenizer(in, source);
   LessParser parser(tokenizer, sources);
+  ImportResolver resolver(&includePaths);
+  ImportPipeline* pipeline = NULL;
+  StylesheetCache* cache = NULL;
+  bool ret = true;
+
+  sources.add(tokenizer.getSourceId());
   parser.includePaths = &includePaths;
+  parser.resolver = &resolver;
+  parser.splitSize = split_size;
+
+  if (cache_dir != NULL)
+    cache = new StylesheetCache(cache_dir);
+
+  if (jobs > 1 || cache != NULL) {
+    pipeline = new ImportPipeline(resolver, jobs > 1 ? jobs : 0, cache);
+    parser.pipeline = pipeline;
+  }
   
   try{
+    if (snapshot != NULL)
+      StylesheetCache::readSnapshot(snapshot, stylesheet, sources);
     parser.parseStylesheet(stylesheet);
   } catch(ParseException* e) {
 
     cerr << e->getSource() << ": Line " << e->getLineNumber() << ", Column " << 
       e->getColumn() << " Parse Error: " << e->what() << endl;
     
-    return false;
+    ret = false;
   } catch(exception* e) {
     cerr << " Error: " << e->what() << endl;
 
+    ret = false;
+  }
+
+  if (pipeline != NULL)
+    delete pipeline;
+  if (cache != NULL)
+    delete cache;
+  return ret;
+}
+
+/**
+ * Find the files that the source imports without parsing it, for
+ * --depends.
+ */
+bool scanInput(SourceBuffer *in,
+               const char* source,
+               SourceSet &sources,
+               std::list<const char*> &includePaths,
+               const char* snapshot) {
+  LessTokenizer tokenizer(in, source);
+  ImportResolver resolver(&includePaths);
+  DependencyScanner scanner(resolver, sources);
+  LessStylesheet library;
+
+  sources.add(tokenizer.getSourceId());
+
+  try {
+    if (snapshot != NULL)
+      StylesheetCache::readSnapshot(snapshot, library, sources);
+    scanner.scan(tokenizer);
+  } catch(ParseException* e) {
+    cerr << e->getSource() << ": Line " << e->getLineNumber() << ", Column " << 
+      e->getColumn() << " Parse Error: " << e->what() << endl;
+    return false;
+  } catch(exception* e) {
+    cerr << " Error: " << e->what() << endl;
     return false;
   }
-  
   return true;
 }
 
+/**
+ * Write the parsed stylesheet to a snapshot, for --emit-snapshot.
+ * Reference rulesets that were skipped are parsed now, so their errors
+ * are reported here.
+ */
+bool emitSnapshot(const char* filename,
+                  const LessStylesheet &stylesheet,
+                  const SourceSet &sources) {
+  try {
+    if (StylesheetCache::writeSnapshot(filename, stylesheet, sources))
+      return true;
+    cerr << "Error writing snapshot." << endl;
+
+  } catch(ParseException* e) {
+    cerr << e->getSource() << ": Line " << e->getLineNumber() << ", Column " << 
+      e->getColumn() << " Parse Error: " << e->what() << endl;
+  }
+  return false;
+}
+
 bool processStylesheet (const LessStylesheet &stylesheet,
                         Stylesheet &css) {
   ProcessingContext context;
@@ -184,58 +287,69 @@ bool processStylesheet (const LessStylesheet &stylesheet,
   return true;
 }
 
-void writeOutput(Stylesheet &css,
-                 const char* output,
-                 bool formatoutput,
-                 const char* rootpath,
-                 std::list<const char*> &sources,
-                 const char* sourcemap_file,
-                 const char* sourcemap_rootpath,
-                 const char* sourcemap_basepath,
-                 const char* sourcemap_url) {
-  ostream* out = &cout;
+/**
+ * Create the writer for the output, and a source map writer when
+ * sourcemap_file is set.
+ */
+CssWriter* createWriter(ostream &out,
+                        ostream *sourcemap_s,
+                        SourceMapWriter* &sourcemap,
+                        const char* output,
+                        bool formatoutput,
+                        const char* rootpath,
+                        const SourceSet &sources,
+                        const char* sourcemap_file,
+                        const char* sourcemap_rootpath,
+                        const char* sourcemap_basepath) {
   CssWriter* writer;
-  ostream* sourcemap_s = NULL;
-  SourceMapWriter* sourcemap = NULL;
 
   std::list<const char*> relative_sources;
-  std::list<const char*>::iterator it;
-  size_t bp_l = 0;
+  const char* source;
+  size_t i, bp_l = 0;
+
+  sourcemap = NULL;
 
   if (sourcemap_basepath != NULL)
     bp_l = strlen(sourcemap_basepath);
   
-  if (strcmp(output, "-") != 0) 
-    out = new ofstream(output);
-
   if (sourcemap_file != NULL) {
-    for (it = sources.begin(); it != sources.end(); it++) {
+    for (i = 0; i < sources.size(); i++) {
+      source = sources.getName(i);
       if (sourcemap_basepath == NULL) {
-        relative_sources.push_back(path_create_relative(*it, sourcemap_file));
-      } else if (strncmp(*it, sourcemap_basepath, bp_l) == 0) {
-        relative_sources.push_back(*it + bp_l);
+        relative_sources.push_back(path_create_relative(source, sourcemap_file));
+      } else if (strncmp(source, sourcemap_basepath, bp_l) == 0) {
+        relative_sources.push_back(source + bp_l);
       } else {
-        relative_sources.push_back(*it);
+        relative_sources.push_back(source);
       }
     }
     
-    sourcemap_s = new ofstream(sourcemap_file);
     sourcemap = new SourceMapWriter(*sourcemap_s,
                                     sources,
                                     relative_sources,
                                     path_create_relative(output, sourcemap_file),
                                     sourcemap_rootpath);
 
-    writer = formatoutput ? new CssPrettyWriter(*out, *sourcemap) :
-      new CssWriter(*out, *sourcemap);
+    writer = formatoutput ? new CssPrettyWriter(out, *sourcemap) :
+      new CssWriter(out, *sourcemap);
   } else {
-    writer = formatoutput ? new CssPrettyWriter(*out) :
-      new CssWriter(*out);
+    writer = formatoutput ? new CssPrettyWriter(out) :
+      new CssWriter(out);
   }
   writer->rootpath = rootpath;
-      
-  css.write(*writer);
-      
+  return writer;
+}
+
+/**
+ * Finish the output started with createWriter() and delete the
+ * writers.
+ */
+void closeWriter(CssWriter* writer,
+                 SourceMapWriter* sourcemap,
+                 ostream &out,
+                 const char* output,
+                 const char* sourcemap_file,
+                 const char* sourcemap_url) {
   if (sourcemap != NULL) {
     if (sourcemap_url != NULL)
       writer->writeSourceMapUrl(sourcemap_url);
@@ -244,37 +358,180 @@ void writeOutput(Stylesheet &css,
     
     sourcemap->close();
     delete sourcemap;
-    if (sourcemap_s != NULL)
-      delete sourcemap_s;
   }
       
   delete writer;
-  *out << endl;
+  out << endl;
+}
+
+void writeOutput(Stylesheet &css,
+                 ostream &out,
+                 ostream *sourcemap_s,
+                 const char* output,
+                 bool formatoutput,
+                 const char* rootpath,
+                 const SourceSet &sources,
+                 const char* sourcemap_file,
+                 const char* sourcemap_rootpath,
+                 const char* sourcemap_basepath,
+                 const char* sourcemap_url) {
+  SourceMapWriter* sourcemap;
+  CssWriter* writer = createWriter(out, sourcemap_s, sourcemap, output,
+                                   formatoutput, rootpath, sources,
+                                   sourcemap_file, sourcemap_rootpath,
+                                   sourcemap_basepath);
+      
+  css.write(*writer);
+
+  closeWriter(writer, sourcemap, out, output, sourcemap_file,
+              sourcemap_url);
+}
+
+/**
+ * Parse the source as plain CSS and write each statement as soon as
+ * it is parsed, for --plain-css. The output and the source map are
+ * written straight to their files.
+ */
+bool streamOutput(SourceBuffer *in,
+                  const char* source,
+                  SourceSet &sources,
+                  const char* output,
+                  bool formatoutput,
+                  bool lint,
+                  const char* rootpath,
+                  const char* sourcemap_file,
+                  const char* sourcemap_rootpath,
+                  const char* sourcemap_basepath,
+                  const char* sourcemap_url) {
+  CssTokenizer tokenizer(in, source);
+  CssParser parser(tokenizer);
+  ofstream out_f, sourcemap_f;
+  ostringstream discard;
+  ostream* out = &cout;
+  CssWriter* writer;
+  SourceMapWriter* sourcemap;
+  bool ret = true;
+
+  sources.add(tokenizer.getSourceId());
+
+  if (lint) {
+    out = &discard;
+    sourcemap_file = NULL;
+  } else if (strcmp(output, "-") != 0) {
+    out_f.open(output, ios::binary);
+    out = &out_f;
+  }
+  if (sourcemap_file != NULL)
+    sourcemap_f.open(sourcemap_file, ios::binary);
+
+  writer = createWriter(*out, &sourcemap_f, sourcemap, output, formatoutput,
+                        rootpath, sources, sourcemap_file,
+                        sourcemap_rootpath, sourcemap_basepath);
+
+  try {
+    parser.streamStylesheet(*writer);
+  } catch(ParseException* e) {
+    cerr << e->getSource() << ": Line " << e->getLineNumber() << ", Column " << 
+      e->getColumn() << " Parse Error: " << e->what() << endl;
+    ret = false;
+  } catch(exception* e) {
+    cerr << " Error: " << e->what() << endl;
+    ret = false;
+  }
+
+  closeWriter(writer, sourcemap, *out, output, sourcemap_file,
+              sourcemap_url);
+  return ret;
+}
+
+/**
+ * Write content to a file, or to stdout if the file name is "-".
+ */
+void writeFile(const char* filename, const std::string &content) {
+  if (strcmp(filename, "-") == 0) {
+    cout << content;
+  } else {
+    ofstream out(filename, ios::binary);
+    out << content;
+  }
+}
+
+/**
+ * Passes everything written to it on to another buffer, and keeps a
+ * copy.
+ */
+class TeeBuffer : public std::streambuf {
+public:
+  std::string copy;
+
+  TeeBuffer(std::streambuf *target) : target(target) {
+  }
+
+protected:
+  virtual int overflow(int c) {
+    if (c == EOF)
+      return target->pubsync() == 0 ? 0 : EOF;
+    copy.push_back((char)c);
+    return target->sputc((char)c);
+  }
+
+  virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+    copy.append(s, n);
+    return target->sputn(s, n);
+  }
+
+  virtual int sync() {
+    return target->pubsync();
+  }
+
+private:
+  std::streambuf *target;
+};
+
+/**
+ * Everything besides the content of the files that affects the
+ * output: the working directory and the command line.
+ */
+std::string compileCacheKey(int argc, char * argv[]) {
+  std::string key;
+  char cwd[PATH_MAX];
+  int i;
+
+  if (getcwd(cwd, sizeof(cwd)) != NULL)
+    key = cwd;
+  for (i = 0; i < argc; i++) {
+    key.push_back('\0');
+    key.append(argv[i]);
+  }
+  return key;
 }
 
-void writeDependencies(const char* output, const std::list<const char*> &sources) {
-  std::list<const char *>::const_iterator i;
+void writeDependencies(const char* output, const SourceSet &sources) {
+  size_t i;
 
   cout << output << ":";
 
-  for (i = sources.begin(); i != sources.end(); i++) {
+  for (i = 0; i < sources.size(); i++) {
     cout << " ";
-    cout << (*i);
+    cout << sources.getName(i);
     cout << "\\\n";
   }
   cout << endl;
 }
 
 int main(int argc, char * argv[]){
-  istream* in = &cin;
+  SourceBuffer* in = NULL;
   bool formatoutput = false;
   char* source = NULL;
   const char* output = "-";
   LessStylesheet stylesheet;
-  std::list<const char*> sources;
+  SourceSet sources;
   Stylesheet css;
-  bool depends = false, lint = false;
+  bool depends = false, lint = false, plain_css = false;
+  bool fold_constants = false;
   char* tmp;
+  unsigned int jobs = std::thread::hardware_concurrency();
+  size_t split_size = 0;
 
   const char* sourcemap_file = NULL;
 
@@ -282,6 +539,16 @@ int main(int argc, char * argv[]){
   const char* sourcemap_basepath = NULL;
   const char* sourcemap_url = NULL;
   const char* rootpath = NULL;
+  const char* cache_dir = NULL;
+  const char* emit_snapshot = NULL;
+  const char* snapshot = NULL;
+  const char* compile_cache = NULL;
+  CompileCache* cache = NULL;
+  TeeBuffer* messages = NULL;
+  std::string cached_css, cached_sourcemap, cached_messages;
+  std::ostringstream css_s, sourcemap_s;
+  ofstream out_f, sourcemap_f;
+  ostream* out = &cout;
 
   std::list<const char*> includePaths;
 
@@ -298,6 +565,14 @@ int main(int argc, char * argv[]){
     {"rootpath",            required_argument, 0, 4},
     {"depends",             no_argument,       0, 'M'},
     {"lint",                no_argument,       0, 'l'},
+    {"jobs",                required_argument, 0, 'j'},
+    {"cache-dir",           required_argument, 0, 6},
+    {"emit-snapshot",       required_argument, 0, 7},
+    {"snapshot",            required_argument, 0, 8},
+    {"compile-cache",       required_argument, 0, 9},
+    {"split-input",         optional_argument, 0, 10},
+    {"plain-css",           no_argument,       0, 11},
+    {"fold-constants",      no_argument,       0, 12},
     {0,0,0,0}
   };
 
@@ -305,7 +580,7 @@ int main(int argc, char * argv[]){
   try {
     int c, option_index;
 
-    while((c = getopt_long(argc, argv, ":o:hfv:m::I:Ml", long_options, &option_index)) != -1) {
+    while((c = getopt_long(argc, argv, ":o:hfv:m::I:Mlj:", long_options, &option_index)) != -1) {
       switch (c) {
       case 1:
         version();
@@ -357,6 +632,38 @@ int main(int argc, char * argv[]){
       case 'l':
         lint = true;
         break;
+
+      case 6:
+        cache_dir = optarg;
+        break;
+
+      case 7:
+        emit_snapshot = optarg;
+        break;
+
+      case 8:
+        snapshot = optarg;
+        break;
+
+      case 9:
+        compile_cache = optarg;
+        break;
+
+      case 10:
+        split_size = (optarg ? std::strtoul(optarg, NULL, 10) : 256) * 1024;
+        break;
+
+      case 11:
+        plain_css = true;
+        break;
+
+      case 12:
+        fold_constants = true;
+        break;
+
+      case 'j':
+        jobs = std::strtoul(optarg, NULL, 10);
+        break;
         
       default:
         cerr << "Unrecognized option. " << endl;
@@ -371,8 +678,8 @@ int main(int argc, char * argv[]){
       source = new char[std::strlen(argv[optind]) + 1];
       std::strcpy(source, argv[optind]);
       
-      in = new ifstream(source);
-      if (in->fail() || in->bad()) {
+      in = new SourceBuffer();
+      if (!in->open(source)) {
         cerr << "Error opening file." << endl;
         return EXIT_FAILURE;
       }
@@ -380,7 +687,8 @@ int main(int argc, char * argv[]){
       
       source = new char[2];
       std::strcpy(source, "-");
-      
+
+      in = new SourceBuffer(cin);
     }
     
     if (sourcemap_file != NULL && strcmp(sourcemap_file, "-") == 0) {
@@ -396,32 +704,104 @@ output file." << endl;
       }
     }
     
-    sources.push_back(source);
-    
-    if (parseInput(stylesheet, *in, source, sources, includePaths)) {
-      if (depends) {
-        writeDependencies(output, sources);
+    if (plain_css && !depends && emit_snapshot == NULL) {
+      if (!streamOutput(in, source, sources, output, formatoutput, lint,
+                        rootpath, sourcemap_file, sourcemap_rootpath,
+                        sourcemap_basepath, sourcemap_url))
+        return EXIT_FAILURE;
+      return EXIT_SUCCESS;
+    }
+
+    if (depends && emit_snapshot == NULL) {
+      if (!scanInput(in, source, sources, includePaths, snapshot))
+        return EXIT_FAILURE;
+      writeDependencies(output, sources);
+      return EXIT_SUCCESS;
+    }
+
+    if (compile_cache != NULL && !lint && emit_snapshot == NULL) {
+      while (in->fill()) {
+      }
+      cache = new CompileCache(compile_cache, compileCacheKey(argc, argv), *in);
+
+      if (cache->load(cached_css, cached_sourcemap, cached_messages)) {
+        cerr << cached_messages;
+        writeFile(output, cached_css);
+        if (sourcemap_file != NULL)
+          writeFile(sourcemap_file, cached_sourcemap);
         return EXIT_SUCCESS;
       }
 
+      // Keep what is printed during the compilation, to print it again
+      // when the output is taken from the cache. The buffer is never
+      // deleted, as cerr may still use it when the program exits.
+      messages = new TeeBuffer(cerr.rdbuf());
+      cerr.rdbuf(messages);
+    }
+
+    if (parseInput(stylesheet, in, source, sources, includePaths, jobs,
+                   split_size, cache_dir, snapshot)) {
+      if (emit_snapshot != NULL) {
+        if (!emitSnapshot(emit_snapshot, stylesheet, sources))
+          return EXIT_FAILURE;
+        return EXIT_SUCCESS;
+      }
+
+      if (fold_constants) {
+        ConstantFolder folder;
+        folder.fold(stylesheet);
+      }
+
       if (!processStylesheet(stylesheet, css))
         return EXIT_FAILURE;
      
       if (lint) 
         return EXIT_SUCCESS;
      
-      writeOutput(css,
-                  output,
-                  formatoutput,
-                  rootpath,
-                  sources,
-                  sourcemap_file,
-                  sourcemap_rootpath,
-                  sourcemap_basepath,
-                  sourcemap_url);
+      // Only a compilation that is stored in the cache is kept in
+      // memory, the output is otherwise written as it is generated.
+      if (cache == NULL) {
+        if (strcmp(output, "-") != 0) {
+          out_f.open(output, ios::binary);
+          out = &out_f;
+        }
+        if (sourcemap_file != NULL)
+          sourcemap_f.open(sourcemap_file, ios::binary);
+
+        writeOutput(css,
+                    *out,
+                    &sourcemap_f,
+                    output,
+                    formatoutput,
+                    rootpath,
+                    sources,
+                    sourcemap_file,
+                    sourcemap_rootpath,
+                    sourcemap_basepath,
+                    sourcemap_url);
+      } else {
+        writeOutput(css,
+                    css_s,
+                    &sourcemap_s,
+                    output,
+                    formatoutput,
+                    rootpath,
+                    sources,
+                    sourcemap_file,
+                    sourcemap_rootpath,
+                    sourcemap_basepath,
+                    sourcemap_url);
+
+        cached_css = css_s.str();
+        writeFile(output, cached_css);
+        if (sourcemap_file != NULL) {
+          cached_sourcemap = sourcemap_s.str();
+          writeFile(sourcemap_file, cached_sourcemap);
+        }
+        cache->store(sources, cached_css, cached_sourcemap, messages->copy);
+      }
     } else
       return EXIT_FAILURE;
-    delete [] source;
     
   } catch (IOException* e) {
     cerr << " Error: " << e->what() << endl;
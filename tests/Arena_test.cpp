@@ -0,0 +1,56 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <less/Arena.h>
+
+class Tracked {
+public:
+  std::vector<int>* log;
+  int id;
+  std::string padding;
+
+  Tracked(std::vector<int>* log, int id)
+      : log(log), id(id), padding(100, 'x') {
+  }
+  ~Tracked() {
+    log->push_back(id);
+  }
+};
+
+TEST(ArenaTest, Allocate) {
+  Arena arena;
+  char* c = static_cast<char*>(arena.allocate(1, 1));
+  double* d = static_cast<double*>(arena.allocate(sizeof(double),
+                                                  alignof(double)));
+  void* big = arena.allocate(Arena::INITIAL_BLOCK_SIZE * 3);
+
+  *c = 'a';
+  *d = 1.5;
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(d) % alignof(double));
+  EXPECT_NE(nullptr, big);
+  EXPECT_GE(arena.getBytesAllocated(), Arena::INITIAL_BLOCK_SIZE * 4);
+
+  arena.release();
+  EXPECT_EQ(0u, arena.getBytesAllocated());
+  EXPECT_NE(nullptr, arena.allocate(16));
+}
+
+/**
+ * Objects are destroyed newest first when the arena is released.
+ */
+TEST(ArenaTest, Destroy) {
+  std::vector<int> log;
+  int i;
+
+  {
+    Arena arena;
+    for (i = 0; i < 100; i++)
+      EXPECT_EQ(i, arena.create<Tracked>(&log, i)->id);
+    EXPECT_EQ(1, *arena.create<int>(1));
+    EXPECT_TRUE(log.empty());
+  }
+
+  ASSERT_EQ(100u, log.size());
+  EXPECT_EQ(99, log.front());
+  EXPECT_EQ(0, log.back());
+}
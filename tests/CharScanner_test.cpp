@@ -0,0 +1,120 @@
+#include <cstring>
+#include <string>
+#include <gtest/gtest.h>
+#include <less/css/CharScanner.h>
+
+/**
+ * Compares the vector implementations of CharScanner with the scalar
+ * one. Each input is longer than two AVX2 vectors, starts at several
+ * alignments and has a stop character at every offset from 0 to 63,
+ * between run characters that include bytes >= 0x80.
+ */
+class CharScannerTest : public ::testing::Test {
+public:
+  static const size_t LENGTH = 100;
+
+  const char* original;
+  char buffer[LENGTH + 32];
+
+  virtual void SetUp() {
+    original = CharScanner::getImplementation();
+  }
+  virtual void TearDown() {
+    CharScanner::setImplementation(original);
+  }
+
+  /**
+   * Fill the buffer at align with run characters, put stop at offset,
+   * or nowhere if offset is LENGTH, and scan it with function using the
+   * implementation impl and the scalar one.
+   */
+  template <typename F>
+  void compare(const char* impl,
+               F function,
+               const std::string& run,
+               char stop,
+               size_t align,
+               size_t offset,
+               size_t seed) {
+    char* p = buffer + align;
+    const char *expected, *actual;
+    size_t i;
+
+    for (i = 0; i < LENGTH; i++)
+      p[i] = run[(i + seed) % run.size()];
+    if (offset < LENGTH)
+      p[offset] = stop;
+
+    ASSERT_TRUE(CharScanner::setImplementation("scalar"));
+    expected = function(p, p + LENGTH);
+    ASSERT_EQ(offset, (size_t)(expected - p));
+
+    ASSERT_TRUE(CharScanner::setImplementation(impl));
+    actual = function(p, p + LENGTH);
+    ASSERT_EQ(expected - p, actual - p)
+        << impl << ": stop " << (int)(unsigned char)stop << " at offset "
+        << offset << ", alignment " << align << ", seed " << seed;
+  }
+
+  template <typename F>
+  void compareAll(F function, const std::string& run, const std::string& stops) {
+    const char* impls[] = {"avx2", "sse2"};
+    const size_t aligns[] = {0, 1, 7, 16, 31};
+    size_t i, a, offset, seed, s;
+
+    for (i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+      if (!CharScanner::setImplementation(impls[i]))
+        continue;
+
+      for (a = 0; a < sizeof(aligns) / sizeof(aligns[0]); a++) {
+        for (seed = 0; seed < run.size(); seed++) {
+          compare(impls[i], function, run, 0, aligns[a], LENGTH, seed);
+
+          for (s = 0; s < stops.size(); s++) {
+            for (offset = 0; offset < 64; offset++) {
+              compare(impls[i], function, run, stops[s], aligns[a], offset,
+                      seed);
+              if (HasFatalFailure())
+                return;
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+const size_t CharScannerTest::LENGTH;
+
+TEST_F(CharScannerTest, SkipName) {
+  // The neighbours of the ranges, and bytes >= 0x80 that are the
+  // range bounds with the high bit set.
+  compareAll(CharScanner::skipName,
+             std::string("aZz0_-9A\x80\xC3\xE1\xFA\xFF\xB0", 14),
+             std::string(" \\{@/:`[\x7F.\t\x01", 12) + std::string(1, '\0'));
+}
+
+TEST_F(CharScannerTest, SkipWhitespace) {
+  compareAll(CharScanner::skipWhitespace,
+             " \t\r\n\f",
+             std::string("a\x0B\x80\xA0\x8A\x89\xFF", 7) +
+                 std::string(1, '\0'));
+}
+
+TEST_F(CharScannerTest, FindStringEnd) {
+  struct DoubleQuote {
+    const char* operator()(const char* p, const char* end) const {
+      return CharScanner::findStringEnd(p, end, '"');
+    }
+  };
+  struct SingleQuote {
+    const char* operator()(const char* p, const char* end) const {
+      return CharScanner::findStringEnd(p, end, '\'');
+    }
+  };
+  const std::string run("a '\x80\xA2\xDC\x8A\xFF\t", 9);
+
+  compareAll(DoubleQuote(), run, "\"\\\n\r\f");
+  compareAll(SingleQuote(), std::string("a \"\x80\xA7\xDC\x8D\xFF\t", 9),
+             "'\\\n\r\f");
+}
@@ -0,0 +1,99 @@
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <less/CompileCache.h>
+#include <less/SourceRegistry.h>
+
+class CompileCacheTest : public ::testing::Test {
+public:
+  const char* directory;
+  const char* imported;
+  SourceBuffer* entry;
+  SourceSet sources;
+
+  virtual void SetUp() {
+    std::istringstream in("@import \"CompileCache_test.less\";");
+    SourceBuffer* content = new SourceBuffer();
+
+    directory = "CompileCache_test.dir";
+    imported = "CompileCache_test.less";
+
+    entry = new SourceBuffer(in);
+    while (entry->fill()) {
+    }
+    sources.add(SourceRegistry::add("-", entry));
+
+    std::ofstream(imported) << "a { b: c; }";
+    ASSERT_TRUE(content->open(imported));
+    sources.add(SourceRegistry::add(imported, content));
+  }
+
+  virtual void TearDown() {
+    DIR* dir = opendir(directory);
+    struct dirent* e;
+    std::string name;
+
+    while (dir != NULL && (e = readdir(dir)) != NULL) {
+      name = std::string(directory) + "/" + e->d_name;
+      if (e->d_name[0] != '.')
+        std::remove(name.c_str());
+    }
+    if (dir != NULL)
+      closedir(dir);
+    rmdir(directory);
+    std::remove(imported);
+  }
+};
+
+TEST_F(CompileCacheTest, Hit) {
+  CompileCache cache(directory, "options", *entry);
+  std::string css, sourcemap, messages;
+
+  EXPECT_FALSE(cache.load(css, sourcemap, messages));
+  cache.store(sources, "a{b:c}\n", "{}", "warning\n");
+
+  CompileCache later(directory, "options", *entry);
+  ASSERT_TRUE(later.load(css, sourcemap, messages));
+  EXPECT_EQ("a{b:c}\n", css);
+  EXPECT_EQ("{}", sourcemap);
+  EXPECT_EQ("warning\n", messages);
+
+  CompileCache other(directory, "other options", *entry);
+  EXPECT_FALSE(other.load(css, sourcemap, messages));
+}
+
+/**
+ * A file that was written during the compilation is hashed, so a
+ * change that keeps its size and time is noticed.
+ */
+TEST_F(CompileCacheTest, ChangedFile) {
+  CompileCache cache(directory, "options", *entry);
+  std::string css, sourcemap, messages;
+
+  cache.store(sources, "a{b:c}\n", "", "");
+  ASSERT_TRUE(cache.load(css, sourcemap, messages));
+
+  std::ofstream(imported) << "a { b: d; }";
+  EXPECT_FALSE(cache.load(css, sourcemap, messages));
+
+  std::remove(imported);
+  EXPECT_FALSE(cache.load(css, sourcemap, messages));
+}
+
+/**
+ * An entry is only named by a hash, so one that another compilation
+ * left under the same name is not used.
+ */
+TEST_F(CompileCacheTest, Collision) {
+  CompileCache cache(directory, "options", *entry);
+  CompileCache other(directory, "other options", *entry);
+  std::string css, sourcemap, messages;
+
+  cache.store(sources, "a{b:c}\n", "", "");
+  ASSERT_EQ(0, std::rename(cache.getEntry().c_str(),
+                           other.getEntry().c_str()));
+  EXPECT_FALSE(other.load(css, sourcemap, messages));
+}
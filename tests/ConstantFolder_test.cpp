@@ -0,0 +1,101 @@
+#include <sstream>
+#include <gtest/gtest.h>
+#include <less/css/ParseException.h>
+#include <less/less/ConstantFolder.h>
+#include <less/less/LessParser.h>
+
+class ConstantFolderTest : public ::testing::Test {
+public:
+  SourceSet sources;
+  LessStylesheet less;
+  ConstantFolder folder;
+
+  void parse(const char* source) {
+    std::istringstream in(source);
+    LessTokenizer tokenizer(in, "test");
+    LessParser parser(tokenizer, sources);
+
+    parser.parseStylesheet(less);
+  }
+
+  std::string compile() {
+    Stylesheet css;
+    ProcessingContext context;
+    std::ostringstream out;
+    CssWriter writer(out);
+
+    less.process(css, &context);
+    css.write(writer);
+    return out.str();
+  }
+
+  const LessDeclaration* declaration(size_t n) {
+    const LessRuleset* ruleset =
+      dynamic_cast<const LessRuleset*>(less.getStatements().front());
+    std::list<LessDeclaration*>::const_iterator it =
+      ruleset->getLessDeclarations().begin();
+
+    std::advance(it, n);
+    return *it;
+  }
+};
+
+TEST_F(ConstantFolderTest, Fold) {
+  parse(".a { width: (960px / 12) * 3; color: darken(#336699, 10%); }");
+  folder.fold(less);
+
+  EXPECT_TRUE(declaration(0)->isFolded());
+  EXPECT_EQ("240px", declaration(0)->getValue().toString());
+  EXPECT_TRUE(declaration(1)->isFolded());
+  EXPECT_EQ("#264d73", declaration(1)->getValue().toString());
+  EXPECT_EQ(".a{width:240px;color:#264d73}", compile());
+}
+
+/**
+ * Variables, interpolated strings, urls, image functions and default()
+ * are evaluated when the ruleset is processed.
+ */
+TEST_F(ConstantFolderTest, Unfoldable) {
+  parse(".a { \
+a: @x * 2; \
+b: ~\"@{x}px\"; \
+c: url(a.png); \
+d: image-width(\"a.png\"); \
+e: default(); \
+f: @@y; }");
+  folder.fold(less);
+
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_FALSE(declaration(i)->isFolded()) << i;
+  }
+}
+
+TEST_F(ConstantFolderTest, Mixin) {
+  parse(".m(@a) { w: @a; h: 2px + 3px; } .a { .m(1px); } .b { .m(2px); }");
+  folder.fold(less);
+
+  EXPECT_FALSE(declaration(0)->isFolded());
+  EXPECT_TRUE(declaration(1)->isFolded());
+  EXPECT_EQ(".a{w:1px;h:5px}.b{w:2px;h:5px}", compile());
+}
+
+/**
+ * A value that fails to evaluate is left for the ruleset to report, so
+ * a mixin that is not used has no error.
+ */
+TEST_F(ConstantFolderTest, Error) {
+  parse(".m() { w: darken(1px, 2); } .a { w: darken(1px, 2); }");
+  folder.fold(less);
+
+  EXPECT_FALSE(declaration(0)->isFolded());
+  EXPECT_THROW(compile(), ParseException*);
+}
+
+TEST_F(ConstantFolderTest, Nested) {
+  parse(".a { .b { w: 1 + 1; } @media print { h: 2 * 2; } } \
+@media screen { .c { x: 3 - 1; } }");
+  folder.fold(less);
+
+  EXPECT_EQ(".a .b{w:2}@media print{.a{h:4}}@media screen{.c{x:2}}",
+            compile());
+}
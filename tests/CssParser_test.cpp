@@ -123,3 +123,23 @@ TEST_F(CssParserTest, BlockValue) {
   ASSERT_STREQ("key", d->getProperty().c_str());
   ASSERT_STREQ("{value}", d->getValue().toString().c_str());
 }
+
+// streaming writes the same output as parsing the whole stylesheet
+TEST_F(CssParserTest, StreamStylesheet) {
+  const char* css =
+    "@import somefile; a {key: value;}; @media screen {b {c: d}} e {f: g}";
+  ostringstream parsed, streamed;
+  CssWriter parsedWriter(parsed), streamedWriter(streamed);
+  Stylesheet s;
+
+  in->str(css);
+  p->parseStylesheet(s);
+  s.write(parsedWriter);
+
+  istringstream in2(css);
+  CssTokenizer t2(in2, "test");
+  CssParser p2(t2);
+  p2.streamStylesheet(streamedWriter);
+
+  ASSERT_STREQ(parsed.str().c_str(), streamed.str().c_str());
+}
@@ -80,12 +80,16 @@ TEST(CssTokenizerTest, String) {
 }
 
 TEST(CssTokenizerTest, URL) {
-  istringstream in("url(../img/img.png) url('http://example.com/image.jpg')");
+  istringstream in("url(../img/img.png) url('http://example.com/image.jpg') "
+                   "url( a!b )");
 
   CssTokenizer t(in, "test");
   EXPECT_EQ(Token::URL, t.readNextToken());
   EXPECT_EQ(Token::WHITESPACE, t.readNextToken());
   EXPECT_EQ(Token::URL, t.readNextToken());
+  EXPECT_EQ(Token::WHITESPACE, t.readNextToken());
+  EXPECT_EQ(Token::URL, t.readNextToken());
+  EXPECT_EQ("url( a!b )", t.getToken());
 }
 
 TEST(CssTokenizerTest, UnicodeRange) {
@@ -152,3 +156,74 @@ TEST(CssTokenizerTest, StringEscape) {
   EXPECT_EQ(Token::STRING, t.readNextToken());
   EXPECT_STREQ("'string\\''", t.getToken().c_str());
 }
+
+/**
+ * Test that tokens spanning the blocks in which streams are read are
+ * not split up.
+ */
+TEST(CssTokenizerTest, BlockBoundary) {
+  std::string comment = "/*" + std::string(SourceBuffer::BLOCK_SIZE, '-') +
+    "*/";
+  istringstream in("a " + comment + " identifier");
+  CssTokenizer t(in, "test");
+
+  EXPECT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(Token::WHITESPACE, t.readNextToken());
+  ASSERT_EQ(Token::COMMENT, t.readNextToken());
+  EXPECT_EQ(comment, t.getToken());
+  EXPECT_EQ(Token::WHITESPACE, t.readNextToken());
+  ASSERT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_STREQ("identifier", t.getToken().c_str());
+  EXPECT_EQ(Token::EOS, t.readNextToken());
+}
+
+/**
+ * Test the line and column of tokens following comments, names and
+ * strings that the tokenizer skips over in one step.
+ */
+TEST(CssTokenizerTest, Location) {
+  istringstream in("a /* x\ny\n */ b\n\tname-with-dashes 'str' c");
+  CssTokenizer t(in, "test");
+
+  while (t.readNextToken() != Token::COMMENT) {
+  }
+  t.readNextToken();
+  ASSERT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(2u, t.getToken().getLine());
+  EXPECT_EQ(4u, t.getToken().getColumn());
+
+  t.readNextToken();
+  ASSERT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(3u, t.getToken().getLine());
+  EXPECT_EQ(1u, t.getToken().getColumn());
+
+  t.readNextToken();
+  ASSERT_EQ(Token::STRING, t.readNextToken());
+  EXPECT_EQ(18u, t.getToken().getColumn());
+
+  t.readNextToken();
+  ASSERT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(3u, t.getToken().getLine());
+  EXPECT_EQ(24u, t.getToken().getColumn());
+  EXPECT_STREQ("test", t.getToken().getSource());
+}
+
+/**
+ * Parse errors are reported at the offset where the tokenizer stopped.
+ */
+TEST(CssTokenizerTest, ParseExceptionLocation) {
+  istringstream in("a\n  'abc");
+  CssTokenizer t(in, "test");
+
+  t.readNextToken();
+  t.readNextToken();
+  try {
+    t.readNextToken();
+    FAIL() << "Expected a ParseException";
+  } catch (ParseException* e) {
+    EXPECT_EQ(1u, e->getLineNumber());
+    EXPECT_EQ(6u, e->getColumn());
+    EXPECT_EQ("test", e->getSource());
+    delete e;
+  }
+}
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <less/css/ParseException.h>
+#include <less/less/DependencyScanner.h>
+
+class DependencyScannerTest : public ::testing::Test {
+public:
+  std::list<const char*> includePaths;
+  SourceSet sources;
+
+  virtual void SetUp() {
+    std::ofstream("DependencyScanner_a.less")
+        << "@import \"DependencyScanner_b\";\n"
+           "a { b: c; }";
+    std::ofstream("DependencyScanner_b.less") << "b { c: d; }";
+    std::ofstream("DependencyScanner_c.less") << "c { d: e; }";
+    std::ofstream("DependencyScanner_d.less") << "d { e: f; }";
+    std::ofstream("DependencyScanner_e.less") << "e { f: g; }";
+    includePaths.push_back("");
+  }
+
+  virtual void TearDown() {
+    std::remove("DependencyScanner_a.less");
+    std::remove("DependencyScanner_b.less");
+    std::remove("DependencyScanner_c.less");
+    std::remove("DependencyScanner_d.less");
+    std::remove("DependencyScanner_e.less");
+  }
+
+  void scan(const char* less) {
+    std::istringstream in(less);
+    LessTokenizer tokenizer(in, "-");
+    ImportResolver resolver(&includePaths);
+    DependencyScanner scanner(resolver, sources);
+
+    sources.add(tokenizer.getSourceId());
+    scanner.scan(tokenizer);
+  }
+};
+
+/**
+ * Imports are followed in the order the parser reads them, through
+ * rulesets and @media but not through the blocks of other at-rules.
+ */
+TEST_F(DependencyScannerTest, Order) {
+  scan(
+      "@{var}-x { @import \"DependencyScanner_c\"; }\n"
+      "@font-face { @import \"DependencyScanner_e\"; }\n"
+      "@media print { @import (less) \"DependencyScanner_a.less\"; }\n"
+      ".m(@a: 1) { @import \"DependencyScanner_d\"; }\n"
+      "@import \"DependencyScanner_b\";\n"
+      "@import \"style.css\";\n"
+      "@import (optional) \"DependencyScanner_missing\";\n"
+      "@import: 1;\n");
+
+  ASSERT_EQ(5u, sources.size());
+  EXPECT_STREQ("DependencyScanner_c.less", sources.getName(1));
+  EXPECT_STREQ("DependencyScanner_a.less", sources.getName(2));
+  EXPECT_STREQ("DependencyScanner_b.less", sources.getName(3));
+  EXPECT_STREQ("DependencyScanner_d.less", sources.getName(4));
+}
+
+TEST_F(DependencyScannerTest, Missing) {
+  EXPECT_THROW(scan("a { @import \"DependencyScanner_missing\"; }"),
+               ParseException*);
+}
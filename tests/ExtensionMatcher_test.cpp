@@ -0,0 +1,79 @@
+#include <list>
+#include <gtest/gtest.h>
+#include <less/lessstylesheet/ExtensionMatcher.h>
+
+class ExtensionMatcherTest : public ::testing::Test {
+public:
+  std::list<Extension> extensions;
+
+  /**
+   * Builds a selector of class names; ' ' and '>' become combinators.
+   */
+  Selector parse(const std::string& str) {
+    Selector s;
+    std::string::const_iterator it;
+
+    s.push_back(TokenList());
+    for (it = str.begin(); it != str.end(); it++) {
+      if (*it == ',') {
+        s.push_back(TokenList());
+      } else if (*it == ' ') {
+        s.back().push_back(Token::BUILTIN_SPACE);
+      } else if (*it == '>') {
+        s.back().push_back(Token(">", Token::OTHER, 0, 0));
+      } else {
+        s.back().push_back(Token(".", Token::OTHER, 0, 0));
+        s.back().push_back(
+            Token(std::string(1, *it), Token::IDENTIFIER, 0, 0));
+      }
+    }
+    return s;
+  }
+
+  void addExtension(const std::string& target,
+                    const std::string& extension,
+                    bool all) {
+    extensions.push_back(Extension());
+    extensions.back().getTarget() = parse(target);
+    extensions.back().setExtension(parse(extension));
+    extensions.back().setAll(all);
+  }
+
+  /**
+   * Applies the extensions one at a time, the way the matcher has to
+   * reproduce.
+   */
+  Selector applyEach(Selector s) {
+    std::list<Extension>::const_iterator it;
+
+    for (it = extensions.begin(); it != extensions.end(); it++)
+      (*it).updateSelector(s);
+    return s;
+  }
+};
+
+TEST_F(ExtensionMatcherTest, SameAsEachExtension) {
+  const char* selectors[] = {"a", "a b", "b>c", "a,b c", "d", "c a b"};
+  Selector s;
+  size_t i;
+
+  addExtension("a", "x", true);
+  addExtension("b c", "y", false);
+  // Only matches the selectors that the first extension adds.
+  addExtension("x", "z,w", true);
+  addExtension("b>c", "v", false);
+  addExtension("q", "r", true);
+
+  ExtensionMatcher matcher(extensions);
+
+  for (i = 0; i < sizeof(selectors) / sizeof(selectors[0]); i++) {
+    s = parse(selectors[i]);
+    matcher.updateSelector(s);
+    EXPECT_EQ(applyEach(parse(selectors[i])).toString(), s.toString());
+  }
+
+  s = parse("c a b");
+  matcher.updateSelector(s);
+  EXPECT_STREQ(".c .a .b, .c .x .b, .c .z .b, .c .w .b",
+               s.toString().c_str());
+}
@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <less/SourceRegistry.h>
+#include <less/less/ImportResolver.h>
+
+/**
+ * The directory of the importing file is tried before the include
+ * paths, and both routes to a file have the same canonical path.
+ */
+TEST(ImportResolverTest, Resolve) {
+  std::list<const char*> includePaths;
+  std::string filename, path;
+
+  mkdir("ImportResolver_test", 0755);
+  std::ofstream("ImportResolver_test/a.less") << "a {}";
+  std::ofstream("ImportResolver_b.less") << "b {}";
+  includePaths.push_back("ImportResolver_test/");
+  includePaths.push_back("");
+
+  ImportResolver resolver(&includePaths);
+
+  EXPECT_TRUE(resolver.resolve("", "a.less", filename, path));
+  EXPECT_EQ("ImportResolver_test/a.less", filename);
+  EXPECT_EQ(SourceRegistry::canonicalPath("ImportResolver_test/a.less"),
+            path);
+
+  EXPECT_TRUE(
+      resolver.resolve("ImportResolver_test/", "a.less", filename, path));
+  EXPECT_EQ(SourceRegistry::canonicalPath("ImportResolver_test/a.less"),
+            path);
+
+  EXPECT_TRUE(resolver.resolve(
+      "ImportResolver_test/", "ImportResolver_b.less", filename, path));
+  EXPECT_EQ("ImportResolver_b.less", filename);
+
+  // Directories are not files.
+  EXPECT_FALSE(resolver.resolve("", "ImportResolver_test", filename, path));
+
+  std::remove("ImportResolver_test/a.less");
+  std::remove("ImportResolver_b.less");
+  rmdir("ImportResolver_test");
+}
+
+/**
+ * Lookups are cached, including the ones that found nothing.
+ */
+TEST(ImportResolverTest, Cache) {
+  const char* name = "ImportResolver_c.less";
+  std::string filename, path;
+  ImportResolver resolver(NULL);
+
+  EXPECT_FALSE(resolver.resolve("", name, filename, path));
+  std::ofstream(name) << "c {}";
+  EXPECT_FALSE(resolver.resolve("", name, filename, path));
+
+  ImportResolver fresh(NULL);
+  EXPECT_TRUE(fresh.resolve("", name, filename, path));
+  std::remove(name);
+  EXPECT_TRUE(fresh.resolve("", name, filename, path));
+}
@@ -1,5 +1,8 @@
+#include <cstdio>
+#include <fstream>
 #include <list>
 #include <gtest/gtest.h>
+#include <less/less/ImportPipeline.h>
 #include <less/less/LessParser.h>
 #include <less/lessstylesheet/MixinException.h>
 
@@ -7,7 +10,7 @@ class LessParserTest : public ::testing::Test {
 public:
   istringstream* in;
   LessTokenizer* t;
-  std::list<const char*>* sources;
+  SourceSet* sources;
   LessParser* p;
 
   LessStylesheet* less;
@@ -20,7 +23,7 @@ public:
   virtual void SetUp() {
     in = new istringstream(" ");
     t = new LessTokenizer(*in, "test");
-    sources = new std::list<const char*>;
+    sources = new SourceSet();
     p = new LessParser(*t, *sources);
 
     less = new LessStylesheet();
@@ -373,8 +376,162 @@ TEST_F(LessParserTest, Import) {
   LessStylesheet stylesheet;
 
   p->parseStylesheet(stylesheet);
-} 
+}
 */
+
+TEST_F(LessParserTest, Merge) {
+  istringstream in2("@color: blue; \
+.a { color: @color; .m; } \
+@media print { .b { .m; } }");
+  LessTokenizer t2(in2, "test2");
+  LessParser p2(t2, *sources);
+  LessStylesheet imported;
+
+  in->str("@color: red; .m { margin: 0; }");
+
+  p->parseStylesheet(*less);
+  p2.parseStylesheet(imported);
+  less->merge(imported);
+
+  ASSERT_TRUE(imported.getStatements().empty());
+
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".m{margin:0}.a{color:blue;margin:0}\
+@media print{.b{margin:0}}", out->str().c_str());
+}
+/**
+ * The kind of each statement in a ruleset is decided once it has been
+ * read, also after a nested ruleset that used statements of its own.
+ */
+TEST_F(LessParserTest, StatementKinds) {
+  in->str(".m() { margin: 0; } \
+.x { y: z; } \
+a { \
+  b:hover { c: d; } \
+  &:extend(.x); \
+  *zoom: 1; \
+  e+_: f; \
+  e+_: g; \
+  .m() !important; \
+  h: i; \
+}");
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".x,a{y:z}a{*zoom:1;e:f g;margin:0 !important;h:i}\
+a b:hover{c:d}", out->str().c_str());
+}
+
+/**
+ * Every statement of a file imported into a ruleset is kept, including
+ * the first and those after an empty statement.
+ */
+TEST_F(LessParserTest, ImportIntoRuleset) {
+  std::ofstream("LessParser_test_import.less") << ".b { c: d; }\n"
+                                                   ";\n"
+                                                   ".e { f: g; }";
+  in->str("a { @import \"LessParser_test_import\"; }");
+
+  p->parseStylesheet(*less);
+  std::remove("LessParser_test_import.less");
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ("a .b{c:d}a .e{f:g}", out->str().c_str());
+}
+
+/**
+ * Empty statements in a file imported into a ruleset are skipped, and
+ * the declarations, rulesets and variables after them are kept.
+ */
+TEST_F(LessParserTest, ImportIntoRulesetEmptyStatement) {
+  std::ofstream("LessParser_test_import.less") << "c: d;\n"
+                                                   ";\n"
+                                                   "@v: h;\n"
+                                                   ";;\n"
+                                                   "e: f;\n"
+                                                   ".g { i: @v; }\n"
+                                                   ";";
+  in->str("a { @import \"LessParser_test_import\"; j: k; }");
+
+  p->parseStylesheet(*less);
+  std::remove("LessParser_test_import.less");
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ("a{c:d;e:f;j:k}a .g{i:h}", out->str().c_str());
+}
+
+/**
+ * A file imported into a ruleset that does not end where its statements
+ * end is an error, as it is at the top level.
+ */
+TEST_F(LessParserTest, ImportIntoRulesetError) {
+  std::ofstream("LessParser_test_import.less") << ".b { c: d; }\n"
+                                                   "}\n"
+                                                   ".e { f: g; }";
+  in->str("a { @import \"LessParser_test_import\"; }");
+
+  EXPECT_THROW(p->parseStylesheet(*less), ParseException*);
+  std::remove("LessParser_test_import.less");
+}
+
+/**
+ * The blocks of rulesets in a file imported with (reference) are only
+ * parsed when a mixin call uses them.
+ */
+TEST_F(LessParserTest, ReferenceImport) {
+  std::ofstream("LessParser_test_reference.less") << ".a { b: c; }\n"
+                                                      ".d { e: f;; g }";
+  in->str("@import (reference) \"LessParser_test_reference\";\n"
+          ".h { .a; }");
+
+  p->parseStylesheet(*less);
+  std::remove("LessParser_test_reference.less");
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".h{b:c}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, ReferenceImportError) {
+  std::ofstream("LessParser_test_reference.less") << ".a { b: c; }\n"
+                                                      ".d { e: f;; g }";
+  in->str("@import (reference) \"LessParser_test_reference\";\n"
+          ".h { .d; }");
+
+  p->parseStylesheet(*less);
+  std::remove("LessParser_test_reference.less");
+  EXPECT_THROW(less->process(*css, context), ParseException*);
+}
+
+/**
+ * A source that is split into chunks parses into the same stylesheet,
+ * with variables and mixins used across chunks.
+ */
+TEST_F(LessParserTest, SplitInput) {
+  std::istringstream source("@v: 1; \
+.m() { m: @v; } \
+a { b: @v; .m; } \
+@v: 2; \
+@media print { c { d: @v; } } \
+e { .m; }");
+  SourceBuffer* buffer = new SourceBuffer(source);
+  std::list<const char*> includePaths;
+  ImportResolver resolver(&includePaths);
+  ImportPipeline pipeline(resolver, 3);
+
+  while (buffer->fill()) {
+  }
+  LessTokenizer t2(buffer, "split");
+  LessParser p2(t2, *sources);
+  p2.pipeline = &pipeline;
+  p2.splitSize = 1;
+
+  p2.parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ("a{b:2;m:2}@media print{c{d:2}}e{m:2}", out->str().c_str());
+}
+
 TEST_F(LessParserTest, UrlInterpolation) {
   in->str("@base-url: \"http://assets.fnord.com\"; \
 .class { \
@@ -1096,3 +1253,75 @@ TEST_F(LessParserTest, ExtendNestedMedia) {
 {.selector{color:blue}}", out->str().c_str());
 }
 
+
+TEST_F(LessParserTest, MixinNamespace) {
+  in->str("#ns { .m() { c: d; } .n { e: f; } } \
+.x { #ns > .m(); } \
+.y { #ns.m(); } \
+.z { #ns .n; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ("#ns .n{e:f}.x{c:d}.y{c:d}.z{e:f}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinNamespaceSelectorList) {
+  in->str(".a, #b > .c { .m { c: d; } } \
+.x { .a.m; } \
+.y { #b > .c > .m; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".a .m,#b > .c .m{c:d}.x{c:d}.y{c:d}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, VariableReturnedFromMixin) {
+  in->str("@v: 1; \
+.m() { @v: 2; @w: 3; } \
+.a { x: @v; .m(); y: @v; z: @w; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".a{x:1;y:2;z:3}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, ComputedVariableInScopes) {
+  in->str("@b: 1px; \
+@v: @b * 2; \
+.a { x: @v; } \
+.m(@b) { x: @v; } \
+.c { .m(3px); } \
+.d { @b: 4px; x: @v; } \
+.e { x: @v; y: @v @v; } \
+@b: 5px;");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".a{x:10px}.c{x:6px}.d{x:8px}.e{x:10px;y:10px 10px}",
+               out->str().c_str());
+}
+
+/**
+ * Values and guards are parsed on the first call and reused by the
+ * next ones; values the parsed form can not evaluate are interpreted.
+ */
+TEST_F(LessParserTest, ReusedExpressions) {
+  in->str("@l: 1px 2px; \
+.m(@a) when (@a > 1) and (iscolor(#fff)) { \
+w: (@a * 2px) + 4px / 2; \
+c: darken(#336699, 5% + 5%); \
+l: @l + 1; } \
+.m(@a) when (default()) { d: @a; } \
+.a { .m(1); .m(2); .m(3); u: @undefined; }");
+
+  p->parseStylesheet(*less);
+  less->process(*css, context);
+  css->write(*writer);
+  ASSERT_STREQ(".a{d:1;w:6px;c:#264d73;l:1px 2px + 1;\
+w:8px;c:#264d73;l:1px 2px + 1;u:@undefined}",
+               out->str().c_str());
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <less/SourceSet.h>
+#include <less/css/CssTokenizer.h>
+
+/**
+ * Line and column are computed from the offset of a token.
+ */
+TEST(SourceSetTest, Location) {
+  unsigned int line, column;
+  istringstream in("ab\ncd\n\nef");
+  CssTokenizer t(in, "location.less");
+  unsigned int id = t.getSourceId();
+
+  while (t.readNextToken() != Token::EOS) {
+  }
+
+  SourceRegistry::getLocation(id, 0, line, column);
+  EXPECT_EQ(0u, line);
+  EXPECT_EQ(0u, column);
+  SourceRegistry::getLocation(id, 4, line, column);
+  EXPECT_EQ(1u, line);
+  EXPECT_EQ(1u, column);
+  SourceRegistry::getLocation(id, 8, line, column);
+  EXPECT_EQ(3u, line);
+  EXPECT_EQ(1u, column);
+  EXPECT_STREQ("location.less", SourceRegistry::getName(id));
+}
+
+/**
+ * Files are identified by their canonical path.
+ */
+TEST(SourceSetTest, CanonicalPath) {
+  const char* filename = "SourceSet_test.less";
+  std::ofstream(filename) << "a {}";
+  SourceSet sources;
+  unsigned int a = SourceRegistry::add(filename, NULL),
+               b = SourceRegistry::add("./SourceSet_test.less", NULL);
+
+  EXPECT_FALSE(sources.contains(filename));
+  EXPECT_EQ(0u, sources.add(a));
+  EXPECT_TRUE(sources.contains("./SourceSet_test.less"));
+  EXPECT_EQ(0u, sources.add(b));
+  EXPECT_EQ(1u, sources.size());
+  EXPECT_EQ(0u, sources.indexOf(b));
+  EXPECT_EQ(1u, sources.indexOf(SourceRegistry::GENERATED));
+  EXPECT_STREQ(filename, sources.getName(0));
+
+  std::remove(filename);
+}
+
+/**
+ * A released source no longer has content, so its tokens are reported
+ * on line 0.
+ */
+TEST(SourceSetTest, Release) {
+  unsigned int line, column;
+  istringstream in("ab\ncd");
+  CssTokenizer t(in, "release.less");
+  SourceSet sources;
+  unsigned int id = t.getSourceId();
+
+  while (t.readNextToken() != Token::EOS) {
+  }
+  sources.add(id);
+
+  SourceRegistry::getLocation(id, 4, line, column);
+  EXPECT_EQ(1u, line);
+
+  sources.release();
+  EXPECT_FALSE(SourceRegistry::hasContent(id));
+  SourceRegistry::getLocation(id, 4, line, column);
+  EXPECT_EQ(0u, line);
+  EXPECT_EQ(4u, column);
+  EXPECT_STREQ("release.less", SourceRegistry::getName(id));
+}
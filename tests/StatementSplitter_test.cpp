@@ -0,0 +1,70 @@
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+#include <less/less/StatementSplitter.h>
+
+class StatementSplitterTest : public ::testing::Test {
+public:
+  std::vector<size_t> offsets;
+
+  bool split(const char* data, unsigned int chunks) {
+    return StatementSplitter::split(data, std::strlen(data), chunks, 1,
+                                    offsets);
+  }
+};
+
+TEST_F(StatementSplitterTest, Statements) {
+  const char* data = "a { b: c; }\nd { e: f; }\n@v: 1;\n.m();\n";
+
+  ASSERT_TRUE(split(data, 4));
+  ASSERT_EQ(5u, offsets.size());
+  EXPECT_EQ(0u, offsets[0]);
+  EXPECT_EQ(11u, offsets[1]);
+  EXPECT_EQ(23u, offsets[2]);
+  EXPECT_EQ(30u, offsets[3]);
+  EXPECT_EQ(std::strlen(data), offsets[4]);
+}
+
+/**
+ * Only the ends of statements are boundaries, not the characters that
+ * look like them in strings, comments, urls, variables in selectors,
+ * parentheses or nested blocks.
+ */
+TEST_F(StatementSplitterTest, Hidden) {
+  const char* data =
+      "a { b: \"};\"; c: url(x;}.png); d: '\\';'; }\n"
+      "/* }; */ // };\n"
+      "@{s}-x { e { f: g; } }\n"
+      ".m(@a; { h: i; });\n";
+
+  ASSERT_TRUE(split(data, 10));
+  ASSERT_EQ(5u, offsets.size());
+  EXPECT_EQ(41u, offsets[1]);
+  EXPECT_EQ(79u, offsets[2]);
+  EXPECT_EQ(98u, offsets[3]);
+}
+
+TEST_F(StatementSplitterTest, DetachedRuleset) {
+  ASSERT_TRUE(split("@r: { a: b; } ;\nc { d: e; }", 3));
+  ASSERT_EQ(3u, offsets.size());
+  EXPECT_EQ(15u, offsets[1]);
+}
+
+TEST_F(StatementSplitterTest, Size) {
+  const char* data = "a { b: c; }\nd { e: f; }\ng { h: i; }\n";
+
+  EXPECT_FALSE(split("a { b: c; }", 2));
+  EXPECT_FALSE(StatementSplitter::split(data, std::strlen(data), 2, 20,
+                                        offsets));
+  ASSERT_TRUE(StatementSplitter::split(data, std::strlen(data), 2, 10,
+                                       offsets));
+  ASSERT_EQ(3u, offsets.size());
+  EXPECT_EQ(23u, offsets[1]);
+}
+
+TEST_F(StatementSplitterTest, Ambiguous) {
+  EXPECT_FALSE(split("a { b: \"c\n\"; }\nd { e: f; }", 2));
+  EXPECT_FALSE(split("a { b: c; } /* d { e: f; }", 2));
+  EXPECT_FALSE(split("} a { b: c; }\nd { e: f; }", 2));
+  EXPECT_FALSE(split("a { b: url(c\"d); }\ne { f: g; }", 2));
+}
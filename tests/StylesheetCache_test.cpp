@@ -0,0 +1,245 @@
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <less/SourceSet.h>
+#include <less/css/CssWriter.h>
+#include <less/less/LessParser.h>
+#include <less/less/ReferenceRuleset.h>
+#include <less/less/StylesheetCache.h>
+
+class StylesheetCacheTest : public ::testing::Test {
+public:
+  const char* filename;
+  SourceBuffer* buffer;
+  ImportedFile* parsed;
+
+  virtual void SetUp() {
+    filename = "StylesheetCache_test.less";
+    std::ofstream(filename) << "@import (reference) \"lib.less\";\n\
+@a: 1px;\n\
+/* comment */\n\
+.m(@x; @y: 2) when (@x > 0) {\n\
+  width: @x;\n\
+  .n { height: @y; }\n\
+  @media print { margin: @a; }\n\
+}\n\
+.b:extend(.c all) { color: red; &:extend(.d); @v: 3; .m(1; @y: 4) !important; }\n\
+;\n\
+@media screen { .e { f: @a; } }\n\
+@font-face { font-family: x; }\n";
+
+    buffer = new SourceBuffer();
+    ASSERT_TRUE(buffer->open(filename));
+
+    SourceSet sources;
+    LessTokenizer t(buffer, filename);
+    LessParser p(t, sources);
+
+    parsed = new ImportedFile(NULL);
+    parsed->sourceId = t.getSourceId();
+    p.parseStylesheet(*parsed);
+    ASSERT_FALSE(parsed->error);
+  }
+
+  virtual void TearDown() {
+    delete parsed;
+    std::remove(filename);
+  }
+
+  /**
+   * The CSS of the statements of file, as if the import was empty.
+   * The statements are moved out of file.
+   */
+  std::string compile(ImportedFile& file) {
+    LessStylesheet less;
+    Stylesheet css;
+    ProcessingContext context;
+    std::ostringstream out;
+    CssWriter writer(out);
+    size_t i;
+
+    for (i = 0; i < file.segments.size(); i++)
+      less.merge(*file.segments[i]);
+    less.process(css, &context);
+    css.write(writer);
+    return out.str();
+  }
+
+  /**
+   * Contents of the only entry in directory, which is removed.
+   */
+  std::string takeEntry(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    struct dirent* e;
+    std::string name, content;
+
+    while ((e = readdir(dir)) != NULL) {
+      if (e->d_name[0] != '.')
+        name = directory + "/" + e->d_name;
+    }
+    closedir(dir);
+
+    std::ifstream in(name.c_str(), std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(name.c_str());
+    rmdir(directory.c_str());
+    return content;
+  }
+};
+
+/**
+ * A loaded file gives the same CSS, and stores to the same bytes, as
+ * the parsed file.
+ */
+TEST_F(StylesheetCacheTest, RoundTrip) {
+  StylesheetCache cache("StylesheetCache_test.a");
+  StylesheetCache copy("StylesheetCache_test.b");
+  ImportedFile loaded(NULL);
+
+  cache.store(*buffer, false, *parsed);
+  loaded.sourceId = parsed->sourceId;
+  ASSERT_TRUE(cache.load(*buffer, false, loaded));
+
+  ASSERT_EQ(2u, loaded.segments.size());
+  ASSERT_EQ(1u, loaded.imports.size());
+  EXPECT_EQ(parsed->imports[0].uri, loaded.imports[0].uri);
+  EXPECT_EQ(parsed->imports[0].directive, loaded.imports[0].directive);
+  EXPECT_EQ(parsed->imports[0].uri.getLine(),
+            loaded.imports[0].uri.getLine());
+  ASSERT_EQ(1u, loaded.warnings.size());
+  EXPECT_EQ(1u, loaded.warnings[0].segment);
+  EXPECT_EQ(9u, loaded.warnings[0].token.getLine());
+
+  copy.store(*buffer, false, loaded);
+  EXPECT_EQ(takeEntry("StylesheetCache_test.a"),
+            takeEntry("StylesheetCache_test.b"));
+
+  std::string css = compile(*parsed);
+  EXPECT_NE(std::string::npos, css.find("@font-face"));
+  EXPECT_EQ(css, compile(loaded));
+}
+
+/**
+ * Entries are not used for other content or another reference
+ * directive.
+ */
+TEST_F(StylesheetCacheTest, Miss) {
+  StylesheetCache cache("StylesheetCache_test.c");
+  ImportedFile loaded(NULL);
+  std::istringstream in("a { b: c; }");
+  SourceBuffer other(in);
+
+  other.fill();
+  EXPECT_FALSE(cache.load(*buffer, false, loaded));
+  cache.store(*buffer, false, *parsed);
+  EXPECT_FALSE(cache.load(*buffer, true, loaded));
+  EXPECT_FALSE(cache.load(other, false, loaded));
+  EXPECT_TRUE(loaded.segments.empty());
+
+  takeEntry("StylesheetCache_test.c");
+}
+
+/**
+ * The blocks of reference rulesets are stored as their location and
+ * parsed from the file when a mixin call needs them.
+ */
+TEST_F(StylesheetCacheTest, Reference) {
+  StylesheetCache cache("StylesheetCache_test.d");
+  SourceBuffer* content = new SourceBuffer();
+  ImportedFile reference(NULL), loaded(NULL);
+  std::istringstream in(".x { .m(1); }");
+  LessStylesheet less;
+  Stylesheet css;
+  ProcessingContext context;
+  std::ostringstream out;
+  CssWriter writer(out);
+  SourceSet sources;
+  const ReferenceRuleset* ruleset = NULL;
+  std::list<StylesheetStatement*>::const_iterator it;
+
+  ASSERT_TRUE(content->open(filename));
+  {
+    LessTokenizer t(content, filename);
+    LessParser p(t, sources, true);
+
+    reference.sourceId = loaded.sourceId = t.getSourceId();
+    p.parseStylesheet(reference);
+    ASSERT_FALSE(reference.error);
+  }
+  cache.store(*content, true, reference);
+  ASSERT_TRUE(cache.load(*content, true, loaded));
+  takeEntry("StylesheetCache_test.d");
+
+  ASSERT_EQ(2u, loaded.segments.size());
+  for (it = loaded.segments[1]->getStatements().begin();
+       it != loaded.segments[1]->getStatements().end() && ruleset == NULL;
+       it++) {
+    ruleset = dynamic_cast<const ReferenceRuleset*>(*it);
+  }
+  ASSERT_TRUE(ruleset != NULL);
+  EXPECT_FALSE(ruleset->isLoaded());
+
+  less.merge(*loaded.segments[1]);
+  LessTokenizer t(in, "-");
+  LessParser p(t, sources);
+  p.parseStylesheet(less);
+  less.process(css, &context);
+  css.write(writer);
+
+  EXPECT_TRUE(ruleset->isLoaded());
+  EXPECT_NE(std::string::npos, out.str().find(".x{width:1}"));
+}
+
+/**
+ * A snapshot gives the same CSS as the stylesheet it was made from,
+ * with the tokens still located in the original file.
+ */
+TEST_F(StylesheetCacheTest, Snapshot) {
+  const char* lib = "StylesheetCache_test.lib.less";
+  const char* snapshot = "StylesheetCache_test.snap";
+  SourceBuffer* content = new SourceBuffer();
+  LessStylesheet less, loaded;
+  SourceSet sources, loadedSources;
+  ImportedFile library(NULL), copy(NULL);
+  const TokenList* a;
+
+  std::ofstream(lib) << "/* library */\n\
+@a: 1px;\n\
+.m(@x: @a) when (ispixel(@x)) { width: @x; }\n\
+.b { .m(2px); }\n";
+  ASSERT_TRUE(content->open(lib));
+  {
+    LessTokenizer t(content, lib);
+    LessParser p(t, sources);
+
+    sources.add(t.getSourceId());
+    p.parseStylesheet(less);
+  }
+  ASSERT_TRUE(StylesheetCache::writeSnapshot(snapshot, less, sources));
+  StylesheetCache::readSnapshot(snapshot, loaded, loadedSources);
+
+  ASSERT_EQ(1u, loadedSources.size());
+  EXPECT_TRUE(loadedSources.contains(lib));
+  a = loaded.getVariable("@a");
+  ASSERT_TRUE(a != NULL);
+  EXPECT_EQ(1u, a->front().getLine());
+  EXPECT_EQ(4u, a->front().getColumn());
+
+  library.segments.push_back(new LessStylesheet());
+  library.segments.back()->merge(less);
+  copy.segments.push_back(new LessStylesheet());
+  copy.segments.back()->merge(loaded);
+  EXPECT_EQ(compile(library), compile(copy));
+
+  // Changing the file makes the snapshot unusable.
+  std::ofstream(lib, std::ios::app) << ".f { g: h; }\n";
+  EXPECT_THROW(StylesheetCache::readSnapshot(snapshot, loaded, loadedSources),
+               IOException*);
+  std::remove(snapshot);
+  std::remove(lib);
+}
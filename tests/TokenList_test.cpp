@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <utility>
+#include <gtest/gtest.h>
+#include <less/TokenList.h>
+#include <less/TokenMatcher.h>
+#include <less/stylesheet/Selector.h>
+
+class TokenListTest : public ::testing::Test {
+public:
+  Token a, b, c, space;
+
+  virtual void SetUp() {
+    a = Token("a", Token::IDENTIFIER, SourceRegistry::GENERATED, 0);
+    b = Token("b", Token::IDENTIFIER, SourceRegistry::GENERATED, 0);
+    c = Token("c", Token::IDENTIFIER, SourceRegistry::GENERATED, 0);
+    space = Token::BUILTIN_SPACE;
+  }
+};
+
+/**
+ * Tokens keep their order when the list moves from inline to heap
+ * storage.
+ */
+TEST_F(TokenListTest, Grow) {
+  TokenList tokens;
+  TokenList::iterator it;
+
+  tokens.push_back(b);
+  tokens.push_back(c);
+  tokens.push_front(a);
+  tokens.insert(tokens.end(), tokens.begin(), tokens.end());
+  ASSERT_STREQ("abcabc", tokens.toString().c_str());
+
+  it = tokens.erase(tokens.begin() + 1, tokens.begin() + 4);
+  EXPECT_EQ("b", *it);
+  ASSERT_STREQ("abc", tokens.toString().c_str());
+
+  it = tokens.insert(tokens.begin() + 1, c);
+  EXPECT_EQ("c", *it);
+  tokens.pop_front();
+  ASSERT_STREQ("cbc", tokens.toString().c_str());
+}
+
+TEST_F(TokenListTest, CopyAndMove) {
+  TokenList tokens, copy, moved;
+
+  tokens.push_back(a);
+  tokens.push_back(b);
+  tokens.push_back(c);
+
+  copy = tokens;
+  moved = std::move(tokens);
+  EXPECT_TRUE(tokens.empty());
+  EXPECT_TRUE(copy == moved);
+
+  tokens.push_back(a);
+  moved = std::move(tokens);
+  ASSERT_STREQ("a", moved.toString().c_str());
+  EXPECT_TRUE(moved < copy);
+
+  copy.swap(moved);
+  ASSERT_STREQ("a", copy.toString().c_str());
+  ASSERT_STREQ("abc", moved.toString().c_str());
+}
+
+TEST_F(TokenListTest, Trim) {
+  TokenList tokens;
+
+  tokens.push_back(space);
+  tokens.push_back(space);
+  tokens.push_back(a);
+  tokens.push_back(space);
+  tokens.trim();
+  ASSERT_EQ(1u, tokens.size());
+  EXPECT_EQ("a", tokens.front());
+
+  tokens.clear();
+  tokens.push_back(space);
+  tokens.trim();
+  EXPECT_TRUE(tokens.empty());
+}
+
+/**
+ * find() returns the end of the match and moves offset to its start,
+ * or returns begin() if there is no match.
+ */
+TEST_F(TokenListTest, FindList) {
+  TokenList tokens, search;
+  TokenList::const_iterator offset, it;
+
+  tokens.push_back(a);
+  tokens.push_back(b);
+  tokens.push_back(a);
+  tokens.push_back(c);
+  search.push_back(a);
+  search.push_back(c);
+
+  offset = tokens.begin();
+  it = tokens.find(search, offset);
+  EXPECT_EQ(tokens.begin() + 2, offset);
+  EXPECT_EQ(tokens.end(), it);
+
+  search.push_back(b);
+  offset = tokens.begin();
+  EXPECT_EQ(tokens.begin(), tokens.find(search, offset));
+}
+
+/**
+ * Selectors added by replace() are searched as well.
+ */
+TEST_F(TokenListTest, SelectorReplace) {
+  Selector selector;
+  TokenList search, replace;
+
+  selector.push_back(TokenList());
+  selector.back().push_back(a);
+  selector.back().push_back(space);
+  selector.back().push_back(b);
+  search.push_back(a);
+  replace.push_back(c);
+
+  ASSERT_TRUE(selector.replace(search, replace));
+  ASSERT_EQ(2u, selector.size());
+  EXPECT_STREQ("a b, c b", selector.toString().c_str());
+
+  search.back() = b;
+  replace.back() = a;
+  ASSERT_TRUE(selector.replace(search, replace));
+  EXPECT_STREQ("a b, c b, a a, c a", selector.toString().c_str());
+}
+
+/**
+ * Identifiers compare by atom, and changing the string drops the atom.
+ */
+TEST_F(TokenListTest, Atoms) {
+  Token a2("a", Token::IDENTIFIER, SourceRegistry::BUILTIN, 5);
+
+  EXPECT_TRUE(a == a2);
+  EXPECT_NE(AtomTable::NONE, a.getAtom());
+  EXPECT_EQ(a.getAtom(), a2.getAtom());
+  EXPECT_STREQ("a", AtomTable::getString(a.getAtom()).c_str());
+
+  a2.append("b");
+  EXPECT_FALSE(a == a2);
+  EXPECT_STREQ("ab", AtomTable::getString(a2.getAtom()).c_str());
+
+  a2.assign("b");
+  EXPECT_TRUE(a2 == b);
+  EXPECT_FALSE(a2 < b || b < a2);
+
+  a2.type = Token::STRING;
+  EXPECT_EQ(AtomTable::NONE, Token("b", Token::STRING, 0, 0).getAtom());
+  EXPECT_FALSE(a2 == b);
+}
+
+/**
+ * Writing to the characters of a token, in place or through an
+ * iterator, drops the atom too.
+ */
+TEST_F(TokenListTest, AtomsInPlace) {
+  Token a2("a", Token::IDENTIFIER, SourceRegistry::BUILTIN, 0);
+
+  ASSERT_TRUE(a2 == a);
+  a2.at(0) = 'b';
+  EXPECT_TRUE(a2 == b);
+
+  *a2.begin() = 'c';
+  EXPECT_TRUE(a2 == c);
+
+  a2.back() = 'a';
+  EXPECT_TRUE(a2 == a);
+  EXPECT_EQ(a.hash(), a2.hash());
+}
+
+/**
+ * Once the AtomTable is full a new identifier has no atom until a
+ * variable interns it, and its hash must not change when it does.
+ */
+TEST_F(TokenListTest, HashWithoutAtom) {
+  Token t("@hash-without-atom", Token::ATKEYWORD, SourceRegistry::BUILTIN, 0);
+  char name[32];
+  size_t h, i;
+
+  for (i = 0; AtomTable::size() < AtomTable::TOKEN_LIMIT; i++) {
+    sprintf(name, "atom-table-filler-%lu", (unsigned long)i);
+    AtomTable::intern(name);
+  }
+  EXPECT_EQ(AtomTable::NONE, t.getAtom());
+  h = t.hash();
+
+  AtomTable::intern(t);
+  EXPECT_NE(AtomTable::NONE, t.getAtom());
+  EXPECT_EQ(h, t.hash());
+}
+
+TEST_F(TokenListTest, Hash) {
+  TokenList l1, l2;
+
+  l1.push_back(a);
+  l1.push_back(space);
+  l1.push_back(Token("\"s\"", Token::STRING, SourceRegistry::BUILTIN, 0));
+  l2 = l1;
+  l2.back().removeQuotes();
+  l2.back().insert(0, "\"");
+  l2.back().append("\"");
+
+  EXPECT_TRUE(l1 == l2);
+  EXPECT_EQ(l1.hash(), l2.hash());
+  l2.pop_back();
+  EXPECT_FALSE(l1 == l2);
+}
+
+/**
+ * The matcher falls back to the longest border of a partial match
+ * instead of restarting at the next token.
+ */
+TEST_F(TokenListTest, Matcher) {
+  TokenList tokens, search;
+  TokenList::const_iterator offset, it;
+
+  // a a b a a a b
+  tokens.push_back(a);
+  tokens.push_back(a);
+  tokens.push_back(b);
+  tokens.push_back(a);
+  tokens.push_back(a);
+  tokens.push_back(a);
+  tokens.push_back(b);
+  search.push_back(a);
+  search.push_back(a);
+  search.push_back(b);
+
+  TokenMatcher matcher(search);
+
+  offset = tokens.begin();
+  it = matcher.find(tokens, offset);
+  EXPECT_EQ(tokens.begin(), offset);
+  EXPECT_EQ(tokens.begin() + 3, it);
+
+  offset = it;
+  it = matcher.find(tokens, offset);
+  EXPECT_EQ(tokens.begin() + 4, offset);
+  EXPECT_EQ(tokens.end(), it);
+
+  offset = it;
+  EXPECT_EQ(tokens.begin(), matcher.find(tokens, offset));
+  offset = tokens.begin();
+  EXPECT_EQ(tokens.begin(), TokenMatcher(TokenList()).find(tokens, offset));
+}
@@ -1099,3 +1099,28 @@ TEST(ValueProcessorTest, IsUnit) {
 - `average`: no
 - `negation`: no
 */
+
+/**
+ * Only a limited number of parsed values is kept; values after that
+ * are still processed.
+ */
+TEST(ValueProcessorTest, ManyValues) {
+  TokenList l;
+  ValueProcessor vp;
+  ProcessingContext c;
+  char n[16];
+  unsigned int i;
+
+  for (i = 0; i < 20000; i++) {
+    sprintf(n, "%u", i);
+    l.clear();
+    l.push_back(Token(n, Token::NUMBER, 0, 0, "-"));
+    l.push_back(Token("+", Token::DELIMITER, 0, 0, "-"));
+    l.push_back(Token("1", Token::NUMBER, 0, 0, "-"));
+    vp.processValue(l, c);
+
+    sprintf(n, "%u", i + 1);
+    ASSERT_EQ((uint)1, l.size());
+    ASSERT_STREQ(n, l.front().c_str());
+  }
+}